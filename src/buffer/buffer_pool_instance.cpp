@@ -0,0 +1,493 @@
+#include "buffer/buffer_pool_instance.h"
+
+#include <sys/mman.h>
+
+#include <cerrno>
+#include <cstring>
+#include <new>
+
+#include "glog/logging.h"
+
+BufferPoolInstance::BufferPoolInstance(size_t pool_size, DiskManager *disk_manager, ReplacerType replacer_type,
+                                       bool huge_pages)
+    : pool_size_(pool_size), disk_manager_(disk_manager) {
+  // one block holds the frames of every page, each of the page size of the database
+  size_t page_size = disk_manager_->GetPageSize();
+  AllocateFrames(pool_size_ * page_size, huge_pages);
+  pages_ = static_cast<Page *>(::operator new[](pool_size_ * sizeof(Page)));
+  for (size_t i = 0; i < pool_size_; i++) {
+    new (&pages_[i]) Page(frames_ + i * page_size, page_size);
+  }
+  switch (replacer_type) {
+    case ReplacerType::CLOCK:
+      replacer_ = new CLOCKReplacer(pool_size_);
+      break;
+    case ReplacerType::LRU_K:
+      replacer_ = new LRUKReplacer(pool_size_);
+      break;
+    default:
+      replacer_ = new LRUReplacer(pool_size_);
+      break;
+  }
+  for (size_t i = 0; i < pool_size_; i++) {
+    free_list_.emplace_back(i);
+  }
+}
+
+BufferPoolInstance::~BufferPoolInstance() {
+  FlushAllPages();
+  for (size_t i = 0; i < pool_size_; i++) {
+    pages_[i].~Page();
+  }
+  ::operator delete[](pages_);
+  munmap(frames_, frames_size_);
+  delete replacer_;
+}
+
+void BufferPoolInstance::AllocateFrames(size_t size, bool huge_pages) {
+  void *frames = MAP_FAILED;
+  if (huge_pages && size >= HUGE_PAGE_SIZE) {
+    // only succeeds if the system has enough huge pages reserved
+    frames_size_ = (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    frames = mmap(nullptr, frames_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+  }
+  huge_page_backed_ = frames != MAP_FAILED;
+  if (frames == MAP_FAILED) {
+    frames_size_ = size;
+    frames = mmap(nullptr, frames_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (frames == MAP_FAILED) {
+      LOG(ERROR) << "Cannot allocate " << size << " bytes of buffer frames: " << strerror(errno);
+      throw std::bad_alloc();
+    }
+    // let transparent huge pages back the frames where the kernel allows it
+    if (huge_pages) {
+      madvise(frames, frames_size_, MADV_HUGEPAGE);
+    }
+  }
+  frames_ = static_cast<char *>(frames);
+}
+
+void BufferPoolInstance::DiscardFrame(frame_id_t frame_id) {
+  Page &p = pages_[frame_id];
+  page_table_.erase(p.page_id_);
+  prefetched_.erase(frame_id);
+  replacer_->Remove(frame_id);
+  p.page_id_ = INVALID_PAGE_ID;
+  p.pin_count_ = 0;
+  p.is_dirty_ = false;
+  free_list_.push_back(frame_id);
+}
+
+bool BufferPoolInstance::FindVictimFrame(frame_id_t *frame_id, std::unique_lock<std::mutex> *lock) {
+  // Note that pages are always found from the free list first.
+  if (!free_list_.empty()) {
+    *frame_id = free_list_.back();
+    free_list_.pop_back();
+    return true;
+  }
+  while (replacer_->Victim(frame_id)) {
+    // A frame being written back is skipped, it returns to the replacer once the write is done.
+    if (flushing_.count(*frame_id) != 0) continue;
+    Page &p = pages_[*frame_id];
+    evictions_.fetch_add(1, std::memory_order_relaxed);
+    page_id_t page_id = p.GetPageId();
+    page_table_.erase(page_id);
+    prefetched_.erase(*frame_id);
+    p.page_id_ = INVALID_PAGE_ID;
+    // If R is dirty, write it back to the disk.
+    if (p.IsDirty()) {
+      WriteBackVictim(*frame_id, page_id, lock);
+    }
+    return true;
+  }
+  return false;
+}
+
+void BufferPoolInstance::WriteBackVictim(frame_id_t frame_id, page_id_t page_id, std::unique_lock<std::mutex> *lock) {
+  Page &p = pages_[frame_id];
+  dirty_evictions_.fetch_add(1, std::memory_order_relaxed);
+  p.is_dirty_ = false;
+  flushing_.insert(frame_id);
+  evicting_.insert(page_id);
+  lock->unlock();
+  disk_manager_->WritePage(page_id, p.GetData());
+  lock->lock();
+  flushing_.erase(frame_id);
+  evicting_.erase(page_id);
+  io_cv_.notify_all();
+}
+
+bool BufferPoolInstance::RecycleRingFrame(BufferAccessStrategy::Ring *ring, frame_id_t *frame_id,
+                                          std::unique_lock<std::mutex> *lock) {
+  if (ring->pages_.size() < ring->capacity_) return false;
+  while (!ring->pages_.empty()) {
+    page_id_t page_id = ring->pages_.front();
+    ring->pages_.pop_front();
+    auto it = page_table_.find(page_id);
+    if (it == page_table_.end()) continue;
+    *frame_id = it->second;
+    Page &p = pages_[*frame_id];
+    if (p.pin_count_ != 0 || flushing_.count(*frame_id) != 0 || loading_.count(*frame_id) != 0) continue;
+    evictions_.fetch_add(1, std::memory_order_relaxed);
+    page_table_.erase(page_id);
+    prefetched_.erase(*frame_id);
+    replacer_->Remove(*frame_id);
+    p.page_id_ = INVALID_PAGE_ID;
+    if (p.IsDirty()) {
+      WriteBackVictim(*frame_id, page_id, lock);
+    }
+    return true;
+  }
+  return false;
+}
+
+void BufferPoolInstance::AddToRing(BufferAccessStrategy::Ring *ring, page_id_t page_id) {
+  if (ring->pages_.size() >= ring->capacity_) ring->pages_.pop_front();
+  ring->pages_.push_back(page_id);
+}
+
+Page *BufferPoolInstance::FetchPage(page_id_t page_id, BufferAccessStrategy::Ring *ring) {
+  std::unique_lock<std::mutex> lock(latch_);
+  // 1.     Search the page table for the requested page (P).
+  // 1.1    If P exists, pin it and return it immediately.
+  // 1.2    If P does not exist, find a replacement page (R) from either the bulk read ring, the free list or the
+  //        replacer.
+  // 2.     If R is dirty, write it back to the disk. The latch is released meanwhile, so look P up again.
+  frame_id_t frame_id;
+  bool found_frame = false;
+  while (true) {
+    auto it = page_table_.find(page_id);
+    if (evicting_.count(page_id) != 0 || (it != page_table_.end() && loading_.count(it->second) != 0)) {
+      io_cv_.wait(lock);  // P is being written back or read in by someone else, wait instead of reading it twice
+      continue;
+    }
+    if (it != page_table_.end()) {
+      if (found_frame) free_list_.push_back(frame_id);  // P came in while R was written back
+      frame_id = it->second;
+      hits_.fetch_add(1, std::memory_order_relaxed);
+      replacer_->Pin(frame_id);
+      pages_[frame_id].pin_count_++;
+      // a page read ahead for a bulk read scan counts as read by that scan
+      if (prefetched_.erase(frame_id) != 0 && ring != nullptr) AddToRing(ring, page_id);
+      return &pages_[frame_id];
+    }
+    if (found_frame) break;
+    if ((ring == nullptr || !RecycleRingFrame(ring, &frame_id, &lock)) && !FindVictimFrame(&frame_id, &lock)) {
+      return nullptr;
+    }
+    found_frame = true;
+  }
+  misses_.fetch_add(1, std::memory_order_relaxed);
+  if (ring != nullptr) AddToRing(ring, page_id);
+  // 3.     Insert P into the page table and reserve R for it: others wait until the read is done.
+  Page &p = pages_[frame_id];
+  p.pin_count_ = 1;
+  p.is_dirty_ = false;
+  p.page_id_ = page_id;
+  page_table_[page_id] = frame_id;
+  replacer_->Pin(frame_id);  // let the replacer see the first access
+  loading_.insert(frame_id);
+  // 4.     Read in the page content from disk without holding the latch, and then return a pointer to P.
+  lock.unlock();
+  bool valid = disk_manager_->ReadPage(page_id, p.GetData());
+  lock.lock();
+  loading_.erase(frame_id);
+  if (!valid) {
+    DiscardFrame(frame_id);  // never hand out a corrupted page
+  }
+  lock.unlock();
+  io_cv_.notify_all();
+  return valid ? &p : nullptr;
+}
+
+Page *BufferPoolInstance::NewPage(page_id_t page_id) {
+  std::unique_lock<std::mutex> lock(latch_);
+  // 1.   Pick a victim page P from either the free list or the replacer. If all the pages are pinned, return nullptr.
+  frame_id_t frame_id;
+  bool found_frame = false;
+  while (true) {
+    // A stale copy of a page that was freed may still be resident, loaded by read-ahead or warm-up. Drop it.
+    // Look again after P was found, the latch is released while a dirty victim is written back.
+    auto it = page_table_.find(page_id);
+    if (evicting_.count(page_id) != 0 ||
+        (it != page_table_.end() && (flushing_.count(it->second) != 0 || loading_.count(it->second) != 0))) {
+      io_cv_.wait(lock);
+      continue;
+    }
+    if (it != page_table_.end()) {
+      ASSERT(pages_[it->second].pin_count_ == 0, "Newly allocated page is in use.");
+      replacer_->Remove(it->second);
+      prefetched_.erase(it->second);
+      pages_[it->second].page_id_ = INVALID_PAGE_ID;
+      free_list_.push_back(it->second);
+      page_table_.erase(it);
+    }
+    if (found_frame) break;
+    if (!FindVictimFrame(&frame_id, &lock)) {
+      return nullptr;
+    }
+    found_frame = true;
+  }
+  // 2.   Update P's metadata, zero out memory and add P to the page table.
+  //      The zeroed page is not on disk yet, so it starts dirty.
+  Page &p = pages_[frame_id];
+  p.pin_count_ = 1;
+  p.is_dirty_ = true;
+  p.page_id_ = page_id;
+  p.ResetMemory();
+  page_table_[page_id] = frame_id;
+  replacer_->Pin(frame_id);
+  return &p;
+}
+
+bool BufferPoolInstance::DeletePage(page_id_t page_id) {
+  std::unique_lock<std::mutex> lock(latch_);
+  // 1.   Search the page table for the requested page (P).
+  // 1.   If P does not exist, return true.
+  auto it = page_table_.find(page_id);
+  while (evicting_.count(page_id) != 0 ||
+         (it != page_table_.end() && (flushing_.count(it->second) != 0 || loading_.count(it->second) != 0))) {
+    io_cv_.wait(lock);
+    it = page_table_.find(page_id);
+  }
+  if (it == page_table_.end()) return true;
+  frame_id_t frame_id = it->second;
+  Page &p = pages_[frame_id];
+  // 2.   If P exists, but has a non-zero pin-count, return false. Someone is using the page.
+  if (p.GetPinCount()) return false;
+  // 3.   Otherwise, P can be deleted. Remove P from the page table, reset its metadata and return it to the free list.
+  if (p.IsDirty()) {
+    disk_manager_->WritePage(page_id, p.GetData());
+    p.is_dirty_ = false;
+  }
+  page_table_.erase(page_id);
+  prefetched_.erase(frame_id);
+  // 0.   Make sure you call DeallocatePage!
+  disk_manager_->DeAllocatePage(page_id);
+  p.page_id_ = INVALID_PAGE_ID;  // reset metadata, no need to reset pin_count_ and is_dirty_
+  free_list_.push_back(frame_id);
+  replacer_->Remove(frame_id);
+  return true;
+}
+
+bool BufferPoolInstance::UnpinPage(page_id_t page_id, bool is_dirty) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  auto it = page_table_.find(page_id);
+  if (it == page_table_.end()) return false;
+  frame_id_t frame_id = it->second;
+  Page &p = pages_[frame_id];
+  if (p.pin_count_ <= 0) return false;
+  p.pin_count_--;
+  // a clean unpin must not hide an earlier dirty unpin of the same page
+  p.is_dirty_ = p.is_dirty_ || is_dirty;
+  if (p.GetPinCount() == 0) replacer_->Unpin(frame_id);
+  return true;
+}
+
+bool BufferPoolInstance::FlushPage(page_id_t page_id) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  auto it = page_table_.find(page_id);
+  if (it == page_table_.end()) return false;
+  Page &p = pages_[it->second];
+  disk_manager_->WritePage(p.GetPageId(), p.GetData());
+  p.is_dirty_ = false;
+  return true;
+}
+
+page_id_t BufferPoolInstance::Prefetch(page_id_t page_id, NextPageIdFunc next_page_id) {
+  frame_id_t frame_id;
+  {
+    std::unique_lock<std::mutex> lock(latch_);
+    bool found_frame = false;
+    while (true) {
+      auto it = page_table_.find(page_id);
+      if (it != page_table_.end() || evicting_.count(page_id) != 0) {
+        if (found_frame) free_list_.push_back(frame_id);  // the page came in while the victim was written back
+        // already resident or on its way in, only follow the chain
+        if (it == page_table_.end() || loading_.count(it->second) != 0) return INVALID_PAGE_ID;
+        return ReadNextPageId(it->second, next_page_id, &lock);
+      }
+      if (found_frame) break;
+      if (!FindVictimFrame(&frame_id, &lock)) {
+        return INVALID_PAGE_ID;
+      }
+      found_frame = true;
+    }
+    // Reserve the frame: it is in the page table but neither pinned nor in the replacer until the read is done.
+    Page &p = pages_[frame_id];
+    p.pin_count_ = 0;
+    p.is_dirty_ = false;
+    p.page_id_ = page_id;
+    page_table_[page_id] = frame_id;
+    loading_.insert(frame_id);
+  }
+  bool valid = disk_manager_->ReadPage(page_id, pages_[frame_id].GetData());
+  prefetched_pages_.fetch_add(1, std::memory_order_relaxed);
+  // the frame is still in loading_, so nobody else can have latched or changed it yet
+  page_id_t next = valid ? next_page_id(pages_[frame_id].GetData()) : INVALID_PAGE_ID;
+  {
+    std::scoped_lock<std::mutex> lock(latch_);
+    loading_.erase(frame_id);
+    if (valid) {
+      prefetched_.insert(frame_id);
+      replacer_->Unpin(frame_id);
+    } else {
+      DiscardFrame(frame_id);
+    }
+  }
+  io_cv_.notify_all();
+  return next;
+}
+
+page_id_t BufferPoolInstance::ReadNextPageId(frame_id_t frame_id, NextPageIdFunc next_page_id,
+                                             std::unique_lock<std::mutex> *lock) {
+  // Pin the page so that it stays, and latch it without holding latch_: its user may be changing the link.
+  Page &p = pages_[frame_id];
+  replacer_->Pin(frame_id);
+  p.pin_count_++;
+  lock->unlock();
+  p.RLatch();
+  page_id_t next = next_page_id(p.GetData());
+  p.RUnlatch();
+  lock->lock();
+  p.pin_count_--;
+  if (p.pin_count_ == 0) replacer_->Unpin(frame_id);
+  return next;
+}
+
+size_t BufferPoolInstance::PrefetchPages(const vector<page_id_t> &page_ids) {
+  vector<pair<page_id_t, char *>> batch;
+  vector<frame_id_t> frames;
+  {
+    std::unique_lock<std::mutex> lock(latch_);
+    for (auto page_id : page_ids) {
+      if (page_table_.count(page_id) != 0 || evicting_.count(page_id) != 0) continue;
+      frame_id_t frame_id;
+      if (!FindVictimFrame(&frame_id, &lock)) break;
+      // the latch may have been released to write the victim back, and the page read in meanwhile
+      if (page_table_.count(page_id) != 0 || evicting_.count(page_id) != 0) {
+        free_list_.push_back(frame_id);
+        continue;
+      }
+      Page &p = pages_[frame_id];
+      p.pin_count_ = 0;
+      p.is_dirty_ = false;
+      p.page_id_ = page_id;
+      page_table_[page_id] = frame_id;
+      loading_.insert(frame_id);
+      batch.emplace_back(page_id, p.GetData());
+      frames.push_back(frame_id);
+    }
+  }
+  if (frames.empty()) return 0;
+  auto failed = disk_manager_->ReadPages(batch);
+  {
+    std::scoped_lock<std::mutex> lock(latch_);
+    for (auto frame_id : frames) {
+      loading_.erase(frame_id);
+      prefetched_.insert(frame_id);
+      replacer_->Unpin(frame_id);
+    }
+    for (auto page_id : failed) {
+      DiscardFrame(page_table_[page_id]);
+    }
+  }
+  prefetched_pages_.fetch_add(frames.size(), std::memory_order_relaxed);
+  io_cv_.notify_all();
+  return frames.size();
+}
+
+size_t BufferPoolInstance::FlushDirtyPages(size_t min_clean_frames) {
+  vector<frame_id_t> frames;
+  {
+    std::scoped_lock<std::mutex> lock(latch_);
+    size_t clean_frames = free_list_.size();
+    for (size_t i = 0; i < pool_size_; i++) {
+      if (pages_[i].pin_count_ == 0 && !pages_[i].is_dirty_ && pages_[i].page_id_ != INVALID_PAGE_ID) clean_frames++;
+    }
+    for (size_t i = 0; i < pool_size_ && clean_frames + frames.size() < min_clean_frames; i++) {
+      Page &p = pages_[i];
+      if (p.pin_count_ == 0 && p.is_dirty_ && flushing_.count(i) == 0) {
+        // Clear the flag before the write: whoever modifies the page meanwhile will set it again on unpin.
+        p.is_dirty_ = false;
+        flushing_.insert(i);
+        frames.push_back(i);
+      }
+    }
+  }
+  WriteFlushingFrames(frames);
+  return frames.size();
+}
+
+void BufferPoolInstance::FlushAllPages() {
+  vector<frame_id_t> frames;
+  {
+    std::unique_lock<std::mutex> lock(latch_);
+    io_cv_.wait(lock, [this] { return flushing_.empty(); });
+    for (size_t i = 0; i < pool_size_; i++) {
+      Page &p = pages_[i];
+      if (p.is_dirty_ && p.page_id_ != INVALID_PAGE_ID) {
+        p.is_dirty_ = false;
+        flushing_.insert(i);
+        frames.push_back(i);
+      }
+    }
+  }
+  WriteFlushingFrames(frames);
+}
+
+void BufferPoolInstance::WriteFlushingFrames(const vector<frame_id_t> &frames) {
+  if (frames.empty()) return;
+  // The frames cannot be evicted or deleted while in flushing_, so their data is written without latch_.
+  vector<pair<page_id_t, char *>> batch;
+  batch.reserve(frames.size());
+  for (auto frame_id : frames) {
+    batch.emplace_back(pages_[frame_id].page_id_, pages_[frame_id].GetData());
+  }
+  disk_manager_->WritePages(batch);
+  flushed_pages_.fetch_add(frames.size(), std::memory_order_relaxed);
+  {
+    std::scoped_lock<std::mutex> lock(latch_);
+    for (auto frame_id : frames) {
+      flushing_.erase(frame_id);
+      // the replacer may have handed the frame out and had it skipped while it was being written
+      if (pages_[frame_id].pin_count_ == 0) replacer_->Unpin(frame_id);
+    }
+  }
+  io_cv_.notify_all();
+}
+
+void BufferPoolInstance::GetResidentPages(vector<page_id_t> *page_ids) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  for (auto &entry : page_table_) {
+    if (pages_[entry.second].pin_count_ > 0) page_ids->push_back(entry.first);
+  }
+  vector<frame_id_t> victims;
+  replacer_->GetVictimOrder(&victims);
+  for (auto it = victims.rbegin(); it != victims.rend(); ++it) {
+    // frames still being written back are out of the replacer, they are lost to the list
+    page_ids->push_back(pages_[*it].page_id_);
+  }
+}
+
+void BufferPoolInstance::AddStats(BufferPoolStats *stats) const {
+  stats->hits_ += hits_.load(std::memory_order_relaxed);
+  stats->misses_ += misses_.load(std::memory_order_relaxed);
+  stats->evictions_ += evictions_.load(std::memory_order_relaxed);
+  stats->dirty_evictions_ += dirty_evictions_.load(std::memory_order_relaxed);
+  stats->prefetched_pages_ += prefetched_pages_.load(std::memory_order_relaxed);
+  stats->flushed_pages_ += flushed_pages_.load(std::memory_order_relaxed);
+}
+
+// Only used for debug
+bool BufferPoolInstance::CheckAllUnpinned() {
+  std::scoped_lock<std::mutex> lock(latch_);
+  bool res = true;
+  for (size_t i = 0; i < pool_size_; i++) {
+    if (pages_[i].pin_count_ != 0) {
+      res = false;
+      LOG(ERROR) << "page " << pages_[i].page_id_ << " pin count:" << pages_[i].pin_count_ << endl;
+    }
+  }
+  return res;
+}
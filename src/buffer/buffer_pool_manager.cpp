@@ -1,167 +1,97 @@
 #include "buffer/buffer_pool_manager.h"
 
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
 #include "glog/logging.h"
 #include "page/bitmap_page.h"
 
-static const char EMPTY_PAGE_DATA[PAGE_SIZE] = {0};
-
-BufferPoolManager::BufferPoolManager(size_t pool_size, DiskManager *disk_manager)
+BufferPoolManager::BufferPoolManager(size_t pool_size, DiskManager *disk_manager, size_t num_instances,
+                                     ReplacerType replacer_type, bool huge_pages)
     : pool_size_(pool_size), disk_manager_(disk_manager) {
-  pages_ = new Page[pool_size_];
-  replacer_ = new LRUReplacer(pool_size_);
-  for (size_t i = 0; i < pool_size_; i++) {
-    free_list_.emplace_back(i);
+  ASSERT(num_instances > 0 && num_instances <= pool_size, "Invalid number of buffer pool instances.");
+  // spread the frames as evenly as possible, the first instances take the remainder
+  for (size_t i = 0; i < num_instances; i++) {
+    size_t instance_size = pool_size_ / num_instances + (i < pool_size_ % num_instances ? 1 : 0);
+    instances_.emplace_back(new BufferPoolInstance(instance_size, disk_manager_, replacer_type, huge_pages));
   }
 }
 
+bool BufferPoolManager::IsHugePageBacked() const {
+  return std::all_of(instances_.begin(), instances_.end(),
+                     [](const BufferPoolInstance *instance) { return instance->IsHugePageBacked(); });
+}
+
 BufferPoolManager::~BufferPoolManager() {
-  for (auto page : page_table_) {
-    FlushPage(page.first);
-  }
-  delete[] pages_;
-  delete replacer_;
-}
-
-/**
- * TODO: Student Implement
- */
-Page *BufferPoolManager::FetchPage(page_id_t page_id) {
-  // 1.     Search the page table for the requested page (P).
-  // 1.1    If P exists, pin it and return it immediately.
-  frame_id_t frame_id;
-  auto it=page_table_.find(page_id);
-  if(it!=page_table_.end()){
-    frame_id=it->second;
-    replacer_->Pin(frame_id); //pin it
-    pages_[frame_id].pin_count_++;  //add pin count of this page
-    return &pages_[frame_id];
-  }
-  // 1.2    If P does not exist, find a replacement page (R) from either the free list or the replacer.
-  //        Note that pages are always found from the free list first.
-  if(!free_list_.empty()){  //find R from free list
-    frame_id=free_list_.back();
-    free_list_.pop_back();
-  }
-  else if(replacer_->Victim(&frame_id)){ //find R from replacer
-    Page& p=pages_[frame_id];
-    // 2.     If R is dirty, write it back to the disk.
-    if(p.IsDirty()){
-      disk_manager_->WritePage(p.GetPageId(), p.GetData());
-      p.is_dirty_=false;
+  StopFlusher();
+  if (reader_.joinable()) {
+    {
+      std::scoped_lock<std::mutex> lock(reader_latch_);
+      reader_stop_ = true;
     }
-    // 3.     Delete R from the page table and insert P.
-    page_table_.erase(p.GetPageId()); //delete R
-  }
-  else return nullptr;  //no free page or replacement page to insert page_id
-  // 4.     Update P's metadata, read in the page content from disk, and then return a pointer to P.
-  Page& p=pages_[frame_id];
-  p.pin_count_=1;
-  p.is_dirty_=false;
-  p.page_id_=page_id;
-  page_table_[page_id]=frame_id;  //insert P
-  disk_manager_->ReadPage(page_id, p.GetData());
-  return &p;
-}
-
-/**
- * TODO: Student Implement
- */
-Page *BufferPoolManager::NewPage(page_id_t &page_id) {
-  // 1.   If all the pages in the buffer pool are pinned, return nullptr.
-  size_t i=0;
-  while(i<pool_size_){
-    if(pages_[i].pin_count_==0) break;
-    i++;
-  }
-  if(i==pool_size_) return nullptr;
-  // 2.   Pick a victim page P from either the free list or the replacer. Always pick from the free list first.
-  frame_id_t frame_id;
-  if(!free_list_.empty()){
-    frame_id=free_list_.back();
-    free_list_.pop_back();
-  }
-  else if(replacer_->Victim(&frame_id)){
-    Page& p=pages_[frame_id];
-    if(p.IsDirty()){
-      disk_manager_->WritePage(p.GetPageId(), p.GetData());
-      p.is_dirty_=false;
+    reader_cv_.notify_all();
+    reader_.join();
+  }
+  for (auto instance : instances_) {
+    delete instance;
+  }
+}
+
+Page *BufferPoolManager::FetchPage(page_id_t page_id, BufferAccessStrategy *strategy) {
+  if (strategy == nullptr) return GetInstance(page_id)->FetchPage(page_id);
+  size_t index = GetInstanceIndex(page_id);
+  return instances_[index]->FetchPage(page_id, strategy->GetRing(index, instances_.size()));
+}
+
+Page *BufferPoolManager::NewPage(page_id_t &page_id, ExtentReservation *reservation) {
+  // The page id decides the instance, so when that instance is full keep the id and allocate another one, until an
+  // instance takes the page or every instance turned out to be full. The ids that were skipped are given back.
+  vector<page_id_t> skipped;
+  vector<bool> full(instances_.size(), false);
+  size_t num_full = 0;
+  Page *page = nullptr;
+  while (page == nullptr && num_full < instances_.size()) {
+    page_id_t new_page_id = AllocatePage(reservation);
+    if (new_page_id == INVALID_PAGE_ID) {
+      break;
+    }
+    page = GetInstance(new_page_id)->NewPage(new_page_id);
+    if (page == nullptr) {
+      skipped.push_back(new_page_id);
+      size_t index = GetInstanceIndex(new_page_id);
+      if (!full[index]) {
+        full[index] = true;
+        num_full++;
+      }
+    } else {
+      page_id = new_page_id;
     }
-    page_table_.erase(p.GetPageId());
-  }
-  else return nullptr;
-  // 0.   Make sure you call AllocatePage!
-  page_id=AllocatePage();
-  // 3.   Update P's metadata, zero out memory and add P to the page table.
-  Page& p=pages_[frame_id];
-  p.pin_count_=1;
-  p.is_dirty_=false;
-  p.page_id_=page_id;
-  p.ResetMemory();
-  page_table_[page_id]=frame_id;
-  // 4.   Set the page ID output parameter. Return a pointer to P.
-  return &p;
-}
-
-/**
- * TODO: Student Implement
- */
+  }
+  for (auto skipped_id : skipped) {
+    DeallocatePage(skipped_id);
+  }
+  return page;
+}
+
 bool BufferPoolManager::DeletePage(page_id_t page_id) {
-  // 1.   Search the page table for the requested page (P).
-  // 1.   If P does not exist, return true.
-  auto it=page_table_.find(page_id);
-  if(it==page_table_.end()) return true;
-  frame_id_t frame_id=it->second;
-  Page& p=pages_[frame_id];
-  // 2.   If P exists, but has a non-zero pin-count, return false. Someone is using the page.
-  if(p.GetPinCount()) return false;
-  // 3.   Otherwise, P can be deleted. Remove P from the page table, reset its metadata and return it to the free list.
-  if(p.IsDirty()){
-    disk_manager_->WritePage(page_id, p.GetData());
-    p.is_dirty_=false;
-  }
-  page_table_.erase(p.GetPageId()); 
-  // 0.   Make sure you call DeallocatePage!
-  DeallocatePage(page_id);
-  p.page_id_=INVALID_PAGE_ID;  //reset metadata, no need to reset pin_count_ and is_dirty_
-  free_list_.push_back(frame_id); //return it to the free list
-  replacer_->Pin(frame_id); //remove from replacer
-  return true;
+  return GetInstance(page_id)->DeletePage(page_id);
 }
 
-/**
- * TODO: Student Implement
- */
 bool BufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty) {
-  auto it=page_table_.find(page_id);
-  if(it!=page_table_.end()){ //exists
-    frame_id_t frame_id=it->second;
-    Page& p=pages_[frame_id];
-    p.pin_count_--; //decrease pin count
-    p.is_dirty_=is_dirty;
-    if(p.GetPinCount()==0) replacer_->Unpin(frame_id); //add it to replacer
-    return true;
-  }
-  return false;
+  return GetInstance(page_id)->UnpinPage(page_id, is_dirty);
 }
 
-
-/**
- * TODO: Student Implement
- */
 bool BufferPoolManager::FlushPage(page_id_t page_id) {
-  auto it=page_table_.find(page_id);
-  if(it!=page_table_.end()){ //exists
-    frame_id_t frame_id=it->second;
-    Page& p=pages_[frame_id];
-    disk_manager_->WritePage(p.GetPageId(), p.GetData());
-    p.is_dirty_=false;
-    return true;
-  }
-  return false;
+  return GetInstance(page_id)->FlushPage(page_id);
+}
+
+void BufferPoolManager::ReleaseReservation(ExtentReservation *reservation) {
+  disk_manager_->ReleaseReservation(reservation);
 }
 
-page_id_t BufferPoolManager::AllocatePage() {
-  int next_page_id = disk_manager_->AllocatePage();
+page_id_t BufferPoolManager::AllocatePage(ExtentReservation *reservation) {
+  int next_page_id = disk_manager_->AllocatePage(reservation);
   return next_page_id;
 }
 
@@ -173,14 +103,174 @@ bool BufferPoolManager::IsPageFree(page_id_t page_id) {
   return disk_manager_->IsPageFree(page_id);
 }
 
+void BufferPoolManager::FlushAllPages() {
+  for (auto instance : instances_) {
+    instance->FlushAllPages();
+  }
+  disk_manager_->Sync();
+}
+
+void BufferPoolManager::StartFlusher(double clean_ratio, uint32_t interval_ms) {
+  if (flusher_.joinable()) return;
+  flusher_stop_ = false;
+  flusher_ = thread(&BufferPoolManager::FlusherLoop, this, clean_ratio, interval_ms);
+}
+
+void BufferPoolManager::StopFlusher() {
+  if (!flusher_.joinable()) return;
+  {
+    std::scoped_lock<std::mutex> lock(flusher_latch_);
+    flusher_stop_ = true;
+  }
+  flusher_cv_.notify_all();
+  flusher_.join();
+}
+
+void BufferPoolManager::FlusherLoop(double clean_ratio, uint32_t interval_ms) {
+  std::unique_lock<std::mutex> lock(flusher_latch_);
+  while (!flusher_cv_.wait_for(lock, std::chrono::milliseconds(interval_ms), [this] { return flusher_stop_; })) {
+    lock.unlock();
+    for (auto instance : instances_) {
+      instance->FlushDirtyPages(static_cast<size_t>(clean_ratio * instance->GetPoolSize()));
+    }
+    lock.lock();
+  }
+}
+
+void BufferPoolManager::ReadAhead(page_id_t page_id, size_t count, NextPageIdFunc next_page_id) {
+  if (page_id == INVALID_PAGE_ID || count == 0) return;
+  {
+    std::scoped_lock<std::mutex> lock(reader_latch_);
+    if (read_ahead_.size() >= READ_AHEAD_QUEUE_SIZE) return;
+    read_ahead_.push_back({page_id, count, next_page_id});
+    if (!reader_.joinable()) {
+      reader_ = thread(&BufferPoolManager::ReadAheadLoop, this);
+    }
+  }
+  reader_cv_.notify_all();
+}
+
+void BufferPoolManager::DrainReadAhead() {
+  std::unique_lock<std::mutex> lock(reader_latch_);
+  reader_cv_.wait(lock, [this] { return read_ahead_.empty() && warm_up_.empty() && !reader_busy_; });
+}
+
+vector<page_id_t> BufferPoolManager::GetResidentPages() {
+  vector<vector<page_id_t>> instance_pages(instances_.size());
+  size_t longest = 0;
+  for (size_t i = 0; i < instances_.size(); i++) {
+    instances_[i]->GetResidentPages(&instance_pages[i]);
+    longest = std::max(longest, instance_pages[i].size());
+  }
+  // recency is only known within an instance, interleave so that any prefix is spread evenly
+  vector<page_id_t> page_ids;
+  for (size_t rank = 0; rank < longest; rank++) {
+    for (auto &pages : instance_pages) {
+      if (rank < pages.size()) page_ids.push_back(pages[rank]);
+    }
+  }
+  return page_ids;
+}
+
+bool BufferPoolManager::SaveResidentPages(const std::string &file_name) {
+  auto page_ids = GetResidentPages();
+  std::ofstream out(file_name, std::ios::binary | std::ios::trunc);
+  if (!out.is_open()) {
+    LOG(ERROR) << "Cannot write resident page list " << file_name;
+    return false;
+  }
+  uint32_t count = page_ids.size();
+  out.write(reinterpret_cast<const char *>(&count), sizeof(uint32_t));
+  out.write(reinterpret_cast<const char *>(page_ids.data()), count * sizeof(page_id_t));
+  return out.good();
+}
+
+bool BufferPoolManager::LoadResidentPages(const std::string &file_name) {
+  std::ifstream in(file_name, std::ios::binary);
+  if (!in.is_open()) return false;
+  uint32_t count = 0;
+  in.read(reinterpret_cast<char *>(&count), sizeof(uint32_t));
+  vector<page_id_t> page_ids(count);
+  in.read(reinterpret_cast<char *>(page_ids.data()), count * sizeof(page_id_t));
+  bool complete = in.good();
+  in.close();
+  // the list only describes the last clean shutdown, never use it twice
+  remove(file_name.c_str());
+  if (!complete) {
+    LOG(ERROR) << "Truncated resident page list " << file_name;
+    return false;
+  }
+  WarmUp(std::move(page_ids));
+  return true;
+}
+
+void BufferPoolManager::WarmUp(vector<page_id_t> page_ids) {
+  if (page_ids.size() > pool_size_) page_ids.resize(pool_size_);
+  // logical to physical mapping is monotonic, sorting by id reads the file front to back and lets adjacent pages be
+  // read together
+  std::sort(page_ids.begin(), page_ids.end());
+  {
+    std::scoped_lock<std::mutex> lock(reader_latch_);
+    for (auto page_id : page_ids) {
+      if (page_id != INVALID_PAGE_ID) warm_up_.push_back(page_id);
+    }
+    if (!reader_.joinable()) {
+      reader_ = thread(&BufferPoolManager::ReadAheadLoop, this);
+    }
+  }
+  reader_cv_.notify_all();
+}
+
+void BufferPoolManager::ReadAheadLoop() {
+  std::unique_lock<std::mutex> lock(reader_latch_);
+  while (true) {
+    reader_cv_.wait(lock, [this] { return reader_stop_ || !read_ahead_.empty() || !warm_up_.empty(); });
+    if (reader_stop_) break;
+    if (read_ahead_.empty()) {
+      // warm up in small batches, so that read-ahead of a running scan never waits long
+      vector<vector<page_id_t>> batches(instances_.size());
+      for (int i = 0; i < WARM_UP_BATCH_SIZE && !warm_up_.empty(); i++) {
+        batches[GetInstanceIndex(warm_up_.front())].push_back(warm_up_.front());
+        warm_up_.pop_front();
+      }
+      reader_busy_ = true;
+      lock.unlock();
+      for (size_t i = 0; i < instances_.size(); i++) {
+        if (!batches[i].empty()) instances_[i]->PrefetchPages(batches[i]);
+      }
+      lock.lock();
+      reader_busy_ = false;
+      reader_cv_.notify_all();
+      continue;
+    }
+    ReadAheadRequest request = read_ahead_.front();
+    read_ahead_.pop_front();
+    reader_busy_ = true;
+    lock.unlock();
+    // Prefetch stops following the chain once a page is still being read in or no frame is free.
+    page_id_t page_id = request.page_id_;
+    for (size_t i = 0; i < request.count_ && page_id != INVALID_PAGE_ID; i++) {
+      page_id = GetInstance(page_id)->Prefetch(page_id, request.next_page_id_);
+    }
+    lock.lock();
+    reader_busy_ = false;
+    reader_cv_.notify_all();
+  }
+}
+
+BufferPoolStats BufferPoolManager::GetStats() const {
+  BufferPoolStats stats;
+  for (auto instance : instances_) {
+    instance->AddStats(&stats);
+  }
+  return stats;
+}
+
 // Only used for debug
 bool BufferPoolManager::CheckAllUnpinned() {
   bool res = true;
-  for (size_t i = 0; i < pool_size_; i++) {
-    if (pages_[i].pin_count_ != 0) {
-      res = false;
-      LOG(ERROR) << "page " << pages_[i].page_id_ << " pin count:" << pages_[i].pin_count_ << endl;
-    }
+  for (auto instance : instances_) {
+    res = instance->CheckAllUnpinned() && res;
   }
   return res;
-}
\ No newline at end of file
+}
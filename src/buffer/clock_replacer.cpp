@@ -0,0 +1,52 @@
+#include "buffer/clock_replacer.h"
+
+CLOCKReplacer::CLOCKReplacer(size_t num_pages) : capacity(num_pages) {}
+
+CLOCKReplacer::~CLOCKReplacer() = default;
+
+bool CLOCKReplacer::Victim(frame_id_t *frame_id) {
+  // the front of clock_list is the clock hand, give referenced frames a second chance
+  while (!clock_list.empty()) {
+    frame_id_t frame = clock_list.front();
+    clock_list.pop_front();
+    if (clock_status[frame]) {
+      clock_status[frame] = 0;
+      clock_list.push_back(frame);
+    } else {
+      clock_status.erase(frame);
+      *frame_id = frame;
+      return true;
+    }
+  }
+  return false;
+}
+
+void CLOCKReplacer::Pin(frame_id_t frame_id) {
+  if (clock_status.count(frame_id) == 0) return;  // not exists
+  clock_list.remove(frame_id);
+  clock_status.erase(frame_id);
+}
+
+void CLOCKReplacer::Unpin(frame_id_t frame_id) {
+  auto it = clock_status.find(frame_id);
+  if (it != clock_status.end()) {  // already in, set its reference bit
+    it->second = 1;
+    return;
+  }
+  if (clock_list.size() >= capacity) return;
+  clock_list.push_back(frame_id);
+  clock_status[frame_id] = 1;
+}
+
+void CLOCKReplacer::GetVictimOrder(vector<frame_id_t> *frames) {
+  // the hand takes unreferenced frames in its first round and the others in the second
+  for (int referenced = 0; referenced <= 1; referenced++) {
+    for (auto frame : clock_list) {
+      if (clock_status[frame] == referenced) frames->push_back(frame);
+    }
+  }
+}
+
+size_t CLOCKReplacer::Size() {
+  return clock_list.size();
+}
@@ -0,0 +1,68 @@
+#include "buffer/lru_k_replacer.h"
+
+LRUKReplacer::LRUKReplacer(size_t num_pages, size_t k) : max_size(num_pages), k_(k) {}
+
+LRUKReplacer::~LRUKReplacer() = default;
+
+bool LRUKReplacer::Victim(frame_id_t *frame_id) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  if (evictable_.empty()) return false;
+  *frame_id = evictable_.begin()->second;
+  evictable_.erase(evictable_.begin());
+  history_.erase(*frame_id);  // the frame will hold another page, forget its history
+  unreferenced_.erase(*frame_id);
+  if (last_accessed_frame_ == *frame_id) last_accessed_frame_ = INVALID_FRAME_ID;
+  return true;
+}
+
+void LRUKReplacer::Pin(frame_id_t frame_id) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  auto &history = history_[frame_id];
+  if (!history.empty()) {
+    evictable_.erase(make_pair(EvictKey(history), frame_id));
+  }
+  if (unreferenced_.erase(frame_id) != 0) {
+    history.clear();  // drop the placeholder, this is the first real access
+  }
+  if (last_accessed_frame_ == frame_id && !history.empty()) {
+    history.back() = current_timestamp_++;  // correlated reference
+  } else {
+    history.push_back(current_timestamp_++);
+    if (history.size() > k_) history.pop_front();
+  }
+  last_accessed_frame_ = frame_id;
+}
+
+void LRUKReplacer::Unpin(frame_id_t frame_id) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  if (evictable_.size() >= max_size) return;
+  auto &history = history_[frame_id];
+  if (history.empty()) {
+    // never accessed through Pin, keep a placeholder access until the first real one
+    history.push_back(current_timestamp_++);
+    unreferenced_.insert(frame_id);
+  }
+  evictable_.insert(make_pair(EvictKey(history), frame_id));
+}
+
+void LRUKReplacer::Remove(frame_id_t frame_id) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  auto it = history_.find(frame_id);
+  if (it == history_.end()) return;
+  evictable_.erase(make_pair(EvictKey(it->second), frame_id));
+  history_.erase(it);
+  unreferenced_.erase(frame_id);
+  if (last_accessed_frame_ == frame_id) last_accessed_frame_ = INVALID_FRAME_ID;
+}
+
+void LRUKReplacer::GetVictimOrder(vector<frame_id_t> *frames) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  for (auto &entry : evictable_) {
+    frames->push_back(entry.second);
+  }
+}
+
+size_t LRUKReplacer::Size() {
+  std::scoped_lock<std::mutex> lock(latch_);
+  return evictable_.size();
+}
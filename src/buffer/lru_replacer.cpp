@@ -33,6 +33,10 @@ void LRUReplacer::Unpin(frame_id_t frame_id) {
   lru_map.insert(make_pair(frame_id, lru_list.begin()));
 }
 
+void LRUReplacer::GetVictimOrder(vector<frame_id_t> *frames) {
+  frames->insert(frames->end(), lru_list.rbegin(), lru_list.rend());  // least recently used at the back
+}
+
 /**
  * TODO: Student Implement
  */
@@ -1,7 +1,7 @@
 #include "catalog/catalog.h"
 
 void CatalogMeta::SerializeTo(char *buf) const {
-    ASSERT(GetSerializedSize() <= PAGE_SIZE, "Failed to serialize catalog metadata to disk.");
+    ASSERT(GetSerializedSize() <= PAGE_SIZE - PAGE_CHECKSUM_SIZE, "Failed to serialize catalog metadata to disk.");
     MACH_WRITE_UINT32(buf, CATALOG_METADATA_MAGIC_NUM);
     buf += 4;
     MACH_WRITE_UINT32(buf, table_meta_pages_.size());
@@ -76,17 +76,30 @@ CatalogManager::CatalogManager(BufferPoolManager *buffer_pool_manager, LockManag
   }
   else{
     auto page=buffer_pool_manager->FetchPage(CATALOG_META_PAGE_ID);
+    if(page==nullptr){  //corrupted, the database opens without tables
+      LOG(ERROR) << "Cannot read the catalog meta page";
+      next_table_id_=0;
+      next_index_id_=0;
+      catalog_meta_=CatalogMeta::NewInstance();
+      return;
+    }
     catalog_meta_=CatalogMeta::DeserializeFrom(page->GetData());  //buf==page->GetData()
     next_table_id_=catalog_meta_->GetNextTableId(); //get next_table_id using catalog_meta
     next_index_id_=catalog_meta_->GetNextIndexId(); //and next_index_id
     for(auto it: catalog_meta_->table_meta_pages_){ //for each table
       auto table_meta_page=buffer_pool_manager->FetchPage(it.second);  //it.second is page_id_t
+      if(table_meta_page==nullptr){  //the table is left out, its indexes too
+        LOG(ERROR) << "Cannot read the metadata page of table " << it.first;
+        continue;
+      }
       TableMetadata *table_meta=nullptr;
       TableMetadata::DeserializeFrom(table_meta_page->GetData(), table_meta);  //get table_meta
       table_names_[table_meta->GetTableName()]=table_meta->GetTableId();
 
       auto table_info=TableInfo::Create();  //get table_info
-      auto table_heap=TableHeap::Create(buffer_pool_manager, table_meta->GetFirstPageId(), table_meta->GetSchema(), log_manager, lock_manager);
+      auto table_heap=TableHeap::Create(buffer_pool_manager, table_meta->GetFirstPageId(), table_meta->GetFreeSpaceMapPageId(),
+                                        table_meta->GetSchema(), log_manager, lock_manager, table_meta->GetLayout(),
+                                        table_meta->GetDictionaryPageId(), table_meta->GetZoneMapPageId());
       table_info->Init(table_meta, table_heap);
       tables_[table_meta->GetTableId()]=table_info;
       buffer_pool_manager->UnpinPage(table_meta_page->GetPageId(), table_meta_page->IsDirty());
@@ -94,8 +107,16 @@ CatalogManager::CatalogManager(BufferPoolManager *buffer_pool_manager, LockManag
 
     for(auto it: catalog_meta_->index_meta_pages_){ //for each index
       auto index_meta_page=buffer_pool_manager->FetchPage(it.second);
+      if(index_meta_page==nullptr){
+        LOG(ERROR) << "Cannot read the metadata page of index " << it.first;
+        continue;
+      }
       IndexMetadata *index_meta=nullptr;
       IndexMetadata::DeserializeFrom(index_meta_page->GetData(), index_meta);
+      if(tables_.count(index_meta->GetTableId())==0){
+        buffer_pool_manager->UnpinPage(index_meta_page->GetPageId(), false);
+        continue;
+      }
       auto table_info=tables_[index_meta->GetTableId()];
       index_names_[table_info->GetTableName()][index_meta->GetIndexName()]=index_meta->GetIndexId();
 
@@ -126,7 +147,7 @@ CatalogManager::~CatalogManager() {
 * TODO: Student Implement
 */
 dberr_t CatalogManager::CreateTable(const string &table_name, TableSchema *schema,
-                                    Transaction *txn, TableInfo *&table_info) {
+                                    Transaction *txn, TableInfo *&table_info, TableLayout layout) {
   if(table_names_.find(table_name)!=table_names_.end()) return DB_ALREADY_EXIST;
   page_id_t page_id;
   auto page=buffer_pool_manager_->NewPage(page_id); //create new page
@@ -136,8 +157,10 @@ dberr_t CatalogManager::CreateTable(const string &table_name, TableSchema *schem
 
   table_info=TableInfo::Create();  //create table info
   auto new_schema=Schema::DeepCopySchema(schema);
-  auto table_heap=TableHeap::Create(buffer_pool_manager_, new_schema, txn, log_manager_, lock_manager_);
-  auto table_meta=TableMetadata::Create(next_table_id_, table_name, table_heap->GetFirstPageId(), new_schema);
+  auto table_heap=TableHeap::Create(buffer_pool_manager_, new_schema, txn, log_manager_, lock_manager_, layout);
+  auto table_meta=TableMetadata::Create(next_table_id_, table_name, table_heap->GetFirstPageId(),
+                                        table_heap->GetFreeSpaceMapPageId(), new_schema, layout,
+                                        table_heap->GetDictionaryPageId(), table_heap->GetZoneMapPageId());
   table_info->Init(table_meta, table_heap);
   tables_[next_table_id_]=table_info; //insert into tables_
 
@@ -205,13 +228,26 @@ dberr_t CatalogManager::CreateIndex(const std::string &table_name, const string
   
   auto table_heap=table_info->GetTableHeap();
   vector<Field> fields;
-  for(auto it=table_heap->Begin(txn); it!=table_heap->End(); it++){
-    fields.clear();
-    for(auto pos: key_map){
-      fields.emplace_back(*(it->GetField(pos)));
+  vector<bool> key_columns(schema->GetColumnCount(), false);
+  for(auto pos: key_map) key_columns[pos]=true;
+  try{
+    for(auto it=table_heap->Begin(txn); it!=table_heap->End(); ++it){
+      table_heap->LoadExternalFields(*it.operator->(), &key_columns);  //keys hold values, not references or codes
+      fields.clear();
+      for(auto pos: key_map){
+        fields.emplace_back(*(it->GetField(pos)));
+      }
+      Row row{fields};
+      index_info->GetIndex()->InsertEntry(row, it->GetRowId(), txn);
     }
-    Row row{fields};
-    index_info->GetIndex()->InsertEntry(row, it->GetRowId(), txn);
+  }
+  catch(const std::exception &ex){  //an index missing rows of the table must not be used
+    LOG(ERROR) << "Cannot build index " << index_name << ": " << ex.what();
+    index_info->GetIndex()->Destroy();
+    DropIndex(table_name, index_name);
+    delete index_info;
+    index_info=nullptr;
+    return DB_FAILED;
   }
   FlushCatalogMetaPage();
   return DB_SUCCESS;
@@ -305,7 +341,9 @@ dberr_t CatalogManager::LoadTable(const table_id_t table_id, const page_id_t pag
   if(page==nullptr) return DB_FAILED;
   TableMetadata *table_meta=nullptr;
   TableMetadata::DeserializeFrom(page->GetData(), table_meta);  //get table_meta
-  auto table_heap=TableHeap::Create(buffer_pool_manager_, page_id, table_meta->GetSchema(), log_manager_, lock_manager_);
+  auto table_heap=TableHeap::Create(buffer_pool_manager_, table_meta->GetFirstPageId(), table_meta->GetFreeSpaceMapPageId(),
+                                    table_meta->GetSchema(), log_manager_, lock_manager_, table_meta->GetLayout(),
+                                    table_meta->GetDictionaryPageId(), table_meta->GetZoneMapPageId());
   auto table_info=TableInfo::Create();
   table_info->Init(table_meta, table_heap);
 
@@ -3,7 +3,7 @@
 uint32_t TableMetadata::SerializeTo(char *buf) const {
     char *p = buf;
     uint32_t ofs = GetSerializedSize();
-    ASSERT(ofs <= PAGE_SIZE, "Failed to serialize table info.");
+    ASSERT(ofs <= PAGE_SIZE - PAGE_CHECKSUM_SIZE, "Failed to serialize table info.");
     // magic num
     MACH_WRITE_UINT32(buf, TABLE_METADATA_MAGIC_NUM);
     buf += 4;
@@ -18,6 +18,18 @@ uint32_t TableMetadata::SerializeTo(char *buf) const {
     // table heap root page id
     MACH_WRITE_TO(page_id_t, buf, root_page_id_);
     buf += 4;
+    // free space map page id
+    MACH_WRITE_TO(page_id_t, buf, free_space_map_page_id_);
+    buf += 4;
+    // page layout
+    MACH_WRITE_UINT32(buf, static_cast<uint32_t>(layout_));
+    buf += 4;
+    // dictionary page id
+    MACH_WRITE_TO(page_id_t, buf, dictionary_page_id_);
+    buf += 4;
+    // zone map page id
+    MACH_WRITE_TO(page_id_t, buf, zone_map_page_id_);
+    buf += 4;
     // table schema
     buf += schema_->SerializeTo(buf);
     ASSERT(buf - p == ofs, "Unexpected serialize size.");
@@ -29,7 +41,7 @@ uint32_t TableMetadata::SerializeTo(char *buf) const {
  * TODO: Student Implement
  */
 uint32_t TableMetadata::GetSerializedSize() const {
-    uint32_t size=16;
+    uint32_t size=32;
     size += table_name_.length();
     size += schema_->GetSerializedSize();
     return size;
@@ -55,11 +67,24 @@ uint32_t TableMetadata::DeserializeFrom(char *buf, TableMetadata *&table_meta) {
     // table heap root page id
     page_id_t root_page_id = MACH_READ_FROM(page_id_t, buf);
     buf += 4;
+    // free space map page id
+    page_id_t free_space_map_page_id = MACH_READ_FROM(page_id_t, buf);
+    buf += 4;
+    // page layout
+    auto layout = static_cast<TableLayout>(MACH_READ_UINT32(buf));
+    buf += 4;
+    // dictionary page id
+    page_id_t dictionary_page_id = MACH_READ_FROM(page_id_t, buf);
+    buf += 4;
+    // zone map page id
+    page_id_t zone_map_page_id = MACH_READ_FROM(page_id_t, buf);
+    buf += 4;
     // table schema
     TableSchema *schema = nullptr;
     buf += TableSchema::DeserializeFrom(buf, schema);
     // allocate space for table metadata
-    table_meta = new TableMetadata(table_id, table_name, root_page_id, schema);
+    table_meta = new TableMetadata(table_id, table_name, root_page_id, free_space_map_page_id, schema, layout,
+                                   dictionary_page_id, zone_map_page_id);
     return buf - p;
 }
 
@@ -69,10 +94,21 @@ uint32_t TableMetadata::DeserializeFrom(char *buf, TableMetadata *&table_meta) {
  * @param heap Memory heap passed by TableInfo
  */
 TableMetadata *TableMetadata::Create(table_id_t table_id, std::string table_name, page_id_t root_page_id,
-                                     TableSchema *schema) {
+                                     page_id_t free_space_map_page_id, TableSchema *schema, TableLayout layout,
+                                     page_id_t dictionary_page_id, page_id_t zone_map_page_id) {
   // allocate space for table metadata
-  return new TableMetadata(table_id, table_name, root_page_id, schema);
+  return new TableMetadata(table_id, table_name, root_page_id, free_space_map_page_id, schema, layout,
+                           dictionary_page_id, zone_map_page_id);
 }
 
-TableMetadata::TableMetadata(table_id_t table_id, std::string table_name, page_id_t root_page_id, TableSchema *schema)
-    : table_id_(table_id), table_name_(table_name), root_page_id_(root_page_id), schema_(schema) {}
+TableMetadata::TableMetadata(table_id_t table_id, std::string table_name, page_id_t root_page_id,
+                             page_id_t free_space_map_page_id, TableSchema *schema, TableLayout layout,
+                             page_id_t dictionary_page_id, page_id_t zone_map_page_id)
+    : table_id_(table_id),
+      table_name_(table_name),
+      root_page_id_(root_page_id),
+      free_space_map_page_id_(free_space_map_page_id),
+      layout_(layout),
+      dictionary_page_id_(dictionary_page_id),
+      zone_map_page_id_(zone_map_page_id),
+      schema_(schema) {}
@@ -0,0 +1,69 @@
+#include "common/crc32c.h"
+
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#define MINISQL_CRC32C_SSE42
+#endif
+
+static constexpr uint32_t CRC32C_POLY = 0x82F63B78;  // reversed Castagnoli polynomial
+
+static constexpr std::array<uint32_t, 256> MakeCrc32cTable() {
+  std::array<uint32_t, 256> table{};
+  for (uint32_t i = 0; i < 256; i++) {
+    uint32_t crc = i;
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc >> 1) ^ ((crc & 1) != 0 ? CRC32C_POLY : 0);
+    }
+    table[i] = crc;
+  }
+  return table;
+}
+
+static constexpr std::array<uint32_t, 256> CRC32C_TABLE = MakeCrc32cTable();
+
+uint32_t Crc32cSoftware(const char *data, size_t size) {
+  uint32_t crc = ~0U;
+  auto bytes = reinterpret_cast<const uint8_t *>(data);
+  for (size_t i = 0; i < size; i++) {
+    crc = (crc >> 8) ^ CRC32C_TABLE[(crc ^ bytes[i]) & 0xFF];
+  }
+  return ~crc;
+}
+
+#ifdef MINISQL_CRC32C_SSE42
+__attribute__((target("sse4.2"))) static uint32_t Crc32cHardware(const char *data, size_t size) {
+  uint64_t crc = ~0U;
+  size_t i = 0;
+  for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+    uint64_t word;
+    memcpy(&word, data + i, sizeof(word));
+    crc = _mm_crc32_u64(crc, word);
+  }
+  auto crc32 = static_cast<uint32_t>(crc);
+  for (; i < size; i++) {
+    crc32 = _mm_crc32_u8(crc32, static_cast<uint8_t>(data[i]));
+  }
+  return ~crc32;
+}
+#endif
+
+bool Crc32cHardwareSupported() {
+#ifdef MINISQL_CRC32C_SSE42
+  static const bool supported = __builtin_cpu_supports("sse4.2");
+  return supported;
+#else
+  return false;
+#endif
+}
+
+uint32_t Crc32c(const char *data, size_t size) {
+#ifdef MINISQL_CRC32C_SSE42
+  if (Crc32cHardwareSupported()) {
+    return Crc32cHardware(data, size);
+  }
+#endif
+  return Crc32cSoftware(data, size);
+}
@@ -3,16 +3,24 @@
 //
 #include "common/instance.h"
 
-DBStorageEngine::DBStorageEngine(std::string db_name, bool init, uint32_t buffer_pool_size)
+#include <algorithm>
+
+DBStorageEngine::DBStorageEngine(std::string db_name, bool init, uint32_t buffer_pool_size,
+                                 uint32_t buffer_pool_instances, ReplacerType replacer_type, IOBackend io_backend,
+                                 uint32_t page_size, bool direct_io, bool huge_pages)
     : db_file_name_(std::move(db_name)), init_(init) {
   // Init database file if needed
   db_file_name_ = "./databases/"+db_file_name_;
   if (init_) {
     remove(db_file_name_.c_str());
+    remove(GetResidentPagesFileName().c_str());
   }
   // Initialize components
-  disk_mgr_ = new DiskManager(db_file_name_);
-  bpm_ = new BufferPoolManager(buffer_pool_size, disk_mgr_);
+  disk_mgr_ = new DiskManager(db_file_name_, io_backend, page_size, direct_io);
+  // keep the memory of the pool, not its number of frames
+  size_t frames = static_cast<size_t>(buffer_pool_size) * PAGE_SIZE / disk_mgr_->GetPageSize();
+  frames = std::max<size_t>(frames, buffer_pool_instances);
+  bpm_ = new BufferPoolManager(frames, disk_mgr_, buffer_pool_instances, replacer_type, huge_pages);
 
   // Allocate static page for db storage engine
   if (init) {
@@ -39,14 +47,69 @@ DBStorageEngine::DBStorageEngine(std::string db_name, bool init, uint32_t buffer
     ASSERT(!bpm_->IsPageFree(INDEX_ROOTS_PAGE_ID), "Invalid header page.");
   }
   catalog_mgr_ = new CatalogManager(bpm_, nullptr, nullptr, init);
+  scan_pool_ = new ThreadPool(DEFAULT_SCAN_WORKERS > 0 ? DEFAULT_SCAN_WORKERS : std::thread::hardware_concurrency());
+  // reload what was cached before the last clean shutdown while queries are already served
+  if (!init_) {
+    bpm_->LoadResidentPages(GetResidentPagesFileName());
+  }
+  // keep clean frames available so that queries rarely write a victim back themselves
+  bpm_->StartFlusher();
 }
 
 DBStorageEngine::~DBStorageEngine() {
+  StopVacuum();
+  delete scan_pool_;
   delete catalog_mgr_;
+  bpm_->SaveResidentPages(GetResidentPagesFileName());
   delete bpm_;
   delete disk_mgr_;
 }
 
 std::unique_ptr<ExecuteContext> DBStorageEngine::MakeExecuteContext(Transaction *txn) {
-  return std::make_unique<ExecuteContext>(txn, catalog_mgr_, bpm_);
+  return std::make_unique<ExecuteContext>(txn, catalog_mgr_, bpm_, scan_pool_);
+}
+
+void DBStorageEngine::StartVacuum(uint32_t threshold, uint32_t interval_ms) {
+  if (vacuum_.joinable()) return;
+  vacuum_stop_ = false;
+  vacuum_ = std::thread(&DBStorageEngine::VacuumLoop, this, threshold, interval_ms);
+}
+
+void DBStorageEngine::StopVacuum() {
+  if (!vacuum_.joinable()) return;
+  {
+    std::scoped_lock<std::mutex> lock(vacuum_latch_);
+    vacuum_stop_ = true;
+  }
+  vacuum_cv_.notify_all();
+  vacuum_.join();
+}
+
+uint32_t DBStorageEngine::VacuumTables(uint32_t threshold) {
+  std::vector<TableInfo *> tables;
+  catalog_mgr_->GetTables(tables);
+  uint32_t removed = 0;
+  for (auto table : tables) {
+    auto table_heap = table->GetTableHeap();
+    if (table_heap->GetDeadTupleCount() >= threshold) {
+      try {
+        removed += table_heap->Vacuum();
+      } catch (const std::exception &ex) {
+        LOG(ERROR) << "Vacuum of " << table->GetTableName() << " failed: " << ex.what();
+      }
+    }
+  }
+  return removed;
+}
+
+void DBStorageEngine::VacuumLoop(uint32_t threshold, uint32_t interval_ms) {
+  std::unique_lock<std::mutex> lock(vacuum_latch_);
+  while (!vacuum_cv_.wait_for(lock, std::chrono::milliseconds(interval_ms), [this] { return vacuum_stop_; })) {
+    lock.unlock();
+    {
+      std::scoped_lock<std::mutex> db_lock(latch_);
+      VacuumTables(threshold);
+    }
+    lock.lock();
+  }
 }
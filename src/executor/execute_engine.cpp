@@ -11,7 +11,9 @@ int yyparse(void);
 #include <sys/types.h>
 
 #include <chrono>
+#include <iomanip>
 
+#include "common/crc32c.h"
 #include "common/result_writer.h"
 #include "executor/executors/delete_executor.h"
 #include "executor/executors/index_scan_executor.h"
@@ -41,6 +43,7 @@ ExecuteEngine::ExecuteEngine() {
         stdir->d_name[0] == '.')
       continue;
     dbs_[stdir->d_name] = new DBStorageEngine(stdir->d_name, false);
+    dbs_[stdir->d_name]->StartVacuum();
   }
    **/
   closedir(dir);
@@ -114,6 +117,11 @@ dberr_t ExecuteEngine::Execute(pSyntaxNode ast) {
   unique_ptr<ExecuteContext> context(nullptr);
   if(!current_db_.empty())
     context = dbs_[current_db_]->MakeExecuteContext(nullptr);
+  // keep the background vacuum out while a statement works on the current database
+  std::unique_lock<std::mutex> db_lock;
+  if(!current_db_.empty() && ast->type_!=kNodeCreateDB && ast->type_!=kNodeDropDB && ast->type_!=kNodeShowDB &&
+     ast->type_!=kNodeUseDB && ast->type_!=kNodeExecFile && ast->type_!=kNodeQuit)  //execfile locks per statement
+    db_lock=std::unique_lock<std::mutex>(dbs_[current_db_]->latch_);
   switch (ast->type_) {
     case kNodeCreateDB:
       return ExecuteCreateDatabase(ast, context.get());
@@ -145,6 +153,10 @@ dberr_t ExecuteEngine::Execute(pSyntaxNode ast) {
       return ExecuteExecfile(ast, context.get());
     case kNodeQuit:
       return ExecuteQuit(ast, context.get());
+    case kNodeShowBufferStatus:
+      return ExecuteShowBufferStatus(ast, context.get());
+    case kNodeVacuum:
+      return ExecuteVacuum(ast, context.get());
     default:
       break;
   }
@@ -256,7 +268,17 @@ dberr_t ExecuteEngine::ExecuteCreateDatabase(pSyntaxNode ast, ExecuteContext *co
     cout<<"Database "<<db_name<<" already exists!"<<endl;
     return DB_FAILED;
   }
-  auto db_eng = new DBStorageEngine(db_name, true);  // create a new database
+  uint32_t page_size=PAGE_SIZE;
+  if(ast->child_->next_!=nullptr){ //page_size given
+    page_size=static_cast<uint32_t>(atoi(ast->child_->next_->val_));
+    if(!DiskManager::IsValidPageSize(page_size)){
+      cout<<"Page size must be a power of two from "<<PAGE_SIZE<<" to "<<MAX_PAGE_SIZE<<"."<<endl;
+      return DB_FAILED;
+    }
+  }
+  auto db_eng = new DBStorageEngine(db_name, true, DEFAULT_BUFFER_POOL_SIZE, DEFAULT_BUFFER_POOL_INSTANCES,
+                                    ReplacerType::LRU, IOBackend::SYNC, page_size);  // create a new database
+  db_eng->StartVacuum();  //every statement holds the latch of its database, so the vacuum only runs between them
   dbs_[db_name]=db_eng;
   cout<<"Create "<<db_name<<" succuss."<<endl;
   return DB_SUCCESS;
@@ -345,12 +367,22 @@ dberr_t ExecuteEngine::ExecuteCreateTable(pSyntaxNode ast, ExecuteContext *conte
     return DB_FAILED;
   }
   string table_name(ast->child_->val_), col_name, col_type;
+  TableLayout layout=TableLayout::ROW;
+  auto layout_node=ast->child_->next_->next_;
+  if(layout_node!=nullptr && layout_node->type_==kNodeTableLayout){  //create table ... using pax
+    string layout_name(layout_node->child_->val_);
+    if(layout_name=="pax") layout=TableLayout::PAX;
+    else if(layout_name!="row"){
+      cout<<"Invalid table layout!"<<endl;
+      return DB_FAILED;
+    }
+  }
   TypeId type;
   vector<string> uniques, primarys;
   int index=0, length;
   vector<Column *> columns;
   for(auto ptr=ast->child_->next_->child_; ptr!=nullptr; ptr=ptr->next_){
-    if(ptr->val_==nullptr){ //not unique
+    if(ptr->val_==nullptr || !strcmp(ptr->val_, "encoding")){ //not unique
       col_name=ptr->child_->val_;
       col_type=ptr->child_->next_->val_;
       if(col_type=="int") type=kTypeInt;
@@ -373,6 +405,14 @@ dberr_t ExecuteEngine::ExecuteCreateTable(pSyntaxNode ast, ExecuteContext *conte
       if(type==kTypeInt || type==kTypeFloat) col_ptr=new Column(col_name, type, index++, false, false);
       else col_ptr=new Column(col_name, type, length, index++, false, false);
       columns.emplace_back(col_ptr);
+      if(ptr->val_!=nullptr){  //name char(n) dictionary
+        if(type!=kTypeChar || strcmp(ptr->child_->next_->next_->val_, "dictionary")){
+          cout<<"Invalid column encoding!"<<endl;
+          for(auto column: columns) delete column;
+          return DB_FAILED;
+        }
+        col_ptr->SetDictionaryEncoded(true);
+      }
     }
     else if(!strcmp(ptr->val_, "unique")){
       col_name=ptr->child_->val_;
@@ -417,7 +457,7 @@ dberr_t ExecuteEngine::ExecuteCreateTable(pSyntaxNode ast, ExecuteContext *conte
   auto mgr=dbs_[current_db_]->catalog_mgr_;
   auto schema=new Schema(columns);
   TableInfo *table_info=nullptr;
-  auto res=mgr->CreateTable(table_name, schema, context->GetTransaction(), table_info);
+  auto res=mgr->CreateTable(table_name, schema, context->GetTransaction(), table_info, layout);
   if(res!=DB_SUCCESS) return res;
   table_info->table_meta_->pri_columns_=primarys;
   table_info->table_meta_->uni_columns_=uniques;
@@ -558,18 +598,16 @@ dberr_t ExecuteEngine::ExecuteExecfile(pSyntaxNode ast, ExecuteContext *context)
     cout<<"Fail to open "<<file<<"!"<<endl;
     return DB_FAILED;
   }
-  char c;
-  int i=0;
-  char line[1000];
+  int c;
+  std::string line;  //a statement may hold a long char value
   while((c=in.get())!=EOF){
-    if(c!=';') line[i++]=c;
+    if(c!=';') line.push_back(static_cast<char>(c));
     else{  //end of line
-      line[i++]=';';
-      line[i]=0;
+      line.push_back(';');
       in.get(); //LF
-      i=0;  //clear
       cout<<line<<endl;
-      YY_BUFFER_STATE bp = yy_scan_string(line);
+      YY_BUFFER_STATE bp = yy_scan_string(line.c_str());
+      line.clear();
       if (bp == nullptr) {
         LOG(ERROR) << "Failed to create yy buffer state." << std::endl;
         exit(1);
@@ -607,3 +645,63 @@ dberr_t ExecuteEngine::ExecuteQuit(pSyntaxNode ast, ExecuteContext *context) {
 #endif
   return DB_QUIT;
 }
+
+dberr_t ExecuteEngine::ExecuteShowBufferStatus(pSyntaxNode ast, ExecuteContext *context) {
+#ifdef ENABLE_EXECUTE_DEBUG
+  LOG(INFO) << "ExecuteShowBufferStatus" << std::endl;
+#endif
+  if(current_db_.empty() || dbs_.find(current_db_)==dbs_.end()){
+    cout<<"Current database not exists!"<<endl;
+    return DB_FAILED;
+  }
+  auto db_eng=dbs_[current_db_];
+  auto buffer_stats=db_eng->bpm_->GetStats();
+  auto disk_stats=db_eng->disk_mgr_->GetStats();
+  uint64_t fetches=buffer_stats.hits_+buffer_stats.misses_;
+  double hit_ratio=fetches==0 ? 0 : 100.0*buffer_stats.hits_/fetches;
+  cout<<"Buffer pool of database "<<current_db_<<": "<<db_eng->bpm_->GetPoolSize()<<" frames in "
+      <<db_eng->bpm_->GetNumInstances()<<" instances"<<endl;
+  cout<<"  hits                "<<buffer_stats.hits_<<endl;
+  cout<<"  misses              "<<buffer_stats.misses_<<endl;
+  cout<<"  hit ratio           "<<std::fixed<<std::setprecision(2)<<hit_ratio<<"%"<<endl;
+  cout<<"  evictions           "<<buffer_stats.evictions_<<endl;
+  cout<<"  dirty evictions     "<<buffer_stats.dirty_evictions_<<endl;
+  cout<<"  prefetched pages    "<<buffer_stats.prefetched_pages_<<endl;
+  cout<<"  flushed pages       "<<buffer_stats.flushed_pages_<<endl;
+  cout<<"Disk I/O:"<<endl;
+  cout<<"  pages read          "<<disk_stats.pages_read_<<" ("<<disk_stats.bytes_read_<<" bytes, "
+      <<disk_stats.read_time_us_<<" us)"<<endl;
+  cout<<"  pages written       "<<disk_stats.pages_written_<<" ("<<disk_stats.bytes_written_<<" bytes, "
+      <<disk_stats.write_time_us_<<" us)"<<endl;
+  cout<<"  write requests      "<<disk_stats.write_requests_<<endl;
+  cout<<"  checksum failures   "<<disk_stats.checksum_failures_<<endl;
+  cout<<"  checksum verify     "<<disk_stats.checksum_verify_ns_/1000<<" us ("
+      <<(Crc32cHardwareSupported() ? "SSE4.2" : "software")<<")"<<endl;
+  cout.unsetf(std::ios::floatfield);
+  cout<<"Show buffer status success."<<endl;
+  return DB_SUCCESS;
+}
+
+dberr_t ExecuteEngine::ExecuteVacuum(pSyntaxNode ast, ExecuteContext *context) {
+#ifdef ENABLE_EXECUTE_DEBUG
+  LOG(INFO) << "ExecuteVacuum" << std::endl;
+#endif
+  if(current_db_.empty() || dbs_.find(current_db_)==dbs_.end()){
+    cout<<"Current database not exists!"<<endl;
+    return DB_FAILED;
+  }
+  string table_name(ast->child_->val_);
+  TableInfo *table_info=nullptr;
+  if(dbs_[current_db_]->catalog_mgr_->GetTable(table_name, table_info)!=DB_SUCCESS) return DB_TABLE_NOT_EXIST;
+  uint32_t freed_pages=0;
+  uint32_t removed;
+  try{
+    removed=table_info->GetTableHeap()->Vacuum(&freed_pages);  //the statement lock keeps the vacuum thread out
+  }
+  catch(const exception &ex){
+    cout<<"Vacuum "<<table_name<<" failed: "<<ex.what()<<endl;
+    return DB_FAILED;
+  }
+  cout<<"Vacuum "<<table_name<<": "<<removed<<" deleted rows removed, "<<freed_pages<<" pages freed."<<endl;
+  return DB_SUCCESS;
+}
@@ -14,47 +14,55 @@ InsertExecutor::InsertExecutor(ExecuteContext *exec_ctx, const InsertPlanNode *p
 
 void InsertExecutor::Init() {
   child_executor_->Init();  //init child_executor
-}
-
-bool InsertExecutor::Next(Row *row, RowId *rid) {
-  if(child_executor_->Next(row, rid)){
-    // if(!table_info_->GetTableHeap()->InsertTuple(*row, exec_ctx_->GetTransaction())) return false;
-    for(auto& index_info: indexes_){   //update all the indexes
-      if(index_info->GetIndexName().find("Unique")!=-1){  //index for unique
-        auto pos=index_info->GetIndexKeySchema()->GetColumn(0)->GetTableInd();
-        auto field=row->GetField(pos);  //field of index
-        vector<Field> fields{Field{*field}};
-        Row key=Row{fields};  //construct temporary row
-        vector<RowId> res;
-        index_info->GetIndex()->ScanKey(key, res, exec_ctx_->GetTransaction(), "=");
-        if(res.size()){
-          cout<<"Already exists."<<endl;
-          return false;
-        }
-      }
-      if(index_info->GetIndexName().find("Primary")!=-1){ //index for primary
-        auto pos=index_info->GetIndexKeySchema()->GetColumn(0)->GetTableInd();
-        auto field=row->GetField(pos);
-        vector<Field> fields{Field{*field}};
-        Row key=Row{fields};
-        vector<RowId> res;
-        index_info->GetIndex()->ScanKey(key, res, exec_ctx_->GetTransaction(), "=");
-        if(res.size()){
-          cout<<"Already exists."<<endl;
-          return false;
-        }
-      }
+  rows_.clear();
+  cursor_=0;
+  Row row;
+  RowId rid;
+  while(child_executor_->Next(&row, &rid)){  //collect every row, so they go to the table heap as one batch
+    if(IsDuplicate(row)){
+      cout<<"Already exists."<<endl;
+      break;  //rows before the duplicate are still inserted
     }
-    if(!table_info_->GetTableHeap()->InsertTuple(*row, exec_ctx_->GetTransaction())) return false;
-    for(auto& index_info: indexes_){
+    rows_.push_back(row);
+  }
+  if(rows_.empty()) return;
+  vector<RowId> rids;
+  if(!table_info_->GetTableHeap()->InsertTuples(rows_, rids, exec_ctx_->GetTransaction())) rows_.resize(rids.size());
+  table_info_->GetTableHeap()->ReleaseInsertPage();  //the statement is done inserting, others may fill the page
+  for(auto& r: rows_){
+    for(auto& index_info: indexes_){  //update all the indexes
       auto pos=index_info->GetIndexKeySchema()->GetColumn(0)->GetTableInd();
-      auto field=row->GetField(pos);  //field of index
+      auto field=r.GetField(pos);  //field of index
       vector<Field> fields{Field{*field}};
       Row key=Row{fields};
-      index_info->GetIndex()->InsertEntry(key, row->GetRowId(), exec_ctx_->GetTransaction());
+      index_info->GetIndex()->InsertEntry(key, r.GetRowId(), exec_ctx_->GetTransaction());
     }
+  }
+}
+
+bool InsertExecutor::Next(Row *row, RowId *rid) {
+  if(cursor_<rows_.size()){
+    *row=rows_[cursor_];
     *rid=row->GetRowId();
+    cursor_++;
     return true;
   }
   return false;
-}
\ No newline at end of file
+}
+
+bool InsertExecutor::IsDuplicate(Row &row) {
+  for(auto& index_info: indexes_){
+    if(index_info->GetIndexName().find("Unique")==-1 && index_info->GetIndexName().find("Primary")==-1) continue;
+    auto pos=index_info->GetIndexKeySchema()->GetColumn(0)->GetTableInd();
+    auto field=row.GetField(pos);  //field of index
+    vector<Field> fields{Field{*field}};
+    Row key=Row{fields};  //construct temporary row
+    vector<RowId> res;
+    index_info->GetIndex()->ScanKey(key, res, exec_ctx_->GetTransaction(), "=");
+    if(res.size()) return true;
+    for(auto& r: rows_){  //rows of the same batch are not in the index yet
+      if(r.GetField(pos)->CompareEquals(*field)==CmpBool::kTrue) return true;
+    }
+  }
+  return false;
+}
@@ -3,6 +3,14 @@
 //
 #include "executor/executors/seq_scan_executor.h"
 
+#include <stdexcept>
+#include <string>
+
+#include "planner/expressions/column_value_expression.h"
+#include "planner/expressions/comparison_expression.h"
+#include "planner/expressions/constant_value_expression.h"
+#include "planner/expressions/logic_expression.h"
+
 /**
 * TODO: Student Implement
 */
@@ -13,31 +21,273 @@ SeqScanExecutor::SeqScanExecutor(ExecuteContext *exec_ctx, const SeqScanPlanNode
   exec_ctx->GetCatalog()->GetTable(table_name, table_info_);  //get table_info of this table
 }
 
+/**
+ * Mark the table columns an expression reads.
+ */
+static void MarkColumns(const AbstractExpressionRef &expr, std::vector<bool> &columns) {
+  if(expr->GetType()==ExpressionType::ColumnExpression){
+    columns[std::dynamic_pointer_cast<ColumnValueExpression>(expr)->GetColIdx()]=true;
+  }
+  for(auto &child: expr->GetChildren()) MarkColumns(child, columns);
+}
+
+/**
+ * @return true if expr is an equality or inequality between a dictionary encoded column and a char constant, which
+ * holds for codes as it does for values
+ */
+static bool IsCodeComparison(const AbstractExpressionRef &expr, Schema *schema, uint32_t *column,
+                             uint32_t *constant) {
+  if(expr->GetType()!=ExpressionType::ComparisonExpression) return false;
+  auto comp_type=std::dynamic_pointer_cast<ComparisonExpression>(expr)->GetComparisonType();
+  if(comp_type!="=" && comp_type!="<>") return false;
+  for(uint32_t i=0; i<2; i++){
+    auto &lhs=expr->GetChildAt(i);
+    auto &rhs=expr->GetChildAt(1-i);
+    if(lhs->GetType()!=ExpressionType::ColumnExpression || rhs->GetType()!=ExpressionType::ConstantExpression) continue;
+    *column=std::dynamic_pointer_cast<ColumnValueExpression>(lhs)->GetColIdx();
+    *constant=1-i;
+    auto &val=std::dynamic_pointer_cast<ConstantValueExpression>(rhs)->val_;
+    return schema->GetColumn(*column)->IsDictionaryEncoded() && val.GetTypeId()==kTypeChar && !val.IsNull();
+  }
+  return false;
+}
+
+/**
+ * Mark the table columns an expression reads as values, those only compared by IsCodeComparison are left out.
+ */
+static void MarkValueColumns(const AbstractExpressionRef &expr, Schema *schema, std::vector<bool> &columns) {
+  uint32_t column, constant;
+  if(IsCodeComparison(expr, schema, &column, &constant)) return;
+  if(expr->GetType()==ExpressionType::ColumnExpression){
+    columns[std::dynamic_pointer_cast<ColumnValueExpression>(expr)->GetColIdx()]=true;
+  }
+  for(auto &child: expr->GetChildren()) MarkValueColumns(child, schema, columns);
+}
+
+/**
+ * Copy of a predicate in which the code comparisons of columns not read as values compare the codes in the tuples
+ * with the code of the constant. A constant without a code is kept, it can only equal a value stored inline.
+ */
+static AbstractExpressionRef EncodePredicate(const AbstractExpressionRef &expr, TableHeap *table_heap, Schema *schema,
+                                             const std::vector<bool> &value_columns) {
+  uint32_t column, constant;
+  if(IsCodeComparison(expr, schema, &column, &constant)){
+    uint32_t code;
+    auto &val=std::dynamic_pointer_cast<ConstantValueExpression>(expr->GetChildAt(constant))->val_;
+    if(value_columns[column] || !table_heap->FindCode(column, val, &code)) return expr;
+    auto coded=std::make_shared<ConstantValueExpression>(Field(kTypeChar, DictionaryCode{code}));
+    auto comp_type=std::dynamic_pointer_cast<ComparisonExpression>(expr)->GetComparisonType();
+    if(constant==1) return std::make_shared<ComparisonExpression>(expr->GetChildAt(0), coded, comp_type);
+    return std::make_shared<ComparisonExpression>(coded, expr->GetChildAt(1), comp_type);
+  }
+  if(expr->GetType()==ExpressionType::LogicExpression){
+    auto lhs=EncodePredicate(expr->GetChildAt(0), table_heap, schema, value_columns);
+    auto rhs=EncodePredicate(expr->GetChildAt(1), table_heap, schema, value_columns);
+    return std::make_shared<LogicExpression>(lhs, rhs, std::dynamic_pointer_cast<LogicExpression>(expr)->logic_type_);
+  }
+  return expr;
+}
+
+/**
+ * @return false if the zone map of a page shows that none of its tuples satisfies expr
+ */
+static bool PageMayMatch(const AbstractExpressionRef &expr, TableHeap *table_heap, page_id_t page_id) {
+  if(expr->GetType()==ExpressionType::LogicExpression){
+    bool lhs=PageMayMatch(expr->GetChildAt(0), table_heap, page_id);
+    if(std::dynamic_pointer_cast<LogicExpression>(expr)->logic_type_==LogicType::And){
+      return lhs && PageMayMatch(expr->GetChildAt(1), table_heap, page_id);
+    }
+    return lhs || PageMayMatch(expr->GetChildAt(1), table_heap, page_id);
+  }
+  if(expr->GetType()!=ExpressionType::ComparisonExpression) return true;
+  auto comp_type=std::dynamic_pointer_cast<ComparisonExpression>(expr)->GetComparisonType();
+  auto &lhs=expr->GetChildAt(0);
+  auto &rhs=expr->GetChildAt(1);
+  if(rhs->GetType()==ExpressionType::ColumnExpression && lhs->GetType()==ExpressionType::ConstantExpression){
+    if(comp_type=="is" || comp_type=="not") return true;
+    //constant op column is column op' constant with the operands swapped
+    if(comp_type=="<") comp_type=">";
+    else if(comp_type==">") comp_type="<";
+    else if(comp_type=="<=") comp_type=">=";
+    else if(comp_type==">=") comp_type="<=";
+    auto column=std::dynamic_pointer_cast<ColumnValueExpression>(rhs)->GetColIdx();
+    return table_heap->MayMatch(page_id, column, comp_type,
+                                std::dynamic_pointer_cast<ConstantValueExpression>(lhs)->val_);
+  }
+  if(lhs->GetType()!=ExpressionType::ColumnExpression || rhs->GetType()!=ExpressionType::ConstantExpression){
+    return true;
+  }
+  auto column=std::dynamic_pointer_cast<ColumnValueExpression>(lhs)->GetColIdx();
+  auto &val=std::dynamic_pointer_cast<ConstantValueExpression>(rhs)->val_;
+  return table_heap->MayMatch(page_id, column, comp_type, val);
+}
+
 void SeqScanExecutor::Init() {
-  table_iter_=table_info_->GetTableHeap()->Begin(exec_ctx_->GetTransaction()); //get first table_iterator
-  end_iter_=table_info_->GetTableHeap()->End();  //end of interator
+  StopWorkers();  //a scan started again drops the morsels of the last one
+  auto schema=table_info_->GetSchema();
+  auto table_heap=table_info_->GetTableHeap();
+  // a PAX table only decodes the columns of the output and of the predicate
+  columns_.assign(schema->GetColumnCount(), false);
+  predicate_columns_.assign(schema->GetColumnCount(), false);
+  output_columns_.assign(schema->GetColumnCount(), false);
+  predicate_=plan_->GetPredicate();
+  if(predicate_!=nullptr){
+    MarkColumns(predicate_, columns_);
+    // dictionary columns compared with constants are filtered on their codes, they are not decoded for it
+    MarkValueColumns(predicate_, schema, predicate_columns_);
+    predicate_=EncodePredicate(predicate_, table_heap, schema, predicate_columns_);
+  }
+  for(auto column: plan_->OutputSchema()->GetColumns()){
+    columns_[column->GetTableInd()]=true;
+    output_columns_[column->GetTableInd()]=true;
+  }
+  //pages whose zone map rules out the predicate are skipped without being read
+  page_filter_=nullptr;
+  if(predicate_!=nullptr && table_heap->HasZoneMap()){
+    auto predicate=plan_->GetPredicate();
+    page_filter_=[predicate, table_heap](page_id_t page_id){ return PageMayMatch(predicate, table_heap, page_id); };
+  }
+  size_t workers=exec_ctx_->GetScanWorkers();
+  parallel_=workers>1 && table_heap->GetPageCount()>=static_cast<size_t>(PARALLEL_SCAN_MIN_PAGES);
+  if(parallel_){
+    StartWorkers(workers);
+    return;
+  }
+  // a full scan must not push the pages of other queries out of the buffer pool
+  table_iter_=table_heap->Begin(exec_ctx_->GetTransaction(), &strategy_, &columns_,
+                                page_filter_ ? &page_filter_ : nullptr); //first iterator
+  end_iter_=table_heap->End();  //end of interator
 }
 
 bool SeqScanExecutor::Next(Row *row, RowId *rid) {
-  if(plan_->GetPredicate()!=nullptr){ //has predicate
-    while(1){
-      if(table_iter_==end_iter_) return false;
-      *row=*table_iter_;
+  if(parallel_) return NextParallel(row, rid);
+  while(1){
+    if(table_iter_==end_iter_) return false;
+    bool matched=Produce(*table_iter_.operator->(), row);
+    ++table_iter_;
+    if(matched){
       *rid=row->GetRowId();
-      row->GetKeyFromRow(table_info_->GetSchema(), plan_->OutputSchema(), *row);
-      row->SetRowId(*rid);
-      table_iter_++;
-      if(plan_->GetPredicate()->Evaluate(row).CompareEquals(Field(kTypeInt, 1))) break;
+      return true;
     }
-    return true;
   }
-  else{ //no predicate
-    if(table_iter_==end_iter_) return false;
-    *row=*table_iter_;
-    *rid=row->GetRowId();
-    row->GetKeyFromRow(table_info_->GetSchema(), plan_->OutputSchema(), *row);
-    row->SetRowId(*rid);
-    table_iter_++;
-    return true;
+}
+
+bool SeqScanExecutor::Produce(Row &scanned, Row *row) const {
+  auto table_heap=table_info_->GetTableHeap();
+  //the predicate refers to the columns of the table, so it is evaluated before the projection
+  if(predicate_!=nullptr){
+    table_heap->LoadExternalFields(scanned, &predicate_columns_);
+    if(!predicate_->Evaluate(&scanned).CompareEquals(Field(kTypeInt, 1))) return false;
+  }
+  //only the projected long chars and codes are read
+  table_heap->LoadExternalFields(scanned, &output_columns_);
+  scanned.GetKeyFromRow(table_info_->GetSchema(), plan_->OutputSchema(), *row);
+  row->SetRowId(scanned.GetRowId());
+  return true;
+}
+
+bool SeqScanExecutor::NextParallel(Row *row, RowId *rid) {
+  std::unique_lock<std::mutex> lock(latch_);
+  while(current_morsel_<morsels_.size()){
+    auto &morsel=morsels_[current_morsel_];
+    if(!morsel.done_ && next_morsel_==current_morsel_ && error_==nullptr){  //no worker has it, scan it here
+      size_t m=next_morsel_++;
+      lock.unlock();
+      std::deque<Row> rows;
+      ScanMorsel(m, &strategy_, &rows);
+      lock.lock();
+      morsel.rows_.swap(rows);
+      morsel.done_=true;
+    }
+    cv_.wait(lock, [&]{ return morsel.done_ || error_!=nullptr; });
+    if(error_!=nullptr){  //the failure of a worker ends the scan like one on this thread
+      auto error=error_;
+      lock.unlock();
+      StopWorkers();
+      std::rethrow_exception(error);
+    }
+    if(!morsel.rows_.empty()){
+      *row=morsel.rows_.front();
+      morsel.rows_.pop_front();
+      *rid=row->GetRowId();
+      return true;
+    }
+    current_morsel_++;
+    SubmitWorkers();  //the window moved on, workers that returned at its end may take another morsel
+  }
+  lock.unlock();
+  StopWorkers();
+  return false;
+}
+
+void SeqScanExecutor::StartWorkers(size_t workers) {
+  // vacuum runs between statements, so no page of the list is freed while the scan goes on
+  pages_=table_info_->GetTableHeap()->GetPageIds();
+  morsels_.clear();
+  morsels_.resize((pages_.size()+SCAN_MORSEL_PAGES-1)/SCAN_MORSEL_PAGES);
+  next_morsel_=0;
+  current_morsel_=0;
+  stop_=false;
+  error_=nullptr;
+  workers_=std::min(workers, morsels_.size());
+  window_=2*workers_;
+  std::scoped_lock<std::mutex> lock(latch_);
+  SubmitWorkers();
+}
+
+void SeqScanExecutor::SubmitWorkers() {
+  size_t available=std::min(morsels_.size(), current_morsel_+window_)-std::min(next_morsel_, current_morsel_+window_);
+  while(!stop_ && running_<std::min(workers_, available)){
+    running_++;
+    exec_ctx_->GetScanPool()->Submit([this]{ ScanMorsels(); });
+  }
+}
+
+void SeqScanExecutor::StopWorkers() {
+  std::unique_lock<std::mutex> lock(latch_);
+  stop_=true;
+  cv_.wait(lock, [this]{ return running_==0; });  //the workers use this executor until they return
+}
+
+void SeqScanExecutor::ScanMorsels() {
+  BufferAccessStrategy strategy;  //each worker cycles through a ring of its own
+  std::unique_lock<std::mutex> lock(latch_);
+  while(!stop_ && next_morsel_<morsels_.size() && next_morsel_<current_morsel_+window_){
+    size_t m=next_morsel_++;
+    lock.unlock();
+    std::deque<Row> rows;
+    try{
+      ScanMorsel(m, &strategy, &rows);
+    }
+    catch(...){
+      lock.lock();
+      error_=std::current_exception();
+      stop_=true;
+      break;
+    }
+    lock.lock();
+    morsels_[m].rows_.swap(rows);
+    morsels_[m].done_=true;
+    cv_.notify_all();
+  }
+  running_--;  //the thread goes back to the pool
+  cv_.notify_all();
+}
+
+void SeqScanExecutor::ScanMorsel(size_t m, BufferAccessStrategy *strategy, std::deque<Row> *rows) {
+  auto table_heap=table_info_->GetTableHeap();
+  std::deque<Row> scanned;
+  size_t end=std::min(pages_.size(), (m+1)*SCAN_MORSEL_PAGES);
+  for(size_t i=m*SCAN_MORSEL_PAGES; i<end; i++){
+    if(page_filter_ && !page_filter_(pages_[i])) continue;
+    // decoded under the page latch, the overflow pages of long chars are read after it is released
+    if(!table_heap->ScanPage(pages_[i], strategy, &columns_, &scanned)){  //fails the query like a serial scan does
+      throw std::runtime_error("Cannot read page "+std::to_string(pages_[i])+" of the table");
+    }
+    for(auto &row: scanned){
+      rows->emplace_back();
+      if(!Produce(row, &rows->back())) rows->pop_back();
+    }
+    scanned.clear();
   }
 }
@@ -12,6 +12,8 @@ UpdateExecutor::UpdateExecutor(ExecuteContext *exec_ctx, const UpdatePlanNode *p
   exec_ctx_->GetCatalog()->GetTableIndexes(table_info_->GetTableName(), indexes_);  //get all the indexes on this table
 }
 
+UpdateExecutor::~UpdateExecutor() { table_info_->GetTableHeap()->ReleaseInsertPage(); }
+
 /**
 * TODO: Student Implement
 */
@@ -0,0 +1,49 @@
+#ifndef MINISQL_BUFFER_ACCESS_STRATEGY_H
+#define MINISQL_BUFFER_ACCESS_STRATEGY_H
+
+#include <algorithm>
+#include <deque>
+#include <vector>
+
+#include "common/config.h"
+
+using namespace std;
+
+/**
+ * BufferAccessStrategy is the bulk read strategy of a large sequential scan.
+ *
+ * Pages a scan reads from disk through a strategy are remembered in a small ring. Once the ring is full, the next
+ * page read recycles the frame of the oldest ring page instead of asking the replacer for a victim, so the scan
+ * cycles through ring_size frames and leaves the rest of the pool, e.g. the pages of concurrent point queries, alone.
+ * A ring page that somebody else pinned meanwhile is left to the replacer.
+ *
+ * Frames belong to buffer pool instances, so the ring is split into one part per instance.
+ * A strategy belongs to a single scan and is not thread safe.
+ */
+class BufferAccessStrategy {
+ public:
+  struct Ring {
+    size_t capacity_;         // maximum number of pages in this part of the ring
+    deque<page_id_t> pages_;  // pages read through the strategy, oldest first
+  };
+
+  explicit BufferAccessStrategy(size_t ring_size = DEFAULT_BULK_READ_RING_SIZE) : ring_size_(ring_size) {}
+
+  inline size_t GetRingSize() const { return ring_size_; }
+
+  /**
+   * @return the part of the ring that holds frames of the given buffer pool instance
+   */
+  Ring *GetRing(size_t instance_index, size_t num_instances) {
+    if (rings_.size() != num_instances) {
+      rings_.assign(num_instances, Ring{max<size_t>(1, ring_size_ / num_instances), {}});
+    }
+    return &rings_[instance_index];
+  }
+
+ private:
+  size_t ring_size_;    // total number of frames the scan cycles through
+  vector<Ring> rings_;  // one part of the ring per buffer pool instance
+};
+
+#endif  // MINISQL_BUFFER_ACCESS_STRATEGY_H
@@ -0,0 +1,196 @@
+#ifndef MINISQL_BUFFER_POOL_INSTANCE_H
+#define MINISQL_BUFFER_POOL_INSTANCE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "buffer/buffer_access_strategy.h"
+#include "buffer/clock_replacer.h"
+#include "buffer/lru_k_replacer.h"
+#include "buffer/lru_replacer.h"
+#include "page/page.h"
+#include "storage/disk_manager.h"
+
+using namespace std;
+
+/**
+ * Reads the id of the next page of a page chain out of a page's data, e.g. the next table page or the next leaf.
+ */
+using NextPageIdFunc = page_id_t (*)(const char *page_data);
+
+/**
+ * Snapshot of buffer pool counters, summed over all instances by BufferPoolManager.
+ */
+struct BufferPoolStats {
+  uint64_t hits_{0};              // FetchPage found the page resident
+  uint64_t misses_{0};            // FetchPage had to read the page
+  uint64_t evictions_{0};         // resident pages replaced by another page
+  uint64_t dirty_evictions_{0};   // evictions that had to write the victim first
+  uint64_t prefetched_pages_{0};  // pages read by read-ahead
+  uint64_t flushed_pages_{0};     // pages written back by the flusher and FlushAllPages
+};
+
+/**
+ * BufferPoolInstance is one partition of the buffer pool. It owns a fixed set of frames, its own page table,
+ * free list and replacer, and protects them with its own latch, so that instances never contend with each other.
+ * Which instance a page lives in is decided by BufferPoolManager.
+ */
+class BufferPoolInstance {
+ public:
+  /**
+   * @param huge_pages whether to back the frames with huge pages, see AllocateFrames
+   */
+  explicit BufferPoolInstance(size_t pool_size, DiskManager *disk_manager,
+                              ReplacerType replacer_type = ReplacerType::LRU, bool huge_pages = false);
+
+  ~BufferPoolInstance();
+
+  /**
+   * Fetch and pin a page. A page that is not resident is read without holding the instance latch.
+   * @param ring if not null, a page read from disk takes a frame of this bulk read ring, see BufferAccessStrategy
+   * @return the page, or nullptr if no frame is free or the page failed checksum verification
+   */
+  Page *FetchPage(page_id_t page_id, BufferAccessStrategy::Ring *ring = nullptr);
+
+  bool UnpinPage(page_id_t page_id, bool is_dirty);
+
+  bool FlushPage(page_id_t page_id);
+
+  /**
+   * Bring a freshly allocated page into this instance.
+   * @param page_id logical page id already allocated by the disk manager
+   * @return the pinned, zeroed page, or nullptr if every frame of this instance is pinned
+   */
+  Page *NewPage(page_id_t page_id);
+
+  bool DeletePage(page_id_t page_id);
+
+  /**
+   * Bring a page into this instance without pinning it, reading it from disk if it is not resident yet.
+   * The read itself is done without holding the instance latch.
+   * @param page_id page to load
+   * @param next_page_id extracts the next page of the chain from the loaded page
+   * @return the next page id of the chain, INVALID_PAGE_ID if the chain ends or no frame could be found
+   */
+  page_id_t Prefetch(page_id_t page_id, NextPageIdFunc next_page_id);
+
+  /**
+   * Bring the pages that are not resident yet into this instance without pinning them, with one batch read.
+   * Stops reserving frames once no frame can be found.
+   * @return the number of pages read
+   */
+  size_t PrefetchPages(const vector<page_id_t> &page_ids);
+
+  /**
+   * Write back unpinned dirty pages until at least min_clean_frames frames could be reused without a write.
+   * Pages are written in physical order with adjacent pages coalesced; foreground requests keep running meanwhile.
+   * @return the number of pages written
+   */
+  size_t FlushDirtyPages(size_t min_clean_frames);
+
+  /**
+   * Write back every dirty page, pinned or not, in physical order.
+   */
+  void FlushAllPages();
+
+  bool CheckAllUnpinned();
+
+  /**
+   * Append the pages resident in this instance, hottest first: pinned pages, then the others from the last victim
+   * to the next one.
+   */
+  void GetResidentPages(vector<page_id_t> *page_ids);
+
+  inline size_t GetPoolSize() const { return pool_size_; }
+
+  /**
+   * Add the counters of this instance to stats.
+   */
+  void AddStats(BufferPoolStats *stats) const;
+
+  /** @return whether the frames are on reserved huge pages, false if huge pages were not asked for or not available */
+  inline bool IsHugePageBacked() const { return huge_page_backed_; }
+
+ private:
+  /**
+   * Map zeroed, page aligned memory for the frames. With huge_pages it takes reserved huge pages if the system has
+   * enough of them, and otherwise asks for transparent huge pages. Sets frames_, frames_size_ and huge_page_backed_.
+   */
+  void AllocateFrames(size_t size, bool huge_pages);
+
+  /**
+   * Pick a frame from the free list or the replacer, writing the victim back if dirty, see WriteBackVictim.
+   * Caller must hold latch_ through lock. As the latch may have been released meanwhile, the caller has to look up
+   * the page it wants the frame for again.
+   * @return true if a frame was found
+   */
+  bool FindVictimFrame(frame_id_t *frame_id, std::unique_lock<std::mutex> *lock);
+
+  /**
+   * Write a dirty victim back with latch_ released. Until the write is done the frame is in flushing_ and its page
+   * in evicting_, so that nobody reads the page from disk before its last changes are there. Caller must hold latch_
+   * through lock and have taken the frame out of the page table, the replacer and prefetched_.
+   */
+  void WriteBackVictim(frame_id_t frame_id, page_id_t page_id, std::unique_lock<std::mutex> *lock);
+
+  /**
+   * Drop the page of a frame whose content cannot be used, e.g. it failed checksum verification, and put the frame
+   * back on the free list. Caller must hold latch_.
+   */
+  void DiscardFrame(frame_id_t frame_id);
+
+  /**
+   * Take the frame of the oldest page of a full ring that is not in use, writing it back if dirty. Ring pages that
+   * are gone or pinned by someone else leave the ring. Caller must hold latch_ through lock, which is released while
+   * a dirty page is written back, like in FindVictimFrame.
+   * @return true if a frame was recycled
+   */
+  bool RecycleRingFrame(BufferAccessStrategy::Ring *ring, frame_id_t *frame_id, std::unique_lock<std::mutex> *lock);
+
+  /**
+   * Append a page to a ring, the oldest page leaves the ring if it is full. Caller must hold latch_.
+   */
+  void AddToRing(BufferAccessStrategy::Ring *ring, page_id_t page_id);
+
+  /**
+   * Read the next page id out of a resident page that someone else may be using, under the page's read latch.
+   * Caller must hold latch_ through lock, which is released while the page is latched.
+   */
+  page_id_t ReadNextPageId(frame_id_t frame_id, NextPageIdFunc next_page_id, std::unique_lock<std::mutex> *lock);
+
+  /**
+   * Write the given frames, which the caller has put into flushing_, and hand them back. Must be called without
+   * holding latch_.
+   */
+  void WriteFlushingFrames(const vector<frame_id_t> &frames);
+
+ private:
+  size_t pool_size_;                                 // number of pages in this instance
+  Page *pages_;                                      // array of pages
+  char *frames_;                                     // data of the pages, one page size after the other
+  size_t frames_size_;                               // bytes mapped for frames_, rounded up to whole huge pages
+  bool huge_page_backed_{false};                     // frames_ is on reserved huge pages
+  DiskManager *disk_manager_;                        // pointer to the disk manager.
+  unordered_map<page_id_t, frame_id_t> page_table_;  // to keep track of pages
+  Replacer *replacer_;                               // to find an unpinned page for replacement
+  list<frame_id_t> free_list_;                       // to find a free page for replacement
+  unordered_set<frame_id_t> flushing_;               // frames being written back, they must not be evicted
+  unordered_set<frame_id_t> loading_;                // frames being read in, not usable yet
+  unordered_set<page_id_t> evicting_;                // evicted pages still being written back, not readable yet
+  unordered_set<frame_id_t> prefetched_;             // frames loaded by Prefetch and not fetched since
+  condition_variable io_cv_;                         // signalled when frames leave flushing_ or loading_
+  mutex latch_;                                      // to protect shared data structure
+  // counters, written under latch_ but read without it
+  atomic<uint64_t> hits_{0};
+  atomic<uint64_t> misses_{0};
+  atomic<uint64_t> evictions_{0};
+  atomic<uint64_t> dirty_evictions_{0};
+  atomic<uint64_t> prefetched_pages_{0};
+  atomic<uint64_t> flushed_pages_{0};
+};
+
+#endif  // MINISQL_BUFFER_POOL_INSTANCE_H
@@ -1,30 +1,59 @@
 #ifndef MINISQL_BUFFER_POOL_MANAGER_H
 #define MINISQL_BUFFER_POOL_MANAGER_H
 
-#include <list>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <mutex>
-#include <unordered_map>
+#include <string>
+#include <thread>
+#include <vector>
 
-#include "buffer/lru_replacer.h"
+#include "buffer/buffer_pool_instance.h"
 #include "page/disk_file_meta_page.h"
 #include "page/page.h"
 #include "storage/disk_manager.h"
 
 using namespace std;
 
+/**
+ * BufferPoolManager splits its frames into several independent BufferPoolInstances and routes every request to the
+ * instance chosen by the page id, so that threads working on different pages do not serialize on one latch.
+ */
 class BufferPoolManager {
  public:
-  explicit BufferPoolManager(size_t pool_size, DiskManager *disk_manager);
+  /**
+   * @param huge_pages whether to back the frames with huge pages: reserved ones if the system has enough, otherwise
+   * transparent huge pages where the kernel allows them
+   */
+  explicit BufferPoolManager(size_t pool_size, DiskManager *disk_manager,
+                             size_t num_instances = DEFAULT_BUFFER_POOL_INSTANCES,
+                             ReplacerType replacer_type = ReplacerType::LRU, bool huge_pages = DEFAULT_HUGE_PAGES);
 
   ~BufferPoolManager();
 
-  Page *FetchPage(page_id_t page_id);
+  /**
+   * Fetch and pin a page.
+   * @param strategy bulk read strategy of a large scan, or nullptr to go through the replacer as usual
+   * @return the page, or nullptr if no frame is free or the page failed checksum verification
+   */
+  Page *FetchPage(page_id_t page_id, BufferAccessStrategy *strategy = nullptr);
 
   bool UnpinPage(page_id_t page_id, bool is_dirty);
 
   bool FlushPage(page_id_t page_id);
 
-  Page *NewPage(page_id_t &page_id);
+  /**
+   * Allocate a page on disk and bring it into the pool, pinned and zeroed. If the instance the page id belongs to has
+   * no frame to spare, another page id is tried, so the call only fails when every instance is full.
+   * @param reservation if not null, the page is taken from the caller's reservation, see ExtentReservation
+   */
+  Page *NewPage(page_id_t &page_id, ExtentReservation *reservation = nullptr);
+
+  /**
+   * Give the pages of a reservation that were not used back to the disk manager.
+   */
+  void ReleaseReservation(ExtentReservation *reservation);
 
   bool DeletePage(page_id_t page_id);
 
@@ -32,27 +61,125 @@ class BufferPoolManager {
 
   bool CheckAllUnpinned();
 
+  /**
+   * Write back every dirty page of every instance, sorted and coalesced by physical position.
+   */
+  void FlushAllPages();
+
+  /**
+   * Start the background flusher. Every interval_ms it writes back unpinned dirty pages of each instance until at
+   * least clean_ratio of its frames can be reused without a synchronous write.
+   */
+  void StartFlusher(double clean_ratio = DEFAULT_FLUSHER_CLEAN_RATIO,
+                    uint32_t interval_ms = DEFAULT_FLUSHER_INTERVAL_MS);
+
+  /**
+   * Stop the background flusher and wait for it to exit. Does nothing if it is not running.
+   */
+  void StopFlusher();
+
+  /**
+   * Ask the background reader to bring up to count pages of a page chain into the pool, starting at page_id and
+   * following next_page_id. The pages are not pinned, they only save the synchronous read of a later FetchPage.
+   * Returns at once; the request is dropped if too many are pending.
+   */
+  void ReadAhead(page_id_t page_id, size_t count, NextPageIdFunc next_page_id);
+
+  /**
+   * Wait until every pending read-ahead request and warm-up page has been served.
+   */
+  void DrainReadAhead();
+
+  /**
+   * @return the resident pages, hottest first, taking turns between the instances
+   */
+  vector<page_id_t> GetResidentPages();
+
+  /**
+   * Write the resident page list to file_name, so that the next process can warm up the pool with it.
+   * @return false if the file could not be written
+   */
+  bool SaveResidentPages(const std::string &file_name);
+
+  /**
+   * Read a list written by SaveResidentPages, delete the file and start loading the pages in the background.
+   * @return false if there is no such file
+   */
+  bool LoadResidentPages(const std::string &file_name);
+
+  /**
+   * Load pages into the pool in the background, in physical order, without pinning them. Read-ahead requests of
+   * running scans are served first. At most as many pages as the pool has frames are loaded, hottest first.
+   * @param page_ids pages to load, hottest first
+   */
+  void WarmUp(vector<page_id_t> page_ids);
+
+  /**
+   * @return the counters of all instances added up, read without taking any latch
+   */
+  BufferPoolStats GetStats() const;
+
+  /** @return the number of buffer pool instances */
+  inline size_t GetNumInstances() const { return instances_.size(); }
+
+  /** @return the total number of frames */
+  inline size_t GetPoolSize() const { return pool_size_; }
+
+  /** @return whether the frames of every instance are on reserved huge pages */
+  bool IsHugePageBacked() const;
+
+  /** @return the page size of the database, the size of every frame */
+  inline uint32_t GetPageSize() const { return disk_manager_->GetPageSize(); }
+
  private:
   /**
    * Allocate new page (operations like create index/table) For now just keep an increasing counter
    */
-  page_id_t AllocatePage();
+  page_id_t AllocatePage(ExtentReservation *reservation = nullptr);
 
   /**
    * Deallocate page (operations like drop index/table) Need bitmap in header page for tracking pages
    */
   void DeallocatePage(page_id_t page_id);
 
-  frame_id_t TryToFindFreePage();
+  /**
+   * Body of the background flusher thread
+   */
+  void FlusherLoop(double clean_ratio, uint32_t interval_ms);
+
+  /**
+   * Body of the background read-ahead thread
+   */
+  void ReadAheadLoop();
+
+  /**
+   * @return the instance responsible for page_id
+   */
+  inline BufferPoolInstance *GetInstance(page_id_t page_id) { return instances_[GetInstanceIndex(page_id)]; }
+
+  inline size_t GetInstanceIndex(page_id_t page_id) const { return static_cast<uint32_t>(page_id) % instances_.size(); }
 
  private:
-  size_t pool_size_;                                 // number of pages in buffer pool
-  Page *pages_;                                      // array of pages
-  DiskManager *disk_manager_;                        // pointer to the disk manager.
-  unordered_map<page_id_t, frame_id_t> page_table_;  // to keep track of pages
-  Replacer *replacer_;                               // to find an unpinned page for replacement
-  list<frame_id_t> free_list_;                       // to find a free page for replacement
-  recursive_mutex latch_;                            // to protect shared data structure
+  size_t pool_size_;                        // number of pages in buffer pool
+  DiskManager *disk_manager_;               // pointer to the disk manager.
+  vector<BufferPoolInstance *> instances_;  // partitions of the buffer pool
+  thread flusher_;                          // background dirty page writer
+  bool flusher_stop_{false};                // tells the flusher to exit
+  mutex flusher_latch_;                     // protects flusher_stop_
+  condition_variable flusher_cv_;           // wakes the flusher up early when it has to stop
+
+  struct ReadAheadRequest {
+    page_id_t page_id_;
+    size_t count_;
+    NextPageIdFunc next_page_id_;
+  };
+  thread reader_;                           // background read-ahead thread, started on first use
+  deque<ReadAheadRequest> read_ahead_;      // pending read-ahead requests
+  deque<page_id_t> warm_up_;                // pages still to be loaded by WarmUp, in physical order
+  bool reader_busy_{false};                 // the reader is serving a request
+  bool reader_stop_{false};                 // tells the reader to exit
+  mutex reader_latch_;                      // protects the reader state above
+  condition_variable reader_cv_;            // signals new requests, served requests and stop
 };
 
 #endif  // MINISQL_BUFFER_POOL_MANAGER_H
@@ -36,6 +36,8 @@ class CLOCKReplacer : public Replacer {
 
   void Unpin(frame_id_t frame_id) override;
 
+  void GetVictimOrder(vector<frame_id_t> *frames) override;
+
   size_t Size() override;
 
  private:
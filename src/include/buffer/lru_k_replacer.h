@@ -0,0 +1,73 @@
+#ifndef MINISQL_LRU_K_REPLACER_H
+#define MINISQL_LRU_K_REPLACER_H
+
+#include <list>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+
+using namespace std;
+
+/**
+ * LRUKReplacer implements the LRU-K replacement policy.
+ *
+ * The victim is the evictable frame with the largest backward k-distance, i.e. the largest gap between now and its
+ * k-th most recent access. Frames with fewer than k accesses have an infinite distance and are evicted first, oldest
+ * first access first. A page read once by a sequential scan therefore leaves before a page that is looked up again
+ * and again, such as the upper levels of a B+ tree.
+ *
+ * Accesses are recorded by Pin. Consecutive accesses to the same frame with no other frame accessed in between are
+ * correlated (e.g. a scan reading every tuple of one page) and count as a single access. A frame that enters the
+ * replacer through Unpin without ever being pinned, such as a page brought in by read-ahead, gets a placeholder
+ * access that the first real access replaces, so a prefetched page read once is still a single-access page.
+ */
+class LRUKReplacer : public Replacer {
+ public:
+  /**
+   * Create a new LRUKReplacer.
+   * @param num_pages the maximum number of pages the LRUKReplacer will be required to store
+   * @param k the number of most recent accesses remembered per frame
+   */
+  explicit LRUKReplacer(size_t num_pages, size_t k = 2);
+
+  /**
+   * Destroys the LRUKReplacer.
+   */
+  ~LRUKReplacer() override;
+
+  bool Victim(frame_id_t *frame_id) override;
+
+  void Pin(frame_id_t frame_id) override;
+
+  void Unpin(frame_id_t frame_id) override;
+
+  void GetVictimOrder(vector<frame_id_t> *frames) override;
+
+  void Remove(frame_id_t frame_id) override;
+
+  size_t Size() override;
+
+ private:
+  /** @return the key a frame is ordered by among the evictable frames */
+  pair<bool, size_t> EvictKey(const list<size_t> &history) const {
+    // frames with less than k accesses (infinite distance) sort first
+    return make_pair(history.size() >= k_, history.front());
+  }
+
+ private:
+  size_t max_size;
+  size_t k_;
+  size_t current_timestamp_{0};
+  frame_id_t last_accessed_frame_{INVALID_FRAME_ID};
+  unordered_map<frame_id_t, list<size_t>> history_;     // last k access timestamps, oldest first
+  set<pair<pair<bool, size_t>, frame_id_t>> evictable_;  // evictable frames ordered by eviction priority
+  unordered_set<frame_id_t> unreferenced_;                // frames whose history is only a placeholder
+  mutex latch_;
+};
+
+#endif  // MINISQL_LRU_K_REPLACER_H
@@ -13,11 +13,34 @@ static constexpr int META_PAGE_ID = 0;          // physical page id of the disk
 static constexpr int CATALOG_META_PAGE_ID = 0;  // logical page id of the catalog meta data
 static constexpr int INDEX_ROOTS_PAGE_ID = 1;   // logical page id of the index roots
 
-static constexpr int PAGE_SIZE = 4096;                  // size of a data page in byte
-static constexpr int DEFAULT_BUFFER_POOL_SIZE = 20480;  // default size of buffer pool
+static constexpr int PAGE_SIZE = 4096;                   // default page size in byte, also used by the disk meta pages
+static constexpr int MAX_PAGE_SIZE = 65536;              // largest page size a database can be created with
+static constexpr int PAGE_CHECKSUM_SIZE = 4;             // checksum kept in the last bytes of every data page
+static constexpr int DEFAULT_BUFFER_POOL_SIZE = 20480;   // default size of buffer pool
+static constexpr int DEFAULT_BUFFER_POOL_INSTANCES = 1;  // default number of buffer pool partitions
+
+static constexpr double DEFAULT_FLUSHER_CLEAN_RATIO = 0.1;  // fraction of frames the flusher keeps clean
+static constexpr int DEFAULT_FLUSHER_INTERVAL_MS = 10;      // period of the background flusher
+static constexpr int DEFAULT_READ_AHEAD_PAGES = 8;          // pages of a chain prefetched ahead of a scan
+static constexpr int READ_AHEAD_QUEUE_SIZE = 16;            // pending read-ahead requests, further ones are dropped
+static constexpr int DEFAULT_BULK_READ_RING_SIZE = 32;      // frames a bulk read scan cycles through
+static constexpr int DEFAULT_SCAN_WORKERS = 0;              // threads scanning for one database, 0 for one per core
+static constexpr int SCAN_MORSEL_PAGES = 16;                // consecutive pages a scan worker takes at a time
+static constexpr int PARALLEL_SCAN_MIN_PAGES = 64;          // smaller tables are scanned on the calling thread
+static constexpr int IO_URING_QUEUE_DEPTH = 64;             // requests kept in flight by the io_uring backend
+static constexpr int WARM_UP_BATCH_SIZE = 32;               // pages warm-up reads with one batch
+static constexpr int EXTENT_RESERVATION_SIZE = 64;          // adjacent pages set aside for one table heap or index
+static constexpr int DEFAULT_VACUUM_INTERVAL_MS = 1000;     // period of the background vacuum
+static constexpr int DEFAULT_VACUUM_THRESHOLD = 64;         // deleted tuples a table collects before it is vacuumed
+static constexpr int TOAST_TUPLE_FRACTION = 4;              // rows over page size / 4 move long chars to overflow pages
+static constexpr int DICTIONARY_MAX_CODES = 256;            // codes of a dictionary column, later values stay inline
+static constexpr int DICTIONARY_MAX_VALUE_LEN = 64;         // longer values of a dictionary column stay inline
+static constexpr bool DEFAULT_DIRECT_IO = false;            // bypass the OS page cache, the buffer pool is the only cache
+static constexpr bool DEFAULT_HUGE_PAGES = false;           // back buffer frames with reserved huge pages if there are any
+static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;   // size of a reserved huge page
 
 static constexpr uint32_t FIELD_NULL_LEN = UINT32_MAX;
-static constexpr uint32_t VARCHAR_MAX_LEN = PAGE_SIZE / 2;  // max length of varchar
+static constexpr uint32_t VARCHAR_MAX_LEN = 1024 * 1024;  // max length of varchar, long ones are stored out of line
 
 // static std::string DB_META_FILE = "minisql.meta.db";
 
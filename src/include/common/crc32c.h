@@ -0,0 +1,19 @@
+#ifndef MINISQL_CRC32C_H
+#define MINISQL_CRC32C_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * CRC32C (Castagnoli polynomial), the checksum of the data pages. Crc32c uses the SSE4.2 crc32 instruction when the
+ * CPU supports it and a lookup table otherwise, both give the same result.
+ */
+uint32_t Crc32c(const char *data, size_t size);
+
+/** CRC32C computed with the lookup table only. */
+uint32_t Crc32cSoftware(const char *data, size_t size);
+
+/** @return whether Crc32c runs on the SSE4.2 crc32 instruction */
+bool Crc32cHardwareSupported();
+
+#endif  // MINISQL_CRC32C_H
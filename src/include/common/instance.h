@@ -1,12 +1,16 @@
 #ifndef MINISQL_INSTANCE_H
 #define MINISQL_INSTANCE_H
 
+#include <condition_variable>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 
 #include "buffer/buffer_pool_manager.h"
 #include "catalog/catalog.h"
 #include "common/config.h"
+#include "common/thread_pool.h"
 #include "common/dberr.h"
 #include "common/macros.h"
 #include "executor/execute_context.h"
@@ -14,18 +18,61 @@
 
 class DBStorageEngine {
  public:
-  explicit DBStorageEngine(std::string db_name, bool init = true, uint32_t buffer_pool_size = DEFAULT_BUFFER_POOL_SIZE);
+  /**
+   * @param buffer_pool_size memory of the buffer pool counted in PAGE_SIZE frames; databases with larger pages get
+   * proportionally fewer frames
+   * @param page_size page size of a new database, an existing one keeps its own
+   * @param direct_io whether the database file bypasses the OS page cache, see DiskManager
+   * @param huge_pages whether the buffer frames are backed by huge pages, see BufferPoolManager
+   */
+  explicit DBStorageEngine(std::string db_name, bool init = true, uint32_t buffer_pool_size = DEFAULT_BUFFER_POOL_SIZE,
+                           uint32_t buffer_pool_instances = DEFAULT_BUFFER_POOL_INSTANCES,
+                           ReplacerType replacer_type = ReplacerType::LRU, IOBackend io_backend = IOBackend::SYNC,
+                           uint32_t page_size = PAGE_SIZE, bool direct_io = DEFAULT_DIRECT_IO,
+                           bool huge_pages = DEFAULT_HUGE_PAGES);
 
   ~DBStorageEngine();
 
   std::unique_ptr<ExecuteContext> MakeExecuteContext(Transaction *txn);
 
+  /** @return the side file the resident page list is kept in between a clean shutdown and the next start */
+  std::string GetResidentPagesFileName() const { return db_file_name_ + ".resident"; }
+
+  /**
+   * Start the background vacuum. Every interval_ms it vacuums the tables that collected at least threshold deleted
+   * tuples, holding latch_ so that it never runs during a statement. Only start it when every user of the catalog and
+   * the table heaps holds latch_ as well, as the statements of ExecuteEngine do. The destructor stops it.
+   */
+  void StartVacuum(uint32_t threshold = DEFAULT_VACUUM_THRESHOLD, uint32_t interval_ms = DEFAULT_VACUUM_INTERVAL_MS);
+
+  /**
+   * Stop the background vacuum and wait for it to exit. Does nothing if it is not running.
+   */
+  void StopVacuum();
+
+  /**
+   * Vacuum every table that collected at least threshold deleted tuples. Caller must hold latch_.
+   * @return the number of deleted tuples removed
+   */
+  uint32_t VacuumTables(uint32_t threshold);
+
+ private:
+  void VacuumLoop(uint32_t threshold, uint32_t interval_ms);
+
  public:
   DiskManager *disk_mgr_;
   BufferPoolManager *bpm_;
   CatalogManager *catalog_mgr_;
+  ThreadPool *scan_pool_;
   std::string db_file_name_;
   bool init_;
+  std::mutex latch_;  // held by a statement running on this database and by a vacuum pass
+
+ private:
+  std::thread vacuum_;                 // background vacuum
+  bool vacuum_stop_{false};            // tells the vacuum to exit
+  std::mutex vacuum_latch_;            // protects vacuum_stop_
+  std::condition_variable vacuum_cv_;  // wakes the vacuum up early when it has to stop
 };
 
 #endif  // MINISQL_INSTANCE_H
@@ -0,0 +1,51 @@
+#ifndef MINISQL_THREAD_POOL_H
+#define MINISQL_THREAD_POOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "common/macros.h"
+
+/**
+ * ThreadPool runs submitted tasks on a fixed set of threads, in the order they were submitted. It is owned by
+ * DBStorageEngine and shared by the parallel scans of all statements, so that a scan does not start threads of its
+ * own. A task must not wait for another task to run, since all threads may be busy.
+ */
+class ThreadPool {
+ public:
+  /**
+   * @param threads number of threads, at least one is started
+   */
+  explicit ThreadPool(size_t threads);
+
+  /**
+   * Run the tasks still queued and join the threads.
+   */
+  ~ThreadPool();
+
+  DISALLOW_COPY_AND_MOVE(ThreadPool);
+
+  /**
+   * Queue a task for the next free thread.
+   */
+  void Submit(std::function<void()> task);
+
+  /** @return the number of threads */
+  inline size_t GetSize() const { return threads_.size(); }
+
+ private:
+  /** Loop of a thread, running tasks until the pool is destroyed. */
+  void Run();
+
+  std::vector<std::thread> threads_;
+  std::deque<std::function<void()>> tasks_;  // submitted tasks no thread has taken yet
+  bool stop_{false};                         // set by the destructor
+  std::mutex latch_;                         // protects tasks_ and stop_
+  std::condition_variable cv_;               // signals a new task or the stop
+};
+
+#endif  // MINISQL_THREAD_POOL_H
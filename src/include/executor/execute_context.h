@@ -5,9 +5,13 @@
 #ifndef MINISQL_EXECUTE_CONTEXT_H
 #define MINISQL_EXECUTE_CONTEXT_H
 
+#include <algorithm>
+#include <thread>
+
 #include "buffer/buffer_pool_manager.h"
 #include "catalog/catalog.h"
 #include "common/macros.h"
+#include "common/thread_pool.h"
 #include "transaction/transaction.h"
 
 class ExecuteContext {
@@ -17,9 +21,11 @@ class ExecuteContext {
    * @param transaction The transaction executing the query
    * @param catalog The catalog that the executor uses
    * @param bpm The buffer pool manager that the executor uses
+   * @param scan_pool The threads parallel scans run on, nullptr to scan on the calling thread
    */
-  ExecuteContext(Transaction *transaction, CatalogManager *catalog, BufferPoolManager *bpm)
-      : transaction_(transaction), catalog_{catalog}, bpm_{bpm} {}
+  ExecuteContext(Transaction *transaction, CatalogManager *catalog, BufferPoolManager *bpm,
+                 ThreadPool *scan_pool = nullptr)
+      : transaction_(transaction), catalog_{catalog}, bpm_{bpm}, scan_pool_{scan_pool} {}
 
   ~ExecuteContext() = default;
 
@@ -34,6 +40,17 @@ class ExecuteContext {
   /** @return the buffer pool manager */
   BufferPoolManager *GetBufferPoolManager() { return bpm_; }
 
+  /** @return the pool the workers of parallel scans run on, nullptr if there is none */
+  ThreadPool *GetScanPool() const { return scan_pool_; }
+
+  /**
+   * @return the workers a sequential scan of a large table is split across, 1 or no scan pool to scan on the calling
+   * thread
+   */
+  size_t GetScanWorkers() const { return scan_pool_ == nullptr ? 1 : scan_workers_; }
+
+  void SetScanWorkers(size_t scan_workers) { scan_workers_ = std::max<size_t>(1, scan_workers); }
+
  private:
   /** The transaction context associated with this executor context */
   Transaction *transaction_;
@@ -41,6 +58,11 @@ class ExecuteContext {
   CatalogManager *catalog_;
   /** The buffer pool manager associated with this executor context */
   BufferPoolManager *bpm_;
+  /** Threads shared by the parallel scans of the database */
+  ThreadPool *scan_pool_;
+  /** Workers of a parallel sequential scan */
+  size_t scan_workers_{DEFAULT_SCAN_WORKERS > 0 ? DEFAULT_SCAN_WORKERS
+                                                : std::max<size_t>(1, std::thread::hardware_concurrency())};
 };
 
 #endif  // MINISQL_EXECUTE_CONTEXT_H
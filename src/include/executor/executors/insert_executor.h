@@ -25,7 +25,7 @@ class InsertExecutor : public AbstractExecutor {
   InsertExecutor(ExecuteContext *exec_ctx, const InsertPlanNode *plan,
                  std::unique_ptr<AbstractExecutor> &&child_executor);
 
-  /** Initialize the insert */
+  /** Initialize the insert, all rows of the child are inserted into the table heap as one batch */
   void Init() override;
 
   /**
@@ -42,11 +42,16 @@ class InsertExecutor : public AbstractExecutor {
   const Schema *GetOutputSchema() const override { return plan_->OutputSchema(); }
 
  private:
+  /** @return true if the row collides with a unique or primary key, in the index or earlier in the batch */
+  bool IsDuplicate(Row &row);
+
   /** The insert plan node to be executed*/
   const InsertPlanNode *plan_;
   std::unique_ptr<AbstractExecutor> child_executor_;
   TableInfo *table_info_;
   std::vector<IndexInfo *> indexes_;
+  std::vector<Row> rows_;  // rows inserted by this executor
+  size_t cursor_{0};
 };
 
 #endif  // MINISQL_INSERT_EXECUTOR_H
@@ -5,6 +5,10 @@
 #ifndef MINISQL_SEQ_SCAN_EXECUTOR_H
 #define MINISQL_SEQ_SCAN_EXECUTOR_H
 
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
 #include <vector>
 
 #include "executor/execute_context.h"
@@ -13,6 +17,13 @@
 
 /**
  * The SeqScanExecutor executor executes a sequential table scan.
+ *
+ * A table of at least PARALLEL_SCAN_MIN_PAGES pages is scanned by workers on the scan pool of the execute context: its
+ * pages are split into morsels of SCAN_MORSEL_PAGES consecutive pages, which the workers take in turn, filtering and
+ * projecting their tuples. Next returns the rows of one morsel after the other, so they come in the same order as
+ * from a scan on the calling thread. The workers stay at most two morsels each ahead of Next: a worker that reaches
+ * the end of the window returns its thread to the pool and Next submits it again once the window moves. Next scans
+ * a morsel itself if no worker has taken it yet, so a scan goes on while the pool is busy with other scans.
  */
 class SeqScanExecutor : public AbstractExecutor {
  public:
@@ -23,6 +34,8 @@ class SeqScanExecutor : public AbstractExecutor {
    */
   SeqScanExecutor(ExecuteContext *exec_ctx, const SeqScanPlanNode *plan);
 
+  ~SeqScanExecutor() override { StopWorkers(); }
+
   /** Initialize the sequential scan */
   void Init() override;
 
@@ -38,11 +51,64 @@ class SeqScanExecutor : public AbstractExecutor {
   const Schema *GetOutputSchema() const override { return plan_->OutputSchema(); }
 
  private:
+  /** Rows a worker produced from one morsel. */
+  struct Morsel {
+    std::deque<Row> rows_;
+    bool done_{false};
+  };
+
+  /**
+   * Apply the predicate to a scanned tuple and, if it matches, project it into row.
+   * @return true if the tuple matched
+   */
+  bool Produce(Row &scanned, Row *row) const;
+
+  /** Next of a parallel scan. */
+  bool NextParallel(Row *row, RowId *rid);
+
+  /** Split the pages of the table into morsels and start the workers. */
+  void StartWorkers(size_t workers);
+
+  /**
+   * Submit workers to the pool while fewer than workers_ run and the window has morsels left. Caller must hold latch_.
+   */
+  void SubmitWorkers();
+
+  /** Let the workers finish the morsel they are on and wait for them to return. */
+  void StopWorkers();
+
+  /** Task of a worker, taking morsels until none is left in the window or the scan is stopped. */
+  void ScanMorsels();
+
+  /**
+   * Scan the pages of morsel m into rows.
+   * @throw std::runtime_error if a page can not be fetched
+   */
+  void ScanMorsel(size_t m, BufferAccessStrategy *strategy, std::deque<Row> *rows);
+
   /** The sequential scan plan node to be executed */
   const SeqScanPlanNode *plan_;
   TableInfo *table_info_;
   TableIterator table_iter_;
   TableIterator end_iter_;
+  BufferAccessStrategy strategy_;  // bulk read ring the scanned pages cycle through
+  AbstractExpressionRef predicate_;     // predicate of the plan, comparing codes where it can
+  std::vector<bool> predicate_columns_;  // table columns the predicate reads as values
+  std::vector<bool> output_columns_;     // table columns of the output
+  std::vector<bool> columns_;            // table columns a PAX page decodes
+  PageFilter page_filter_;               // pages the zone map does not rule out, empty for all
+  bool parallel_{false};
+  std::vector<page_id_t> pages_;         // pages of the table in chain order, for a parallel scan
+  std::vector<Morsel> morsels_;          // output of every morsel of pages_
+  size_t next_morsel_{0};                // first morsel no worker has taken
+  size_t current_morsel_{0};             // morsel Next returns rows of
+  size_t window_{0};                     // morsels the workers may run ahead of current_morsel_
+  size_t workers_{0};                    // workers the scan may have running at a time
+  size_t running_{0};                    // workers submitted to the pool that have not returned
+  bool stop_{false};
+  std::exception_ptr error_;             // thrown by a worker, rethrown by Next
+  std::mutex latch_;                     // protects the morsels and the counters above
+  std::condition_variable cv_;           // signals a finished morsel, a returned worker and a move of current_morsel_
 };
 
 #endif  // MINISQL_SEQ_SCAN_EXECUTOR_H
@@ -26,6 +26,9 @@ class UpdateExecutor : public AbstractExecutor {
   UpdateExecutor(ExecuteContext *exec_ctx, const UpdatePlanNode *plan,
                  std::unique_ptr<AbstractExecutor> &&child_executor);
 
+  /** Gives back the insert page rows that outgrew their page were moved to, the statement is done with it. */
+  ~UpdateExecutor() override;
+
   /** Initialize the update */
   void Init() override;
 
@@ -28,7 +28,7 @@
 #include "page/b_plus_tree_page.h"
 
 #define LEAF_PAGE_HEADER_SIZE 32
-#define LEAF_PAGE_SIZE (((PAGE_SIZE - LEAF_PAGE_HEADER_SIZE) / sizeof(MappingType)) - 1)
+#define LEAF_PAGE_SIZE (((PAGE_SIZE - PAGE_CHECKSUM_SIZE - LEAF_PAGE_HEADER_SIZE) / sizeof(MappingType)) - 1)
 
 class BPlusTreeLeafPage : public BPlusTreePage {
  public:
@@ -42,6 +42,11 @@ class BPlusTreeLeafPage : public BPlusTreePage {
 
   void SetNextPageId(page_id_t next_page_id);
 
+  /** Next page id of the leaf page stored in page_data, used by read-ahead on unpinned frames. */
+  static page_id_t ReadNextPageId(const char *page_data) {
+    return reinterpret_cast<const BPlusTreeLeafPage *>(page_data)->GetNextPageId();
+  }
+
   GenericKey *KeyAt(int index);
 
   void SetKeyAt(int index, GenericKey *key);
@@ -85,7 +90,7 @@ class BPlusTreeLeafPage : public BPlusTreePage {
 
   page_id_t next_page_id_{INVALID_PAGE_ID};
 
-  char data_[PAGE_SIZE - LEAF_PAGE_HEADER_SIZE];
+  char data_[0];  // key value pairs up to the end of the page
 };
 
 using LeafPage = BPlusTreeLeafPage;
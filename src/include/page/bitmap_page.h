@@ -30,6 +30,25 @@ class BitmapPage {
    */
   bool IsPageFree(uint32_t page_offset) const;
 
+  /**
+   * Allocate a given page instead of the first free one.
+   * @return false if the page is invalid or already allocated
+   */
+  bool AllocatePageAt(uint32_t page_offset);
+
+  /**
+   * Find the first free page at or after from, testing 64 pages at a time.
+   * @return the page offset, or GetMaxSupportedSize() if every page from there on is allocated
+   */
+  uint32_t FindFirstFree(uint32_t from) const;
+
+  /**
+   * Find a run of count free pages starting at a multiple of count, at or after from.
+   * @param count run length, a multiple of 64
+   * @return the offset of the first page of the run, or GetMaxSupportedSize() if there is none
+   */
+  uint32_t FindFreeRun(uint32_t from, uint32_t count) const;
+
  private:
   /**
    * check a bit(byte_index, bit_index) in bytes is free(value 0).
@@ -40,8 +59,14 @@ class BitmapPage {
    */
   bool IsPageFreeLow(uint32_t byte_index, uint8_t bit_index) const;
 
+  /**
+   * @return the 64 pages starting at word_index * 64, the first page in the most significant bit
+   */
+  uint64_t LoadWord(uint32_t word_index) const;
+
   /** Note: need to update if modify page structure. */
   static constexpr size_t MAX_CHARS = PageSize - 2 * sizeof(uint32_t);
+  static_assert(MAX_CHARS % sizeof(uint64_t) == 0, "The bitmap is searched one 64-bit word at a time.");
 
  private:
   /** The space occupied by all members of the class should be equal to the PageSize */
@@ -0,0 +1,66 @@
+#ifndef MINISQL_DICTIONARY_PAGE_H
+#define MINISQL_DICTIONARY_PAGE_H
+
+#include <cstdint>
+#include <cstring>
+
+#include "common/config.h"
+
+/**
+ * One page of the dictionaries of a table. Entries are appended in the order the values got their codes, the code of
+ * a value is its position among the entries of its column across the page chain.
+ *
+ * Format (size in byte):
+ *  ---------------------------------------------------------------------------------------
+ * | NextPageId (4) | Size (4) | Column (4) | Length (4) | VALUE | ... | FREE SPACE | CHECKSUM |
+ *  ---------------------------------------------------------------------------------------
+ */
+class DictionaryPage {
+ public:
+  void Init() {
+    next_page_id_ = INVALID_PAGE_ID;
+    size_ = 0;
+  }
+
+  /** @return the number of entry bytes one dictionary page holds */
+  static uint32_t GetCapacity(uint32_t page_size) { return page_size - SIZE_HEADER - PAGE_CHECKSUM_SIZE; }
+
+  /** @return the bytes an entry of a value of len bytes takes */
+  static uint32_t GetEntrySize(uint32_t len) { return SIZE_ENTRY_HEADER + len; }
+
+  page_id_t GetNextPageId() const { return next_page_id_; }
+
+  void SetNextPageId(page_id_t next_page_id) { next_page_id_ = next_page_id; }
+
+  /** @return the bytes taken by the entries */
+  uint32_t GetSize() const { return size_; }
+
+  /**
+   * Read the entry at offset.
+   * @return the offset of the next entry
+   */
+  uint32_t ReadEntry(uint32_t offset, uint32_t *column, const char **data, uint32_t *len) const {
+    memcpy(column, data_ + offset, sizeof(uint32_t));
+    memcpy(len, data_ + offset + sizeof(uint32_t), sizeof(uint32_t));
+    *data = data_ + offset + SIZE_ENTRY_HEADER;
+    return offset + GetEntrySize(*len);
+  }
+
+  /** Append an entry, the caller checks that it fits. */
+  void AppendEntry(uint32_t column, const char *data, uint32_t len) {
+    memcpy(data_ + size_, &column, sizeof(uint32_t));
+    memcpy(data_ + size_ + sizeof(uint32_t), &len, sizeof(uint32_t));
+    memcpy(data_ + size_ + SIZE_ENTRY_HEADER, data, len);
+    size_ += GetEntrySize(len);
+  }
+
+ private:
+  static constexpr uint32_t SIZE_HEADER = 8;
+  static constexpr uint32_t SIZE_ENTRY_HEADER = 8;
+
+  page_id_t next_page_id_;
+  uint32_t size_;
+  char data_[0];
+};
+
+#endif  // MINISQL_DICTIONARY_PAGE_H
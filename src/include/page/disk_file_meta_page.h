@@ -2,17 +2,27 @@
 #define MINISQL_DISK_FILE_META_PAGE_H
 
 #include <cstdint>
+#include <type_traits>
 
 #include "page/bitmap_page.h"
 
-static constexpr page_id_t MAX_VALID_PAGE_ID = (PAGE_SIZE - 8) / 4 * BitmapPage<PAGE_SIZE>::GetMaxSupportedSize();
+/**
+ * Used page count of one extent. Two bytes hold every count as long as an extent has at most 65535 pages, which
+ * doubles the number of extents the meta page can describe.
+ */
+using extent_count_t =
+    std::conditional_t<BitmapPage<PAGE_SIZE>::GetMaxSupportedSize() <= UINT16_MAX, uint16_t, uint32_t>;
 
 class DiskFileMetaPage {
  public:
+  static constexpr uint32_t MAGIC = 0x4D534C34;  // "MSL4", data pages end with a checksum
+
   uint32_t GetExtentNums() { return num_extents_; }
 
   uint32_t GetAllocatedPages() { return num_allocated_pages_; }
 
+  uint32_t GetPageSize() { return page_size_; }
+
   uint32_t GetExtentUsedPage(uint32_t extent_id) {
     if (extent_id >= num_extents_) {
       return 0;
@@ -21,9 +31,17 @@ class DiskFileMetaPage {
   }
 
  public:
+  uint32_t magic_{MAGIC};
+  uint32_t page_size_{PAGE_SIZE};  // size of every page of the file, this page only uses its first PAGE_SIZE bytes
   uint32_t num_allocated_pages_{0};
   uint32_t num_extents_{0};  // each extent consists with a bit map and BIT_MAP_SIZE pages
-  uint32_t extent_used_page_[0];
+  extent_count_t extent_used_page_[0];
 };
 
+static constexpr uint32_t MAX_EXTENTS = (PAGE_SIZE - sizeof(DiskFileMetaPage)) / sizeof(extent_count_t);
+
+static constexpr page_id_t MAX_VALID_PAGE_ID = MAX_EXTENTS * BitmapPage<PAGE_SIZE>::GetMaxSupportedSize();
+
+static_assert(MAX_VALID_PAGE_ID + MAX_EXTENTS + 1 <= INT32_MAX, "Physical page ids must fit in page_id_t.");
+
 #endif  // MINISQL_DISK_FILE_META_PAGE_H
@@ -0,0 +1,67 @@
+#ifndef MINISQL_FREE_SPACE_MAP_PAGE_H
+#define MINISQL_FREE_SPACE_MAP_PAGE_H
+
+#include <cstdint>
+
+#include "common/config.h"
+
+/**
+ * One page of the free space map of a table heap: the ids of the heap pages it covers and, for each, a one byte
+ * category of the free space left in that page, see FreeSpaceMap. The pages of a map form a chain.
+ *
+ * Format (size in byte):
+ *  ------------------------------------------------------------------------------------------
+ * | NextPageId (4) | Count (4) | Capacity (4) | PageId_1 (4) | ... | PageId_capacity (4) |
+ *  ------------------------------------------------------------------------------------------
+ *  ----------------------------------------------------------
+ * | Category_1 (1) | ... | Category_capacity (1) | CHECKSUM |
+ *  ----------------------------------------------------------
+ */
+class FreeSpaceMapPage {
+ public:
+  void Init(uint32_t page_size) {
+    next_page_id_ = INVALID_PAGE_ID;
+    count_ = 0;
+    capacity_ = GetCapacity(page_size);
+  }
+
+  /** @return the number of heap pages one map page covers */
+  static uint32_t GetCapacity(uint32_t page_size) {
+    return (page_size - SIZE_HEADER - PAGE_CHECKSUM_SIZE) / (sizeof(page_id_t) + sizeof(uint8_t));
+  }
+
+  page_id_t GetNextPageId() const { return next_page_id_; }
+
+  void SetNextPageId(page_id_t next_page_id) { next_page_id_ = next_page_id; }
+
+  uint32_t GetCount() const { return count_; }
+
+  void SetCount(uint32_t count) { count_ = count; }
+
+  uint32_t GetCapacity() const { return capacity_; }
+
+  page_id_t GetPageId(uint32_t index) const { return reinterpret_cast<const page_id_t *>(data_)[index]; }
+
+  uint8_t GetCategory(uint32_t index) const { return Categories()[index]; }
+
+  void SetEntry(uint32_t index, page_id_t page_id, uint8_t category) {
+    reinterpret_cast<page_id_t *>(data_)[index] = page_id;
+    Categories()[index] = category;
+  }
+
+  void SetCategory(uint32_t index, uint8_t category) { Categories()[index] = category; }
+
+ private:
+  static constexpr uint32_t SIZE_HEADER = 12;
+
+  uint8_t *Categories() { return reinterpret_cast<uint8_t *>(data_ + capacity_ * sizeof(page_id_t)); }
+
+  const uint8_t *Categories() const { return reinterpret_cast<const uint8_t *>(data_ + capacity_ * sizeof(page_id_t)); }
+
+  page_id_t next_page_id_;
+  uint32_t count_;
+  uint32_t capacity_;
+  char data_[0];
+};
+
+#endif  // MINISQL_FREE_SPACE_MAP_PAGE_H
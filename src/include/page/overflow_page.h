@@ -0,0 +1,49 @@
+#ifndef MINISQL_OVERFLOW_PAGE_H
+#define MINISQL_OVERFLOW_PAGE_H
+
+#include <cstdint>
+#include <cstring>
+
+#include "common/config.h"
+
+/**
+ * One page of a char value stored out of line by a table heap. The pages of a value form a chain, each holds the
+ * next part of the value.
+ *
+ * Format (size in byte):
+ *  ----------------------------------------------------------------
+ * | NextPageId (4) | Size (4) | ... PART OF THE VALUE ... | CHECKSUM |
+ *  ----------------------------------------------------------------
+ */
+class OverflowPage {
+ public:
+  void Init() {
+    next_page_id_ = INVALID_PAGE_ID;
+    size_ = 0;
+  }
+
+  /** @return the number of value bytes one overflow page holds */
+  static uint32_t GetCapacity(uint32_t page_size) { return page_size - SIZE_HEADER - PAGE_CHECKSUM_SIZE; }
+
+  page_id_t GetNextPageId() const { return next_page_id_; }
+
+  void SetNextPageId(page_id_t next_page_id) { next_page_id_ = next_page_id; }
+
+  uint32_t GetSize() const { return size_; }
+
+  const char *GetData() const { return data_; }
+
+  void SetData(const char *data, uint32_t size) {
+    memcpy(data_, data, size);
+    size_ = size;
+  }
+
+ private:
+  static constexpr uint32_t SIZE_HEADER = 8;
+
+  page_id_t next_page_id_;
+  uint32_t size_;
+  char data_[0];
+};
+
+#endif  // MINISQL_OVERFLOW_PAGE_H
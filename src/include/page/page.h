@@ -3,6 +3,7 @@
 
 #include <cstring>
 #include <iostream>
+#include <memory>
 #include <shared_mutex>
 
 #include "common/config.h"
@@ -16,12 +17,16 @@
 class Page {
   // There is bookkeeping information inside the page that should only be relevant to the buffer pool manager.
   friend class BufferPoolManager;
+  friend class BufferPoolInstance;
 
  public:
   DISALLOW_COPY(Page)
 
-  /** Constructor. Zeros out the page data. */
-  Page() { ResetMemory(); }
+  /** Constructor of a standalone page, which owns PAGE_SIZE bytes of zeroed data. */
+  Page() : own_data_(new char[PAGE_SIZE]()), data_(own_data_.get()), page_size_(PAGE_SIZE) {}
+
+  /** Constructor of a buffer pool frame, the data belongs to the buffer pool instance. */
+  Page(char *data, uint32_t page_size) : data_(data), page_size_(page_size) { ResetMemory(); }
 
   /** Default destructor. */
   ~Page() = default;
@@ -29,6 +34,9 @@ class Page {
   /** @return the actual data contained within this page */
   inline char *GetData() { return data_; }
 
+  /** @return the size of the page data in bytes, chosen per database */
+  inline uint32_t GetPageSize() const { return page_size_; }
+
   /** @return the page id of this page */
   inline page_id_t GetPageId() { return page_id_; }
 
@@ -66,10 +74,14 @@ class Page {
 
  private:
   /** Zeroes out the data that is held within the page. */
-  inline void ResetMemory() { memset(data_, OFFSET_PAGE_START, PAGE_SIZE); }
+  inline void ResetMemory() { memset(data_, OFFSET_PAGE_START, page_size_); }
 
+  /** Data of a standalone page. */
+  std::unique_ptr<char[]> own_data_;
   /** The actual data that is stored within a page. */
-  char data_[PAGE_SIZE]{};
+  char *data_{nullptr};
+  /** The size of data_. */
+  uint32_t page_size_{0};
   /** The ID of this page. */
   page_id_t page_id_ = INVALID_PAGE_ID;
   /** The pin count of this page. */
@@ -0,0 +1,165 @@
+#ifndef MINISQL_PAX_PAGE_H
+#define MINISQL_PAX_PAGE_H
+
+/**
+ * PAX page format, the values of a page are grouped by column:
+ *  ---------------------------------------------------------------------------------------------
+ *  | HEADER | CHAR COLUMNS | SLOT STATES | NULL BITMAP | MINIPAGE 1 | ... | MINIPAGE N | FREE SPACE |
+ *  ---------------------------------------------------------------------------------------------
+ *  -------------------------------------------
+ *  | ... FREE SPACE | CHAR VALUES | CHECKSUM |
+ *  -------------------------------------------
+ *
+ *  Header format (size in bytes):
+ *  -----------------------------------------------------------------------------------------------------
+ *  | PageId (4)| LSN (4)| PrevPageId (4)| NextPageId (4)| Capacity (4)| TupleCount (4)| FreeSpacePointer (4) |
+ *  -----------------------------------------------------------------------------------------------------
+ *  ------------------------------------------------------------------
+ *  | UsedSlots (4)| GarbageBytes (4)| ColumnCount (4)| CharColumnCount (4)|
+ *  ------------------------------------------------------------------
+ *
+ *  The first four fields are those of TablePage, so the page chain is walked the same way for both formats. CHAR
+ *  COLUMNS has a bit per column that is set for chars, so the page finds its char values without the schema.
+ *  A page has Capacity slots, chosen from the schema when the page is initialized. Each slot has a state byte, a bit
+ *  per column in the null bitmap (all bits of column 1 first) and a 4 byte entry in the minipage of every column.
+ *  The entry of an int or float is its value, the entry of a char is the offset of its serialized value, which is
+ *  stored at the end of the page like the tuples of a TablePage. Char values that are replaced or deleted stay as
+ *  garbage until the page runs out of space or is vacuumed.
+ */
+
+#include <vector>
+
+#include "page/table_page.h"
+
+class PaxPage : public TablePage {
+ public:
+  void Init(page_id_t page_id, page_id_t prev_id, Schema *schema, LogManager *log_mgr, Transaction *txn);
+
+  bool InsertTuple(Row &row, Schema *schema, Transaction *txn, LockManager *lock_manager, LogManager *log_manager);
+
+  bool MarkDelete(const RowId &rid, Transaction *txn, LockManager *lock_manager, LogManager *log_manager);
+
+  /** @return 0 on success, 1 if the slot is invalid, 2 if the tuple is deleted, 3 if the new values do not fit */
+  int UpdateTuple(const Row &new_row, Row *old_row, Schema *schema, Transaction *txn, LockManager *lock_manager,
+                  LogManager *log_manager);
+
+  void ApplyDelete(const RowId &rid, Transaction *txn, LogManager *log_manager);
+
+  void RollbackDelete(const RowId &rid, Transaction *txn, LogManager *log_manager);
+
+  bool GetTuple(Row *row, Schema *schema, Transaction *txn, LockManager *lock_manager);
+
+  /**
+   * Decode only the columns set in columns, the other fields of row are null. The minipages of the other columns are
+   * not read at all.
+   */
+  bool GetTuple(Row *row, Schema *schema, const std::vector<bool> &columns);
+
+  /** Read the tuple even if it is marked deleted, used to free what it refers to before it is removed. */
+  bool ReadTuple(Row *row, Schema *schema);
+
+  bool GetFirstTupleRid(RowId *first_rid);
+
+  bool GetNextTupleRid(const RowId &cur_rid, RowId *next_rid);
+
+  /**
+   * Remove the tuples marked deleted and pack the char values against the end of the page. Live tuples keep their
+   * slot numbers.
+   * @param[out] removed_tuples number of deleted tuples removed
+   * @param[out] removed_rows if not nullptr, the removed tuples are read into it
+   * @return true if the page changed
+   */
+  bool Vacuum(Schema *schema, uint32_t *removed_tuples, std::vector<Row> *removed_rows);
+
+  /** @return true if no slot is in use, not even by a tuple marked deleted */
+  bool IsEmpty() { return GetUsedSlots() == 0; }
+
+  /**
+   * Free space in the unit of GetSpaceNeeded: 0 without a free slot, otherwise the bytes left for char values, or
+   * the minipage bytes of the free slots for a table without chars. A tuple fits iff this is at least its space.
+   */
+  uint32_t GetFreeSpaceRemaining();
+
+  /** @return the space InsertTuple needs for row in a page of schema */
+  static uint32_t GetSpaceNeeded(const Row &row, Schema *schema);
+
+  /** @return the free space of an empty page of schema, a row needing more never fits */
+  static uint32_t GetMaxFreeSpace(Schema *schema, uint32_t page_size);
+
+ private:
+  static constexpr uint8_t SLOT_EMPTY = 0;
+  static constexpr uint8_t SLOT_LIVE = 1;
+  static constexpr uint8_t SLOT_DELETED = 2;  // marked deleted, removed by ApplyDelete or Vacuum
+
+  static constexpr size_t SIZE_PAX_PAGE_HEADER = 44;
+  static constexpr size_t SIZE_ENTRY = 4;
+  static constexpr size_t OFFSET_CAPACITY = 16;
+  static constexpr size_t OFFSET_TUPLE_COUNT = 20;
+  static constexpr size_t OFFSET_FREE_SPACE = 24;
+  static constexpr size_t OFFSET_USED_SLOTS = 28;
+  static constexpr size_t OFFSET_GARBAGE = 32;
+  static constexpr size_t OFFSET_COLUMN_COUNT = 36;
+  static constexpr size_t OFFSET_CHAR_COLUMN_COUNT = 40;
+
+  /** @return the number of slots of a page of schema */
+  static uint32_t ComputeCapacity(Schema *schema, uint32_t page_size);
+
+  /** @return the bytes one slot takes outside the char values, in eighths of a byte */
+  static uint32_t GetSlotBits(uint32_t column_count) { return 8 + column_count + 8 * SIZE_ENTRY * column_count; }
+
+  /** @return the bytes row takes among the char values */
+  static uint32_t GetCharSize(const Row &row);
+
+  uint32_t ReadHeader(size_t offset) { return *reinterpret_cast<uint32_t *>(GetData() + offset); }
+
+  void WriteHeader(size_t offset, uint32_t value) { memcpy(GetData() + offset, &value, sizeof(uint32_t)); }
+
+  uint32_t GetCapacity() { return ReadHeader(OFFSET_CAPACITY); }
+
+  uint32_t GetTupleCount() { return ReadHeader(OFFSET_TUPLE_COUNT); }
+
+  uint32_t GetFreeSpacePointer() { return ReadHeader(OFFSET_FREE_SPACE); }
+
+  uint32_t GetUsedSlots() { return ReadHeader(OFFSET_USED_SLOTS); }
+
+  uint32_t GetGarbageBytes() { return ReadHeader(OFFSET_GARBAGE); }
+
+  uint32_t GetColumnCount() { return ReadHeader(OFFSET_COLUMN_COUNT); }
+
+  uint32_t GetCharColumnCount() { return ReadHeader(OFFSET_CHAR_COLUMN_COUNT); }
+
+  uint8_t *GetSlotState(uint32_t slot_num) {
+    return reinterpret_cast<uint8_t *>(GetData() + SIZE_PAX_PAGE_HEADER + (GetColumnCount() + 7) / 8 + slot_num);
+  }
+
+  bool IsNull(uint32_t column, uint32_t slot_num);
+
+  void SetNull(uint32_t column, uint32_t slot_num, bool is_null);
+
+  /** @return the minipage entry of a column in a slot */
+  char *GetEntry(uint32_t column, uint32_t slot_num);
+
+  /** @return the first byte after the minipages, the char values can not grow below it */
+  uint32_t GetCharAreaBegin();
+
+  bool IsCharColumn(uint32_t column) {
+    return (GetData()[SIZE_PAX_PAGE_HEADER + column / 8] >> (column % 8)) & 1;
+  }
+
+  /** @return the bytes the char values of a slot take */
+  uint32_t GetSlotCharSize(uint32_t slot_num);
+
+  /** Decode the fields of a slot, those not in columns are null if columns is not nullptr. */
+  void DecodeSlot(Row *row, Schema *schema, uint32_t slot_num, const std::vector<bool> *columns);
+
+  /** Write the fields of row to a slot, its char values must fit between the minipages and the free space pointer. */
+  void EncodeSlot(const Row &row, uint32_t slot_num);
+
+  /** Drop the char values of a slot, the slot becomes empty. */
+  void ReleaseSlot(uint32_t slot_num);
+
+  /** Pack the char values of the slots in use against the end of the page, so that the garbage becomes free space. */
+  void CompactChars();
+};
+
+#endif  // MINISQL_PAX_PAGE_H
@@ -2,12 +2,14 @@
 #define MINISQL_TUPLE_H
 /**
  * Basic Slotted page format:
- *  ---------------------------------------------------------
- *  | HEADER | ... FREE SPACE ... | ... INSERTED TUPLES ... |
- *  ---------------------------------------------------------
+ *  --------------------------------------------------------------------
+ *  | HEADER | ... FREE SPACE ... | ... INSERTED TUPLES ... | CHECKSUM |
+ *  --------------------------------------------------------------------
  *                                ^
  *                                free space pointer
  *
+ *  The checksum (PAGE_CHECKSUM_SIZE bytes) is set by the disk manager when the page is written.
+ *
  *  Header format (size in bytes):
  *  ----------------------------------------------------------------------------
  *  | PageId (4)| LSN (4)| PrevPageId (4)| NextPageId (4)| FreeSpacePointer(4) |
@@ -18,6 +20,7 @@
  **/
 
 #include <cstring>
+#include <vector>
 
 #include "common/macros.h"
 #include "common/rowid.h"
@@ -37,6 +40,11 @@ class TablePage : public Page {
 
   page_id_t GetNextPageId() { return *reinterpret_cast<page_id_t *>(GetData() + OFFSET_NEXT_PAGE_ID); }
 
+  /** Next page id of the table page stored in page_data, used by read-ahead on unpinned frames. */
+  static page_id_t ReadNextPageId(const char *page_data) {
+    return *reinterpret_cast<const page_id_t *>(page_data + OFFSET_NEXT_PAGE_ID);
+  }
+
   void SetPrevPageId(page_id_t prev_page_id) {
     memcpy(GetData() + OFFSET_PREV_PAGE_ID, &prev_page_id, sizeof(page_id_t));
   }
@@ -58,10 +66,33 @@ class TablePage : public Page {
 
   bool GetTuple(Row *row, Schema *schema, Transaction *txn, LockManager *lock_manager);
 
+  /** Read the tuple even if it is marked deleted, used to free what it refers to before it is removed. */
+  bool ReadTuple(Row *row, Schema *schema);
+
   bool GetFirstTupleRid(RowId *first_rid);
 
   bool GetNextTupleRid(const RowId &cur_rid, RowId *next_rid);
 
+  /**
+   * Remove the tuples marked deleted, pack the remaining tuples against the end of the page and drop the empty slots
+   * at the end of the slot array. Live tuples keep their slot numbers, so the rids in the indexes stay valid, and the
+   * empty slots in between are reused by later inserts.
+   * @param[out] removed_tuples number of deleted tuples removed
+   * @param[out] removed_rows if not nullptr, the removed tuples are read into it
+   * @return true if the page changed
+   */
+  bool Vacuum(Schema *schema, uint32_t *removed_tuples, std::vector<Row> *removed_rows);
+
+  /** @return true if the page holds no tuple, not even one marked deleted */
+  bool IsEmpty() { return GetTupleCount() == 0; }
+
+  uint32_t GetFreeSpaceRemaining() {
+    return GetFreeSpacePointer() - SIZE_TABLE_PAGE_HEADER - SIZE_TUPLE * GetTupleCount();
+  }
+
+  /** @return the free space InsertTuple needs for a tuple of tuple_size bytes */
+  static uint32_t GetSpaceNeeded(uint32_t tuple_size) { return tuple_size + SIZE_TUPLE; }
+
  private:
   uint32_t GetFreeSpacePointer() { return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_FREE_SPACE); }
 
@@ -73,10 +104,6 @@ class TablePage : public Page {
 
   void SetTupleCount(uint32_t tuple_count) { memcpy(GetData() + OFFSET_TUPLE_COUNT, &tuple_count, sizeof(uint32_t)); }
 
-  uint32_t GetFreeSpaceRemaining() {
-    return GetFreeSpacePointer() - SIZE_TABLE_PAGE_HEADER - SIZE_TUPLE * GetTupleCount();
-  }
-
   uint32_t GetTupleOffsetAtSlot(uint32_t slot_num) {
     return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_TUPLE_OFFSET + SIZE_TUPLE * slot_num);
   }
@@ -112,7 +139,7 @@ class TablePage : public Page {
   static constexpr size_t OFFSET_TUPLE_SIZE = 28;
 
  public:
-  static constexpr size_t SIZE_MAX_ROW = PAGE_SIZE - SIZE_TABLE_PAGE_HEADER - SIZE_TUPLE;
+  static constexpr size_t SIZE_MAX_ROW = PAGE_SIZE - SIZE_TABLE_PAGE_HEADER - SIZE_TUPLE - PAGE_CHECKSUM_SIZE;
 };
 
 #endif
\ No newline at end of file
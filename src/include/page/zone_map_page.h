@@ -0,0 +1,65 @@
+#ifndef MINISQL_ZONE_MAP_PAGE_H
+#define MINISQL_ZONE_MAP_PAGE_H
+
+#include <cstdint>
+#include <cstring>
+
+#include "common/config.h"
+
+/**
+ * One page of the zone map of a table heap: the ids of the heap pages it covers and, for each, the summary of every
+ * int and float column of the table, see ZoneMap. The pages of a map form a chain.
+ *
+ * Format (size in byte):
+ *  ------------------------------------------------------------------------------------------------------
+ * | NextPageId (4) | Count (4) | EntrySize (4) | Clean (4) | PageId_1 (4) | SUMMARIES_1 | ... | CHECKSUM |
+ *  ------------------------------------------------------------------------------------------------------
+ *
+ * A summary is Min (4) | Max (4) | NullCount (4), the entry of a page holds one per column, in column order. Clean
+ * is only used on the first page of a map: it is set while the pages on disk cover every tuple of the heap.
+ */
+class ZoneMapPage {
+ public:
+  void Init(uint32_t entry_size) {
+    next_page_id_ = INVALID_PAGE_ID;
+    count_ = 0;
+    entry_size_ = entry_size;
+    clean_ = 1;
+  }
+
+  /** @return the number of heap pages one map page covers */
+  static uint32_t GetCapacity(uint32_t page_size, uint32_t entry_size) {
+    return (page_size - SIZE_HEADER - PAGE_CHECKSUM_SIZE) / entry_size;
+  }
+
+  /** @return the bytes of the entry of a heap page with summaries of column_count columns */
+  static uint32_t GetEntrySize(uint32_t column_count) { return sizeof(page_id_t) + SIZE_SUMMARY * column_count; }
+
+  page_id_t GetNextPageId() const { return next_page_id_; }
+
+  void SetNextPageId(page_id_t next_page_id) { next_page_id_ = next_page_id; }
+
+  uint32_t GetCount() const { return count_; }
+
+  void SetCount(uint32_t count) { count_ = count; }
+
+  bool IsClean() const { return clean_ != 0; }
+
+  void SetClean(bool clean) { clean_ = clean ? 1 : 0; }
+
+  /** @return the entry at index, the page id followed by the summaries */
+  char *GetEntry(uint32_t index) { return data_ + index * entry_size_; }
+
+  static constexpr uint32_t SIZE_SUMMARY = 12;
+
+ private:
+  static constexpr uint32_t SIZE_HEADER = 16;
+
+  page_id_t next_page_id_;
+  uint32_t count_;
+  uint32_t entry_size_;
+  uint32_t clean_;
+  char data_[0];
+};
+
+#endif  // MINISQL_ZONE_MAP_PAGE_H
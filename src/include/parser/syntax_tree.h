@@ -43,7 +43,10 @@ typedef enum {
   kNodeIndexType,            /** type of index */
   kNodeTrxBegin,             /** begin transaction command */
   kNodeTrxCommit,            /** commit transaction command */
-  kNodeTrxRollback           /** rollback transaction command */
+  kNodeTrxRollback,          /** rollback transaction command */
+  kNodeShowBufferStatus,     /** show buffer status command */
+  kNodeVacuum,               /** vacuum command, its child is the table */
+  kNodeTableLayout           /** page layout of a table, row or pax */
 } SyntaxNodeType;
 
 /**
@@ -32,6 +32,11 @@ class Column {
 
   void SetNullable(bool b) {nullable_=b;}
 
+  /** @return true if the values of this char column are stored as codes of a per-column dictionary */
+  bool IsDictionaryEncoded() const { return dictionary_; }
+
+  void SetDictionaryEncoded(bool b) { dictionary_ = b; }
+
   TypeId GetType() const { return type_; }
 
   uint32_t SerializeTo(char *buf) const;
@@ -49,6 +54,7 @@ class Column {
   uint32_t table_ind_{0};  // column position in table
   bool nullable_{false};   // whether the column can be null
   bool unique_{false};     // whether the column is unique
+  bool dictionary_{false}; // whether the values are stored as dictionary codes, see TableDictionary
 };
 
 #endif  // MINISQL_COLUMN_H
@@ -9,6 +9,11 @@
 #include "record/type_id.h"
 #include "record/types.h"
 
+/** Code of a char in the dictionary of its column, see TableDictionary. */
+struct DictionaryCode {
+  uint32_t code_;
+};
+
 class Field {
   friend class Type;
 
@@ -61,12 +66,27 @@ class Field {
     }
   }
 
+  // char stored out of line in the overflow pages starting at first_page_id, see TableHeap
+  explicit Field(TypeId type, page_id_t first_page_id, uint32_t len)
+      : type_id_(type), len_(len), external_page_id_(first_page_id) {
+    ASSERT(type == TypeId::kTypeChar, "Invalid type.");
+    value_.chars_ = nullptr;
+  }
+
+  // char of a dictionary encoded column stored as its code, see TableHeap
+  explicit Field(TypeId type, DictionaryCode code) : type_id_(type), len_(0), code_(code.code_) {
+    ASSERT(type == TypeId::kTypeChar, "Invalid type.");
+    value_.chars_ = nullptr;
+  }
+
   // copy constructor
   explicit Field(const Field &other) {
     type_id_ = other.type_id_;
     len_ = other.len_;
     is_null_ = other.is_null_;
     manage_data_ = other.manage_data_;
+    external_page_id_ = other.external_page_id_;
+    code_ = other.code_;
     if (type_id_ == TypeId::kTypeChar && !is_null_ && manage_data_) {
       value_.chars_ = new char[len_];
       memcpy(value_.chars_, other.value_.chars_, len_);
@@ -83,6 +103,39 @@ class Field {
 
   inline bool IsNull() const { return is_null_; }
 
+  /** @return true if the value is still in its overflow pages, GetData() is nullptr until it is loaded */
+  inline bool IsExternal() const { return external_page_id_ != INVALID_PAGE_ID; }
+
+  inline page_id_t GetExternalPageId() const { return external_page_id_; }
+
+  /**
+   * Replace the reference to the overflow pages by the value read from them.
+   * @param data GetLength() bytes allocated with new[], owned by the field afterwards
+   */
+  void LoadExternal(char *data) {
+    ASSERT(IsExternal(), "Field is stored inline.");
+    value_.chars_ = data;
+    manage_data_ = true;
+    external_page_id_ = INVALID_PAGE_ID;
+  }
+
+  /** @return true if the value is a dictionary code, GetData() is nullptr until it is decoded */
+  inline bool IsCoded() const { return code_ != NO_CODE; }
+
+  inline uint32_t GetCode() const { return code_; }
+
+  /**
+   * Replace the code by the value it stands for.
+   * @param data len bytes allocated with new[], owned by the field afterwards
+   */
+  void LoadCoded(char *data, uint32_t len) {
+    ASSERT(IsCoded(), "Field is not coded.");
+    value_.chars_ = data;
+    len_ = len;
+    manage_data_ = true;
+    code_ = NO_CODE;
+  }
+
   inline uint32_t GetLength() const { return Type::GetInstance(type_id_)->GetLength(*this); }
 
   inline TypeId GetTypeId() const { return type_id_; }
@@ -127,6 +180,8 @@ class Field {
     std::swap(first.len_, second.len_);
     std::swap(first.is_null_, second.is_null_);
     std::swap(first.manage_data_, second.manage_data_);
+    std::swap(first.external_page_id_, second.external_page_id_);
+    std::swap(first.code_, second.code_);
   }
 
   std::string toString() {
@@ -154,6 +209,9 @@ class Field {
   uint32_t len_;
   bool is_null_{false};
   bool manage_data_{false};
+  page_id_t external_page_id_{INVALID_PAGE_ID};  // first overflow page of an out of line char
+  static constexpr uint32_t NO_CODE = UINT32_MAX;
+  uint32_t code_{NO_CODE};  // dictionary code of a coded char
 };
 
 #endif  // MINISQL_FIELD_H
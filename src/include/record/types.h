@@ -120,6 +120,13 @@ class TypeChar : public Type {
   virtual CmpBool CompareGreaterThan(const Field &left, const Field &right) const override;
 
   virtual CmpBool CompareGreaterThanEquals(const Field &left, const Field &right) const override;
+
+  /** @return the bytes of the serialized char starting at storage, without decoding it */
+  static uint32_t GetStoredSize(const char *storage);
+
+ private:
+  static constexpr uint32_t EXTERNAL_MASK = 1U << 31;  // set in the stored length of a char kept in overflow pages
+  static constexpr uint32_t CODED_MASK = 1U << 30;     // set in place of the length of a char stored as its code
 };
 
 class TypeFloat : public Type {
@@ -2,51 +2,167 @@
 #define DISK_MGR_H
 
 #include <atomic>
-#include <fstream>
+#include <cstdlib>
 #include <iostream>
 #include <mutex>
+#include <set>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "common/config.h"
 #include "common/macros.h"
 #include "page/bitmap_page.h"
 #include "page/disk_file_meta_page.h"
+#include "storage/io_uring_queue.h"
+
+/**
+ * How the disk manager issues page I/O.
+ */
+enum class IOBackend {
+  SYNC = 0,  // one pread/pwritev per page or run of pages
+  IO_URING,  // batches are submitted to io_uring and run with many requests in flight
+};
+
+/**
+ * Snapshot of the disk manager I/O counters, times are in microseconds.
+ */
+struct DiskStats {
+  uint64_t pages_read_{0};
+  uint64_t pages_written_{0};
+  uint64_t bytes_read_{0};
+  uint64_t bytes_written_{0};
+  uint64_t write_requests_{0};  // a run of adjacent pages written together counts once
+  uint64_t read_time_us_{0};
+  uint64_t write_time_us_{0};
+  uint64_t checksum_failures_{0};    // pages read whose checksum did not match
+  uint64_t checksum_verify_ns_{0};  // time spent verifying checksums of pages read, in nanoseconds
+};
+
+/**
+ * A run of EXTENT_RESERVATION_SIZE adjacent pages set aside for one table heap or index, so that its pages follow
+ * each other on disk. Only the disk manager touches the fields. The reservation lives in memory: pages not handed out
+ * yet stay free on disk and go back to everyone once the owner calls DiskManager::ReleaseReservation.
+ */
+struct ExtentReservation {
+  page_id_t next_page_id_{INVALID_PAGE_ID};  // next page to hand out
+  page_id_t end_page_id_{INVALID_PAGE_ID};   // one past the last reserved page
+};
 
 /**
  * DiskManager takes care of the allocation and de allocation of pages within a database. It performs the reading and
  * writing of pages to and from disk, providing a logical file layer within the context of a database management system.
  *
+ * Pages are read and written with positional I/O on one file descriptor, so reads and writes of different pages run
+ * concurrently. Writes are not synced one by one; data reaches stable storage at Sync, which FlushAllPages and Close
+ * call. With the io_uring backend, the batch calls ReadPages and WritePages keep many requests in flight; single
+ * page calls and every call on a kernel without io_uring use pread/pwritev.
+ *
+ * The meta page and the bitmap pages are kept in memory, so allocation does no I/O; they are written back at Sync.
+ * Pages of a reservation are handed out to its owner only, see ExtentReservation.
+ *
+ * File offsets are 64-bit. A database holds up to MAX_VALID_PAGE_ID pages, limited by the extent counts that fit
+ * in the meta page (about 270 GB with 4 KB pages).
+ *
+ * The page size is chosen when the file is created and kept in the meta page. The meta page and the bitmap pages
+ * take a whole page each but only use their first PAGE_SIZE bytes, so an extent has BITMAP_SIZE pages whatever the
+ * page size is.
+ *
+ * Every data page ends with a CRC32C checksum of the rest of the page, PAGE_CHECKSUM_SIZE bytes that the page layouts
+ * leave free. It is set when the page is written and verified when it is read; an all zero page, which was allocated
+ * but never written, passes as well. The meta page and the bitmap pages carry no checksum.
+ *
+ * With direct I/O the file is opened with O_DIRECT and pages bypass the OS page cache, so the buffer pool is the only
+ * cache. O_DIRECT needs buffers aligned to PAGE_SIZE: buffer pool frames are, other buffers go through an aligned
+ * bounce buffer. File systems without O_DIRECT support fall back to buffered I/O.
+ *
  * Disk page storage format: (Free Page BitMap Size = PAGE_SIZE * 8, we note it as N)
  * | Meta Page | Free Page BitMap 1 | Page 1 | Page 2 | ....
  *      | Page N | Free Page BitMap 2 | Page N+1 | ... | Page 2N | ... |
  */
 class DiskManager {
  public:
-  explicit DiskManager(const std::string &db_file);
+  /**
+   * @param io_backend requested backend, falls back to IOBackend::SYNC if io_uring cannot be set up
+   * @param page_size page size of a new file, see IsValidPageSize; an existing file keeps the one it was created with
+   * @param direct_io whether to open the file with O_DIRECT
+   */
+  explicit DiskManager(const std::string &db_file, IOBackend io_backend = IOBackend::SYNC,
+                       uint32_t page_size = PAGE_SIZE, bool direct_io = false);
 
   ~DiskManager() {
     if (!closed) {
       Close();
     }
+    free(meta_data_);
+  }
+
+  /** @return whether a database can be created with this page size: a power of two from PAGE_SIZE to MAX_PAGE_SIZE */
+  static inline bool IsValidPageSize(uint32_t page_size) {
+    return page_size >= PAGE_SIZE && page_size <= MAX_PAGE_SIZE && (page_size & (page_size - 1)) == 0;
   }
 
+  /** @return the size of every page of this file */
+  inline uint32_t GetPageSize() const { return page_size_; }
+
   /**
    * Read page from specific page_id
    * Note: page_id = 0 is reserved for free page bit map
+   * @return false if the page failed checksum verification, page_data then holds what was read
    */
-  void ReadPage(page_id_t logical_page_id, char *page_data);
+  bool ReadPage(page_id_t logical_page_id, char *page_data);
 
   /**
    * Write data to specific page
    * Note: page_id = 0 is reserved for free page bit map
+   * @param page_data the page, its last PAGE_CHECKSUM_SIZE bytes are replaced by the checksum on disk; the buffer
+   * itself is not modified, so a frame may be written while it changes and still gets a matching checksum
    */
   void WritePage(page_id_t logical_page_id, const char *page_data);
 
+  /**
+   * Write a batch of pages. The batch is sorted by physical position and every run of adjacent pages is
+   * written with a single request.
+   * @param pages pairs of logical page id and page data, reordered in place; the checksums are set as in WritePage,
+   * on copies of the pages
+   */
+  void WritePages(std::vector<std::pair<page_id_t, char *>> &pages);
+
+  /**
+   * Read a batch of pages, sorted by physical position. Runs of adjacent pages are read with a single request.
+   * @param pages pairs of logical page id and destination buffer, reordered in place
+   * @return the pages that failed checksum verification
+   */
+  std::vector<page_id_t> ReadPages(std::vector<std::pair<page_id_t, char *>> &pages);
+
+  /**
+   * Store the checksum of a page in its last PAGE_CHECKSUM_SIZE bytes.
+   */
+  void SetChecksum(char *page_data) const;
+
+  /**
+   * @return whether the checksum of a page matches its content, or the page was never written
+   */
+  bool VerifyChecksum(const char *page_data) const;
+
+  /** @return the backend in use, which is IOBackend::SYNC if io_uring was requested but is unavailable */
+  inline IOBackend GetIOBackend() const { return UseRing() ? IOBackend::IO_URING : IOBackend::SYNC; }
+
+  /** @return whether the file is accessed with O_DIRECT, false if it was requested but the file system refused it */
+  inline bool IsDirectIO() const { return direct_io_; }
+
   /**
    * Get next free page from disk
-   * @return logical page id of allocated page
+   * @param reservation if not null, the page is taken from this reservation, which moves on to a new run of free
+   * pages once it is used up, preferably the run right after it
+   * @return logical page id of allocated page, INVALID_PAGE_ID if the file has reached MAX_VALID_PAGE_ID pages
+   */
+  page_id_t AllocatePage(ExtentReservation *reservation = nullptr);
+
+  /**
+   * Give the pages of a reservation that were not handed out back to general allocation.
    */
-  page_id_t AllocatePage();
+  void ReleaseReservation(ExtentReservation *reservation);
 
   /**
    * Free this page and reset bit map
@@ -63,19 +179,84 @@ class DiskManager {
    */
   void Close();
 
+  /**
+   * Write the meta page and the modified bitmap pages, then make every write issued so far durable.
+   */
+  void Sync();
+
   /**
    * Get Meta Page
    * Note: Used only for debug
    */
   char *GetMetaData() { return meta_data_; }
 
+  /**
+   * @return the I/O counters accumulated since the disk manager was opened
+   */
+  DiskStats GetStats() const;
+
   static constexpr size_t BITMAP_SIZE = BitmapPage<PAGE_SIZE>::GetMaxSupportedSize();
 
  private:
   /**
-   * Helper function to get disk file size
+   * @return the cached bitmap page of an extent, read from disk on first use. Caller must hold db_io_latch_.
+   */
+  BitmapPage<PAGE_SIZE> *GetBitmap(uint32_t extent_id);
+
+  /**
+   * Allocate a free page outside every reservation, lowest first. Caller must hold db_io_latch_.
+   * @return INVALID_PAGE_ID if the file is full
+   */
+  page_id_t AllocateUnreservedPage();
+
+  /**
+   * Mark a free page as allocated and update the extent counters. Caller must hold db_io_latch_.
+   * @return false if the page is already allocated
+   */
+  bool AllocatePageAt(page_id_t logical_page_id);
+
+  /**
+   * Find a run of free pages for a reservation, trying the run at preferred first, and record it in reserved_.
+   * Caller must hold db_io_latch_.
+   * @return logical page id of the first page of the run, INVALID_PAGE_ID if no extent can be opened
+   */
+  page_id_t ReserveRun(page_id_t preferred);
+
+  /**
+   * Write back the modified bitmap pages and the meta page. Caller must hold db_io_latch_.
+   */
+  void WriteMetaData();
+
+  /**
+   * Verify the checksum of a page just read, counting the time spent and logging a mismatch.
+   * @return false if the checksum does not match
+   */
+  bool VerifyReadPage(page_id_t logical_page_id, const char *page_data);
+
+  /**
+   * @return a zeroed buffer of one page, aligned for O_DIRECT; release it with free
    */
-  int GetFileSize(const std::string &file_name);
+  char *AllocatePageBuffer() const;
+
+  /**
+   * @return whether page I/O can use this buffer as is, which O_DIRECT only allows for aligned buffers
+   */
+  inline bool CanTransfer(const char *page_data) const {
+    return !direct_io_ || reinterpret_cast<uintptr_t>(page_data) % PAGE_SIZE == 0;
+  }
+
+  /** @return whether batches go through io_uring, false once the ring was torn down after a failure */
+  inline bool UseRing() const { return io_uring_ != nullptr && io_uring_->IsValid(); }
+
+  /**
+   * Helper function to get disk file size from the file system
+   */
+  uint64_t GetFileSize();
+
+  /**
+   * Raise the cached file size to end_offset if the file grew
+   */
+  void GrowFileSize(uint64_t end_offset);
 
   /**
    * Read physical page from disk
@@ -87,19 +268,62 @@ class DiskManager {
    */
   void WritePhysicalPage(page_id_t physical_page_id, const char *page_data);
 
+  /**
+   * Write count pages to consecutive physical pages starting at first_physical_page_id
+   */
+  void WritePhysicalPages(page_id_t first_physical_page_id, const char *const *pages_data, size_t count);
+
+  /**
+   * Group pages sorted by logical id into one request per run of physically adjacent pages, skipping pages that
+   * start at or beyond skip_from_offset. iov receives one entry per page and must outlive the requests.
+   */
+  void BuildRequests(bool write, const std::vector<page_id_t> &page_ids, char *const *pages_data,
+                     uint64_t skip_from_offset, std::vector<struct iovec> *iov, std::vector<IORequest> *requests);
+
   /**
    * Map logical page id to physical page id
    */
   page_id_t MapPageId(page_id_t logical_page_id);
 
+  /**
+   * @return the file offset of a physical page, computed in 64 bits
+   */
+  inline uint64_t PageOffset(page_id_t physical_page_id) const {
+    return static_cast<uint64_t>(physical_page_id) * page_size_;
+  }
+
  private:
-  // stream to write db file
-  std::fstream db_io_;
+  // descriptor of the db file
+  int db_fd_{-1};
   std::string file_name_;
-  // with multiple buffer pool instances, need to protect file access
+  // size of the db file, kept in memory instead of asking the file system on every read
+  std::atomic<uint64_t> file_size_{0};
+  // protects the meta page and the bitmap pages, page I/O itself needs no latch
   std::recursive_mutex db_io_latch_;
+  // bitmap pages by extent, nullptr until first used; written back by Sync. Page buffers of the disk manager are
+  // allocated with AllocatePageBuffer.
+  std::vector<char *> bitmaps_;
+  std::vector<bool> bitmap_dirty_;
+  // extents with at least one free page, allocation takes the lowest
+  std::set<uint32_t> free_extents_;
+  // first pages of the runs reserved by some table heap or index
+  std::set<page_id_t> reserved_;
+  // io_uring backend, nullptr when page I/O is synchronous; kept until Close if its ring is torn down
+  IOUringQueue *io_uring_{nullptr};
   bool closed{false};
-  char meta_data_[PAGE_SIZE];
+  // the file was opened with O_DIRECT
+  bool direct_io_{false};
+  // size of every page of the file, read from the meta page
+  uint32_t page_size_{PAGE_SIZE};
+  char *meta_data_{nullptr};
+  // I/O counters, updated with relaxed atomics so that reading them never blocks I/O
+  std::atomic<uint64_t> pages_read_{0};
+  std::atomic<uint64_t> pages_written_{0};
+  std::atomic<uint64_t> write_requests_{0};
+  std::atomic<uint64_t> read_time_us_{0};
+  std::atomic<uint64_t> write_time_us_{0};
+  std::atomic<uint64_t> checksum_failures_{0};
+  std::atomic<uint64_t> checksum_verify_ns_{0};
 };
 
 #endif
\ No newline at end of file
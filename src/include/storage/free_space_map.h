@@ -0,0 +1,127 @@
+#ifndef MINISQL_FREE_SPACE_MAP_H
+#define MINISQL_FREE_SPACE_MAP_H
+
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "page/free_space_map_page.h"
+
+/**
+ * FreeSpaceMap tells a table heap which of its pages has room for a new tuple, so that an insert goes straight to a
+ * page instead of walking the page chain. Each heap page has a category, its free bytes in units of 1/256 of the page
+ * size rounded down, so a page of category c has at least c * page_size / 256 bytes free.
+ *
+ * The map lives in a chain of FreeSpaceMapPages that list the heap pages in chain order, and is mirrored in memory
+ * so that a lookup reads no page. Every change is written through to its map page. The categories are a hint, the
+ * heap still checks the page itself and reports back what it found.
+ */
+class FreeSpaceMap {
+ public:
+  explicit FreeSpaceMap(BufferPoolManager *buffer_pool_manager);
+
+  /**
+   * Allocate the first page of a new, empty map.
+   * @return false if no page could be allocated
+   */
+  bool Create(ExtentReservation *reservation);
+
+  /**
+   * Read an existing map, starting from its first page.
+   */
+  void Load(page_id_t first_page_id);
+
+  /**
+   * Delete the pages of the map.
+   */
+  void Destroy();
+
+  /** @return the first page of the map, kept in the table metadata */
+  inline page_id_t GetFirstPageId() const { return map_pages_.empty() ? INVALID_PAGE_ID : map_pages_.front(); }
+
+  /**
+   * @return a heap page with at least space bytes free according to the map, INVALID_PAGE_ID if there is none
+   */
+  page_id_t FindPage(uint32_t space);
+
+  /**
+   * Like FindPage, but pages claimed by another inserter are skipped and the page found is claimed, so that
+   * concurrent inserters fill different pages.
+   * @return the claimed page, INVALID_PAGE_ID if every page with room is claimed already
+   */
+  page_id_t ClaimPage(uint32_t space);
+
+  /**
+   * Give up the claim on a page, other inserters may pick it again.
+   */
+  void ReleasePage(page_id_t page_id);
+
+  /**
+   * Record the free space of a heap page after it changed.
+   */
+  void Update(page_id_t page_id, uint32_t free_space);
+
+  /**
+   * Add a heap page that was appended to the page chain.
+   * @param claim claim the page for the inserter that appended it
+   * @return false if the map needed another page and none could be allocated
+   */
+  bool AddPage(page_id_t page_id, uint32_t free_space, ExtentReservation *reservation, bool claim = false);
+
+  /**
+   * Drop heap pages that were unlinked from the page chain, together with their claims. The entries after them move
+   * up, map pages that are no longer needed are deleted.
+   */
+  void RemovePages(const std::vector<page_id_t> &page_ids);
+
+  /** @return the last page of the heap page chain, INVALID_PAGE_ID if the map is empty */
+  page_id_t GetLastPage();
+
+  /** @return the number of heap pages in the map */
+  size_t GetPageCount();
+
+  /** @return the heap pages in chain order */
+  std::vector<page_id_t> GetPages();
+
+  /** @return the category of a page with free_space bytes free */
+  static inline uint8_t ToCategory(uint32_t free_space, uint32_t page_size) {
+    return static_cast<uint8_t>(std::min<uint64_t>(static_cast<uint64_t>(free_space) * 256 / page_size, 255));
+  }
+
+ private:
+  /**
+   * Write an entry to its map page, setting the page count as well if it is the last one. Caller must hold latch_.
+   */
+  void WriteEntry(uint32_t index);
+
+  /**
+   * Recompute the largest category of the block of an entry. Caller must hold latch_.
+   */
+  void UpdateBlockMax(uint32_t index);
+
+  /**
+   * Search for an entry with at least required category, skipping claimed pages if skip_claimed. Caller must hold
+   * latch_.
+   * @return the index of the entry, heap_pages_.size() if there is none
+   */
+  size_t Search(uint64_t required, bool skip_claimed);
+
+  static constexpr uint32_t BLOCK_SIZE = 1024;  // entries summarized by one element of block_max_
+
+  BufferPoolManager *buffer_pool_manager_;
+  uint32_t page_size_;
+  uint32_t entries_per_page_;                      // capacity of one map page
+  std::vector<page_id_t> map_pages_;               // map pages in chain order
+  std::vector<page_id_t> heap_pages_;              // heap pages in chain order
+  std::vector<uint8_t> categories_;                // category of each heap page
+  std::vector<uint8_t> block_max_;                 // largest category of each block of BLOCK_SIZE entries
+  std::unordered_map<page_id_t, uint32_t> index_;  // position of a heap page in heap_pages_
+  std::unordered_set<page_id_t> claimed_;          // heap pages an inserter is filling
+  uint32_t hint_{0};                               // where the last page with room was found
+  std::mutex latch_;
+};
+
+#endif  // MINISQL_FREE_SPACE_MAP_H
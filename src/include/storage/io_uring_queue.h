@@ -0,0 +1,88 @@
+#ifndef MINISQL_IO_URING_QUEUE_H
+#define MINISQL_IO_URING_QUEUE_H
+
+#include <sys/uio.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+/**
+ * One vectored read or write at a file offset, see IOUringQueue::Run.
+ */
+struct IORequest {
+  bool write_;               // pwritev if true, preadv otherwise
+  int fd_;                   // file to access
+  const struct iovec *iov_;  // buffers, read or written back to back
+  unsigned iov_count_;       // number of buffers
+  uint64_t offset_;          // file offset of the first byte
+  int64_t result_{0};        // bytes transferred, or -errno
+};
+
+/**
+ * IOUringQueue is a minimal io_uring submission/completion queue pair, driven directly through the io_uring system
+ * calls. A batch of requests is submitted with as many requests in flight as the ring holds and the call returns once
+ * every request has completed, so the device sees a deep queue instead of one request at a time.
+ *
+ * If the kernel or the build does not support io_uring, IsValid returns false and the queue must not be used.
+ * Batches are serialized on one latch, the requests of a batch run concurrently.
+ *
+ * A batch never leaves completions behind for the next one: if the ring fails, Run stops submitting and waits for the
+ * requests the kernel already took. Only if they can not be reaped either, the ring is torn down, IsValid turns false
+ * and the requests still running hold -EINPROGRESS, their buffers may then still be accessed by the kernel.
+ */
+class IOUringQueue {
+ public:
+  explicit IOUringQueue(unsigned entries);
+
+  virtual ~IOUringQueue();
+
+  /** @return whether the ring was set up and can run requests, false once it was torn down after a failure */
+  inline bool IsValid() const { return valid_.load(std::memory_order_acquire); }
+
+  /**
+   * Submit all requests and wait for their completion, storing each outcome in result_.
+   * @return false if the ring failed, requests that were not run then hold -EIO and requests that were abandoned in
+   * a torn down ring -EINPROGRESS
+   */
+  bool Run(std::vector<IORequest> &requests);
+
+ protected:
+  /**
+   * Submit to_submit queued entries and wait for min_complete completions, overridden by tests to make it fail.
+   * @return the number of entries the kernel took, or -1 with errno set
+   */
+  virtual int Enter(unsigned to_submit, unsigned min_complete);
+
+ private:
+  /** @return the number of completions reaped into requests */
+  unsigned Reap(std::vector<IORequest> &requests);
+
+  /** Unmap and close the ring, IsValid is false afterwards. */
+  void TearDown();
+
+  std::atomic<bool> valid_{false};
+  int ring_fd_{-1};
+  unsigned sq_entries_{0};
+  // submission ring
+  void *sq_ring_{nullptr};
+  size_t sq_ring_size_{0};
+  unsigned *sq_head_{nullptr};
+  unsigned *sq_tail_{nullptr};
+  unsigned *sq_mask_{nullptr};
+  unsigned *sq_array_{nullptr};
+  void *sqes_{nullptr};
+  size_t sqes_size_{0};
+  // completion ring, shares the mapping with the submission ring on recent kernels
+  void *cq_ring_{nullptr};
+  size_t cq_ring_size_{0};
+  unsigned *cq_head_{nullptr};
+  unsigned *cq_tail_{nullptr};
+  unsigned *cq_mask_{nullptr};
+  void *cqes_{nullptr};
+  std::mutex latch_;
+};
+
+#endif  // MINISQL_IO_URING_QUEUE_H
@@ -0,0 +1,84 @@
+#ifndef MINISQL_TABLE_DICTIONARY_H
+#define MINISQL_TABLE_DICTIONARY_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/rwlatch.h"
+#include "page/dictionary_page.h"
+
+/**
+ * TableDictionary keeps the dictionaries of the dictionary encoded char columns of a table heap. A column stores the
+ * code of a value instead of the value itself, codes are given out in the order the values are first inserted and
+ * are never taken back, so a code stays valid as long as the table. A column has at most DICTIONARY_MAX_CODES codes
+ * and only values up to DICTIONARY_MAX_VALUE_LEN bytes get one; the other values are stored inline. A value stored
+ * inline therefore never has a code, which is what lets equality be decided on codes alone.
+ *
+ * The entries live in a chain of DictionaryPages, the first page is kept in the table metadata. They are mirrored in
+ * memory so that neither encoding nor decoding reads a page, a new entry is written through to the last page.
+ */
+class TableDictionary {
+ public:
+  explicit TableDictionary(BufferPoolManager *buffer_pool_manager) : buffer_pool_manager_(buffer_pool_manager) {}
+
+  /**
+   * Allocate the first page of new, empty dictionaries.
+   * @return false if no page could be allocated
+   */
+  bool Create(ExtentReservation *reservation);
+
+  /**
+   * Read existing dictionaries, starting from their first page.
+   */
+  void Load(page_id_t first_page_id);
+
+  /**
+   * Delete the pages of the dictionaries.
+   */
+  void Destroy();
+
+  /** @return the first page of the dictionaries, INVALID_PAGE_ID if the table has no dictionary column */
+  inline page_id_t GetFirstPageId() const { return pages_.empty() ? INVALID_PAGE_ID : pages_.front(); }
+
+  /** code of a value that is stored inline */
+  static constexpr uint32_t NO_CODE = UINT32_MAX;
+
+  /**
+   * Get the code of a value of column, giving it the next code if it has none yet and the column has room.
+   * @param[out] code the code of the value, NO_CODE if the value is to be stored inline
+   * @return false if the value needed a new code and its entry could not be written
+   */
+  bool Encode(uint32_t column, const char *data, uint32_t len, uint32_t *code, ExtentReservation *reservation);
+
+  /**
+   * Get the code of a value of column without giving out a new one.
+   * @return false if the value has no code
+   */
+  bool Find(uint32_t column, const char *data, uint32_t len, uint32_t *code);
+
+  /**
+   * @return a copy of the value of a code allocated with new[], nullptr if column has no such code
+   */
+  char *Decode(uint32_t column, uint32_t code, uint32_t *len);
+
+ private:
+  struct ColumnDictionary {
+    std::vector<std::string> values_;                   // value of each code
+    std::unordered_map<std::string, uint32_t> codes_;  // code of each value
+  };
+
+  /**
+   * Write an entry to the last dictionary page, appending a page if it is full. Caller must hold the write latch.
+   * @return false if a page was needed and none could be allocated
+   */
+  bool AppendEntry(uint32_t column, const std::string &value, ExtentReservation *reservation);
+
+  BufferPoolManager *buffer_pool_manager_;
+  std::vector<page_id_t> pages_;                             // dictionary pages in chain order
+  std::unordered_map<uint32_t, ColumnDictionary> columns_;  // dictionary of each column with codes
+  ReaderWriterLatch latch_;
+};
+
+#endif  // MINISQL_TABLE_DICTIONARY_H
@@ -1,37 +1,96 @@
 #ifndef MINISQL_TABLE_HEAP_H
 #define MINISQL_TABLE_HEAP_H
 
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
 #include "buffer/buffer_pool_manager.h"
 #include "page/header_page.h"
+#include "page/overflow_page.h"
+#include "page/pax_page.h"
 #include "page/table_page.h"
+#include "storage/free_space_map.h"
+#include "storage/table_dictionary.h"
 #include "storage/table_iterator.h"
+#include "storage/zone_map.h"
 #include "transaction/lock_manager.h"
 #include "transaction/log_manager.h"
 
+/**
+ * How the pages of a table heap store their tuples.
+ */
+enum class TableLayout {
+  ROW = 0,  // TablePage, each tuple is stored as a whole
+  PAX,      // PaxPage, the values of a page are grouped by column so a scan decodes only the columns it reads
+};
+
 class TableHeap {
   friend class TableIterator;
 
  public:
   static TableHeap *Create(BufferPoolManager *buffer_pool_manager, Schema *schema, Transaction *txn,
-                           LogManager *log_manager, LockManager *lock_manager) {
-    return new TableHeap(buffer_pool_manager, schema, txn, log_manager, lock_manager);
+                           LogManager *log_manager, LockManager *lock_manager,
+                           TableLayout layout = TableLayout::ROW) {
+    return new TableHeap(buffer_pool_manager, schema, txn, log_manager, lock_manager, layout);
   }
 
-  static TableHeap *Create(BufferPoolManager *buffer_pool_manager, page_id_t first_page_id, Schema *schema,
-                           LogManager *log_manager, LockManager *lock_manager) {
-    return new TableHeap(buffer_pool_manager, first_page_id, schema, log_manager, lock_manager);
+  /**
+   * Open an existing table heap.
+   * @param free_space_map_page_id first page of the free space map of the heap
+   * @param layout layout the heap was created with
+   * @param dictionary_page_id first page of the dictionaries of the heap, INVALID_PAGE_ID if it has none
+   * @param zone_map_page_id first page of the zone map of the heap, INVALID_PAGE_ID if it has none
+   */
+  static TableHeap *Create(BufferPoolManager *buffer_pool_manager, page_id_t first_page_id,
+                           page_id_t free_space_map_page_id, Schema *schema, LogManager *log_manager,
+                           LockManager *lock_manager, TableLayout layout = TableLayout::ROW,
+                           page_id_t dictionary_page_id = INVALID_PAGE_ID,
+                           page_id_t zone_map_page_id = INVALID_PAGE_ID) {
+    return new TableHeap(buffer_pool_manager, first_page_id, free_space_map_page_id, schema, log_manager,
+                         lock_manager, layout, dictionary_page_id, zone_map_page_id);
   }
 
-  ~TableHeap() {}
+  ~TableHeap() {
+    zone_map_.Flush();
+    buffer_pool_manager_->ReleaseReservation(&reservation_);
+    buffer_pool_manager_->ReleaseReservation(&overflow_reservation_);
+  }
 
   /**
    * Insert a tuple into the table. If the tuple is too large (>= page_size), return false.
+   * Each thread keeps inserting into its own page until that page is full or ReleaseInsertPage gives it back, the next
+   * one is claimed from the free space map, so concurrent inserters latch different pages. A new page is appended only
+   * if no unclaimed page has room.
+   * The chars of dictionary encoded columns are replaced by their codes first. A row that is still larger than
+   * page_size / TOAST_TUPLE_FRACTION then moves its longest chars to overflow pages, the tuple only keeps a reference
+   * to them.
    * @param[in/out] row Tuple Row to insert, the rid of the inserted tuple is wrapped in object row
    * @param[in] txn The transaction performing the insert
    * @return true iff the insert is successful
    */
   bool InsertTuple(Row &row, Transaction *txn);
 
+  /**
+   * Insert a batch of tuples. Each target page is filled with as many rows as fit under a single latch and pin before
+   * the next page is picked, rows keep their order.
+   * @param[in/out] rows Rows to insert, the rid of every inserted tuple is wrapped in its row
+   * @param[out] rids Rids of the inserted tuples are appended in row order
+   * @param[in] txn The transaction performing the insert
+   * @return true iff all rows are inserted, no row is inserted if one of them is too large
+   */
+  bool InsertTuples(std::vector<Row> &rows, std::vector<RowId> &rids, Transaction *txn);
+
+  /**
+   * The calling thread is done inserting for now: its insert page goes back to the free space map, where other
+   * inserters may claim it. The executors call it at the end of every statement that inserts; a thread inserting
+   * through the heap directly calls it before it exits, otherwise its page stays claimed until vacuum frees it.
+   */
+  void ReleaseInsertPage();
+
   /**
    * Mark the tuple as deleted. The actual delete will occur when ApplyDelete is called.
    * @param[in] rid Resource id of the tuple of delete
@@ -71,60 +130,316 @@ class TableHeap {
    */
   bool GetTuple(Row *row, Transaction *txn);
 
+  /**
+   * Read the chars a tuple keeps outside of it, in overflow pages or as codes of a dictionary. GetTuple and the
+   * iterator only decode the references and codes, so that a scan reads the values of the columns it needs and
+   * nothing else.
+   * @param[in/out] row Row read from this table, with the fields of all its columns
+   * @param columns if not nullptr, only the fields set in it are read
+   * @return false if an overflow page could not be read or a code is unknown
+   */
+  bool LoadExternalFields(Row &row, const std::vector<bool> *columns = nullptr);
+
+  /**
+   * Get the code of a value in the dictionary of a column, so that the value can be compared with the codes stored
+   * in the tuples.
+   * @return false if the column is not dictionary encoded or the value has no code, the value is then stored inline
+   * wherever it occurs in the column
+   */
+  bool FindCode(uint32_t column, const Field &field, uint32_t *code);
+
+  /**
+   * Check the zone map of a page against `value comp_type constant` on a column, see ZoneMap::MayMatch.
+   * @return false if no tuple of the page can satisfy the comparison
+   */
+  bool MayMatch(page_id_t page_id, uint32_t column, const std::string &comp_type, const Field &constant) {
+    return zone_map_.MayMatch(page_id, column, comp_type, constant);
+  }
+
+  /** @return true if the pages of this heap have zone maps, i.e. the table has int or float columns */
+  inline bool HasZoneMap() const { return zone_map_.IsEnabled(); }
+
   void FreeTableHeap() {
+    free_space_map_.Destroy();
+    dictionary_.Destroy();
+    zone_map_.Destroy();
+    buffer_pool_manager_->ReleaseReservation(&overflow_reservation_);
     auto next_page_id = first_page_id_;
     while (next_page_id != INVALID_PAGE_ID) {
       auto old_page_id = next_page_id;
+      FreeOverflowOfPage(old_page_id);
       auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(old_page_id));
-      assert(page != nullptr);
+      if (page == nullptr) {  // the rest of the chain can not be found, its pages stay allocated
+        LOG(ERROR) << "Cannot read page " << old_page_id << " while freeing a table";
+        buffer_pool_manager_->DeletePage(old_page_id);
+        break;
+      }
       next_page_id = page->GetNextPageId();
       buffer_pool_manager_->UnpinPage(old_page_id, false);
       buffer_pool_manager_->DeletePage(old_page_id);
     }
   }
 
+  /**
+   * Remove the tuples marked deleted and compact the pages that held them, then unlink the pages left empty from the
+   * page chain and free them; the first page always stays. Pages are unlinked, so no other thread may use the heap
+   * meanwhile, DBStorageEngine runs it between statements.
+   * @param[out] freed_pages if not nullptr, the number of pages freed
+   * @return the number of deleted tuples removed
+   * @throw std::runtime_error if a page can not be fetched, the pages before it are vacuumed
+   */
+  uint32_t Vacuum(uint32_t *freed_pages = nullptr);
+
+  /** @return the number of tuples marked deleted since the last vacuum of this heap object */
+  inline uint32_t GetDeadTupleCount() const { return dead_tuples_.load(); }
+
   /**
    * Free table heap and release storage in disk file
    */
   void DeleteTable(page_id_t page_id = INVALID_PAGE_ID);
 
   /**
+   * @param strategy bulk read strategy for a large scan, pages then cycle through its ring instead of the whole pool
+   * @param columns if not nullptr, the columns the scan reads; the other fields of a PAX tuple are left null instead
+   * of being decoded, a ROW tuple is always decoded whole
+   * @param page_filter if not nullptr, the pages it returns false for are skipped without being read
    * @return the begin iterator of this table
+   * @throw std::runtime_error if a page can not be fetched, also when the iterator is advanced
    */
-  TableIterator Begin(Transaction *txn);
+  TableIterator Begin(Transaction *txn, BufferAccessStrategy *strategy = nullptr,
+                      const std::vector<bool> *columns = nullptr, const PageFilter *page_filter = nullptr);
 
   /**
    * @return the end iterator of this table
    */
   TableIterator End();
 
+  /**
+   * Decode the live tuples of one page and append them to rows. The page is only latched while the tuples are
+   * decoded, so their long chars and codes are loaded afterwards with LoadExternalFields, as a TableIterator does.
+   * Used by parallel scans, whose workers each take a part of GetPageIds instead of following the page chain.
+   * @param columns as for Begin
+   * @return false if the page could not be fetched
+   */
+  bool ScanPage(page_id_t page_id, BufferAccessStrategy *strategy, const std::vector<bool> *columns,
+                std::deque<Row> *rows);
+
+  /**
+   * @return the pages of this table in chain order, they stay valid until the next vacuum
+   */
+  inline std::vector<page_id_t> GetPageIds() { return free_space_map_.GetPages(); }
+
   /**
    * @return the id of the first page of this table
    */
   inline page_id_t GetFirstPageId() const { return first_page_id_; }
 
+  /**
+   * @return the id of the first page of the free space map of this table
+   */
+  inline page_id_t GetFreeSpaceMapPageId() const { return free_space_map_.GetFirstPageId(); }
+
+  /**
+   * @return the id of the first page of the dictionaries of this table, INVALID_PAGE_ID if it has no dictionary column
+   */
+  inline page_id_t GetDictionaryPageId() const { return dictionary_.GetFirstPageId(); }
+
+  /**
+   * @return the id of the first page of the zone map of this table, INVALID_PAGE_ID if it has no int or float column
+   */
+  inline page_id_t GetZoneMapPageId() const { return zone_map_.GetFirstPageId(); }
+
+  /**
+   * @return the number of pages of this table, not counting the free space map
+   */
+  inline size_t GetPageCount() { return free_space_map_.GetPageCount(); }
+
+  /**
+   * @return the layout of the pages of this table
+   */
+  inline TableLayout GetLayout() const { return layout_; }
+
 private:
   /**
    * create table heap and initialize first page
    */
   explicit TableHeap(BufferPoolManager *buffer_pool_manager, Schema *schema, Transaction *txn,
-                     LogManager *log_manager, LockManager *lock_manager) :
+                     LogManager *log_manager, LockManager *lock_manager, TableLayout layout) :
           buffer_pool_manager_(buffer_pool_manager),
           schema_(schema),
           log_manager_(log_manager),
-          lock_manager_(lock_manager) {
-    auto p=reinterpret_cast<TablePage *>(buffer_pool_manager->NewPage(first_page_id_));
-    p->Init(first_page_id_, INVALID_PAGE_ID, log_manager, txn);
+          lock_manager_(lock_manager),
+          layout_(layout),
+          free_space_map_(buffer_pool_manager),
+          dictionary_(buffer_pool_manager),
+          zone_map_(buffer_pool_manager, schema) {
+    InitLayout();
+    if(has_dictionary_columns_) dictionary_.Create(&overflow_reservation_);
+    auto p=reinterpret_cast<TablePage *>(buffer_pool_manager->NewPage(first_page_id_, &reservation_));
+    InitPage(p, first_page_id_, INVALID_PAGE_ID, txn);
+    free_space_map_.Create(&reservation_);
+    free_space_map_.AddPage(first_page_id_, GetFreeSpace(p), &reservation_);
+    if(zone_map_.IsEnabled() && zone_map_.Create(&reservation_)) zone_map_.AddPage(first_page_id_, &reservation_);
     buffer_pool_manager->UnpinPage(first_page_id_, true);
   };
 
-  explicit TableHeap(BufferPoolManager *buffer_pool_manager, page_id_t first_page_id, Schema *schema,
-                     LogManager *log_manager, LockManager *lock_manager)
+  explicit TableHeap(BufferPoolManager *buffer_pool_manager, page_id_t first_page_id,
+                     page_id_t free_space_map_page_id, Schema *schema, LogManager *log_manager,
+                     LockManager *lock_manager, TableLayout layout, page_id_t dictionary_page_id,
+                     page_id_t zone_map_page_id)
       : buffer_pool_manager_(buffer_pool_manager),
         first_page_id_(first_page_id),
         schema_(schema),
         log_manager_(log_manager),
-        lock_manager_(lock_manager) {}
+        lock_manager_(lock_manager),
+        layout_(layout),
+        free_space_map_(buffer_pool_manager),
+        dictionary_(buffer_pool_manager),
+        zone_map_(buffer_pool_manager, schema) {
+    InitLayout();
+    free_space_map_.Load(free_space_map_page_id);
+    if(dictionary_page_id!=INVALID_PAGE_ID) dictionary_.Load(dictionary_page_id);
+    if(zone_map_page_id!=INVALID_PAGE_ID && !zone_map_.Load(zone_map_page_id)) RebuildZoneMap();
+  }
+
+  void InitLayout() {
+    for (auto column : schema_->GetColumns()) {
+      has_char_columns_ |= column->GetType() == TypeId::kTypeChar;
+      has_dictionary_columns_ |= column->GetType() == TypeId::kTypeChar && column->IsDictionaryEncoded();
+    }
+    uint32_t page_size = buffer_pool_manager_->GetPageSize();
+    max_space_ = layout_ == TableLayout::PAX
+                     ? PaxPage::GetMaxFreeSpace(schema_, page_size)
+                     : TablePage::GetSpaceNeeded(page_size - 32 - PAGE_CHECKSUM_SIZE);
+  }
+
+  /**
+   * Call f with page as the page class of the layout of this heap. TablePage and PaxPage have the same tuple methods,
+   * so f is a generic lambda.
+   */
+  template <typename F>
+  auto WithPage(TablePage *page, F &&f) {
+    if (layout_ == TableLayout::PAX) {
+      return f(static_cast<PaxPage *>(page));
+    }
+    return f(page);
+  }
+
+  void InitPage(TablePage *page, page_id_t page_id, page_id_t prev_id, Transaction *txn) {
+    if (layout_ == TableLayout::PAX) {
+      static_cast<PaxPage *>(page)->Init(page_id, prev_id, schema_, log_manager_, txn);
+    } else {
+      page->Init(page_id, prev_id, log_manager_, txn);
+    }
+  }
+
+  /** @return the free space of a page of this heap, as recorded in the free space map */
+  uint32_t GetFreeSpace(TablePage *page) {
+    return WithPage(page, [](auto *p) { return p->GetFreeSpaceRemaining(); });
+  }
+
+  /** @return the free space a page needs to take row, no page has room for more than max_space_ */
+  uint32_t GetSpaceNeeded(const Row &row) {
+    return layout_ == TableLayout::PAX ? PaxPage::GetSpaceNeeded(row, schema_)
+                                       : TablePage::GetSpaceNeeded(row.GetSerializedSize(schema_));
+  }
+
+  /**
+   * Insert a row whose long chars are already out of line.
+   */
+  bool InsertStored(Row &row, Transaction *txn);
+
+  /**
+   * Append a new page to the page chain and insert as many of the count rows as fit into it. If all of them fit, the
+   * page becomes the insert page of the calling thread.
+   * @return the number of rows inserted, 0 if no page could be allocated
+   */
+  size_t InsertIntoNewPage(Row **rows, size_t count, Transaction *txn);
+
+  /**
+   * @return the page the calling thread inserts into, claimed for it from the free space map if it has none yet,
+   * INVALID_PAGE_ID if every page with space bytes free belongs to another thread
+   */
+  page_id_t GetInsertPage(uint32_t space);
+
+  /**
+   * The calling thread stops inserting into page_id, which is full for its next row, so that other threads may pick it.
+   */
+  void ReleaseInsertPage(page_id_t page_id);
+
+  /**
+   * @return true if row has to go through ToastRow before it is stored
+   */
+  bool NeedsToast(const Row &row);
+
+  /**
+   * @return true if row has values of dictionary encoded columns that EncodeRow replaces by codes
+   */
+  bool NeedsEncoding(const Row &row);
+
+  /**
+   * Replace the chars of dictionary encoded columns by their codes, values that get no code stay inline.
+   * @return false if a value needed a new code and the dictionary could not store it
+   */
+  bool EncodeRow(Row &row);
+
+  /**
+   * Read the chars row keeps in overflow pages, leaving its codes as they are.
+   */
+  bool LoadOverflowFields(Row &row, const std::vector<bool> *columns);
+
+  /**
+   * Move the longest chars of row to overflow pages until it is no larger than page_size / TOAST_TUPLE_FRACTION.
+   * References row holds to overflow pages are loaded first, so that every tuple owns its overflow pages.
+   * @return false if an overflow page could not be allocated, row then has no overflow pages
+   */
+  bool ToastRow(Row &row);
+
+  /**
+   * Write len bytes to a new chain of overflow pages.
+   * @return the first page of the chain, INVALID_PAGE_ID if a page could not be allocated
+   */
+  page_id_t WriteOverflow(const char *data, uint32_t len);
+
+  /**
+   * Read the len bytes of the overflow chain starting at page_id into buf.
+   */
+  bool ReadOverflow(page_id_t page_id, uint32_t len, char *buf);
+
+  void FreeOverflowChain(page_id_t page_id);
+
+  /**
+   * Free the overflow pages the out of line chars of row refer to.
+   */
+  void FreeOverflow(Row &row);
+
+  /**
+   * Free the overflow pages of every tuple in a page of this heap.
+   */
+  void FreeOverflowOfPage(page_id_t page_id);
+
+  /**
+   * Recompute the zone map summary of a vacuumed page from its live tuples. Caller must hold the page latch.
+   */
+  void ResetZoneMap(TablePage *page);
+
+  /**
+   * List every page of the heap in the zone map again with the summary of its tuples, after the map was loaded from
+   * a table that was not closed cleanly.
+   */
+  void RebuildZoneMap();
+
+  /**
+   * @return the first page from page_id on in chain order that page_filter does not reject, the pages before it are
+   * found through the zone map without being read, a page missing from the map is never skipped
+   */
+  page_id_t SkipPages(page_id_t page_id, const PageFilter &page_filter);
+
+  /**
+   * Fail a scan or vacuum on a page that FetchPage returned nullptr for, because it is corrupt or the pool has no free
+   * frame, instead of treating it as the end of the table.
+   */
+  [[noreturn]] static void ThrowUnreadable(page_id_t page_id);
 
  private:
   BufferPoolManager *buffer_pool_manager_;
@@ -132,6 +447,19 @@ private:
   Schema *schema_;
   LogManager *log_manager_;
   LockManager *lock_manager_;
+  TableLayout layout_;
+  uint32_t max_space_{0};                   // free space of an empty page, a larger row can not be stored
+  ExtentReservation reservation_;           // run of adjacent pages new pages of this heap are taken from
+  ExtentReservation overflow_reservation_;  // run overflow pages are taken from, apart from the pages scans read
+  FreeSpaceMap free_space_map_;             // free space of every page, picks the page an insert goes to
+  TableDictionary dictionary_;              // codes of the values of the dictionary encoded columns
+  ZoneMap zone_map_;                        // value range of the int and float columns of every page
+  std::mutex extend_latch_;                 // serializes appending pages to the page chain
+  std::mutex insert_pages_latch_;           // protects insert_pages_
+  bool has_char_columns_{false};            // only chars are stored out of line
+  bool has_dictionary_columns_{false};      // some char column is dictionary encoded
+  std::atomic<uint32_t> dead_tuples_{0};    // tuples marked deleted and not vacuumed yet
+  std::unordered_map<std::thread::id, page_id_t> insert_pages_;  // page each inserting thread fills
 };
 
 #endif  // MINISQL_TABLE_HEAP_H
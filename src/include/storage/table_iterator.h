@@ -1,6 +1,10 @@
 #ifndef MINISQL_TABLE_ITERATOR_H
 #define MINISQL_TABLE_ITERATOR_H
 
+#include <functional>
+#include <vector>
+
+#include "buffer/buffer_access_strategy.h"
 #include "common/rowid.h"
 #include "record/row.h"
 #include "transaction/transaction.h"
@@ -8,14 +12,34 @@
 
 class TableHeap;
 
+/** Tells a scan whether a page may hold tuples it wants, a page it returns false for is skipped. */
+using PageFilter = std::function<bool(page_id_t)>;
+
+/**
+ * Iterator over the tuples of a table heap. The page of the current tuple stays pinned until the iterator moves past
+ * its last tuple, so a scan fetches every page once and decodes its tuples straight from the frame.
+ *
+ * A copy does not share the pin of the original, it pins the page again only when it is advanced itself. A page that
+ * can not be fetched throws std::runtime_error instead of ending the scan, which would look like a complete table.
+ */
 class TableIterator {
 public:
-  // you may define your own constructor based on your member variables
+  /** The end iterator */
   explicit TableIterator();
 
-  explicit TableIterator(RowId* rid, TableHeap* th, Transaction* txn);
+  /**
+   * Iterator positioned on the first tuple of the page chain starting at first_page_id.
+   * @param strategy bulk read strategy the pages of the scan are fetched with, nullptr for the normal replacement
+   * @param columns if not nullptr, only these columns of a PAX tuple are decoded
+   * @param page_filter if not nullptr, the pages it rejects are skipped without being read
+   */
+  explicit TableIterator(TableHeap* th, page_id_t first_page_id, Transaction* txn,
+                         BufferAccessStrategy *strategy = nullptr, const std::vector<bool> *columns = nullptr,
+                         const PageFilter *page_filter = nullptr);
+
+  TableIterator(const TableIterator &other);
 
-  explicit TableIterator(const TableIterator &other);
+  TableIterator(TableIterator &&other) noexcept;
 
   virtual ~TableIterator();
 
@@ -27,18 +51,33 @@ public:
 
   Row *operator->();
 
-  TableIterator &operator=(const TableIterator &itr) noexcept;
+  TableIterator &operator=(const TableIterator &itr);
+
+  TableIterator &operator=(TableIterator &&itr) noexcept;
 
   TableIterator &operator++();
 
   TableIterator operator++(int);
 
 private:
+  /**
+   * Decode the first live tuple at or after slot of the pinned page, moving on to the following pages when the page
+   * has none left. The row id becomes invalid at the end of the table.
+   * @throw std::runtime_error if a following page can not be fetched
+   */
+  void Seek(uint32_t slot);
+
+  /** Unpin the current page, if any. */
+  void Release();
+
   // add your own private member variables here
-  Row *row_;
-  TableHeap *heap_;
-  TablePage *page_;
-  Transaction *txn_;
+  Row row_;                   // current tuple, its row id is INVALID_ROWID at the end
+  TableHeap *heap_{nullptr};
+  TablePage *page_{nullptr};  // pinned page of the current tuple, nullptr if this iterator holds no pin
+  Transaction *txn_{nullptr};
+  BufferAccessStrategy *strategy_{nullptr};
+  std::vector<bool> columns_;  // columns decoded from a PAX page, empty for all
+  PageFilter page_filter_;     // pages the scan reads, empty for all
 };
 
 #endif  // MINISQL_TABLE_ITERATOR_H
@@ -0,0 +1,160 @@
+#ifndef MINISQL_ZONE_MAP_H
+#define MINISQL_ZONE_MAP_H
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "page/zone_map_page.h"
+#include "record/row.h"
+#include "record/schema.h"
+
+/**
+ * ZoneMap summarizes the int and float columns of every page of a table heap: the smallest and largest value and
+ * the number of nulls stored in the page. A scan asks it whether a page can hold a tuple that satisfies a comparison
+ * and skips the pages that can not, without reading them.
+ *
+ * A summary only widens when tuples are inserted or updated, deleted values stay in it until the page is vacuumed,
+ * so it may cover more than the page holds but never less. The map lives in a chain of ZoneMapPages that list the
+ * heap pages in chain order, which is also how a scan finds the page after a skipped one. It is kept in memory and
+ * the changed map pages are written back by Flush, not on every insert: ascending keys widen the summary of the last
+ * page with nearly every tuple, and writing through would fetch a map page for each of them.
+ *
+ * Heap pages reach disk long before Flush, so the map pages on disk are only trusted if the clean flag of the first
+ * one is set. The flag is cleared on disk before the map first changes and set again by Flush once all map pages are
+ * written; a map loaded without it is rebuilt from the heap. If the map can not record a page, it is turned off until
+ * the table is reopened and every page may match.
+ */
+class ZoneMap {
+ public:
+  ZoneMap(BufferPoolManager *buffer_pool_manager, Schema *schema);
+
+  /** @return true if the table has columns to summarize, otherwise the map has no pages */
+  inline bool IsEnabled() const { return !columns_.empty(); }
+
+  /** @return true if the map knows every heap page, i.e. it has pages and was not turned off */
+  bool IsUsable();
+
+  /**
+   * Allocate the first page of a new, empty map.
+   * @return false if no page could be allocated
+   */
+  bool Create(ExtentReservation *reservation);
+
+  /**
+   * Read an existing map, starting from its first page.
+   * @return false if the map was not flushed clean, it then lists no heap page and has to be rebuilt with AddPage
+   * and Reset in chain order
+   */
+  bool Load(page_id_t first_page_id);
+
+  /**
+   * Write the map pages changed since the last flush and mark the map clean on disk, done when the table heap is
+   * closed.
+   */
+  void Flush();
+
+  /**
+   * Drop every summary and stop keeping the map, so that every page may match. The map stays unclean on disk and is
+   * rebuilt when the table is opened again.
+   */
+  void TurnOff();
+
+  /**
+   * Delete the pages of the map.
+   */
+  void Destroy();
+
+  /** @return the first page of the map, kept in the table metadata */
+  inline page_id_t GetFirstPageId() const { return map_pages_.empty() ? INVALID_PAGE_ID : map_pages_.front(); }
+
+  /**
+   * Add a heap page that was appended to the page chain, with an empty summary. If the map needed another page and
+   * none could be allocated, the map is turned off.
+   */
+  void AddPage(page_id_t page_id, ExtentReservation *reservation);
+
+  /**
+   * Drop heap pages that were unlinked from the page chain.
+   */
+  void RemovePages(const std::vector<page_id_t> &page_ids);
+
+  /**
+   * Widen the summary of a heap page by the values of rows stored in it.
+   */
+  void Include(page_id_t page_id, Row *const *rows, size_t count);
+
+  /**
+   * Replace the summary of a heap page by one of exactly rows, after the page was vacuumed.
+   */
+  void Reset(page_id_t page_id, Row *const *rows, size_t count);
+
+  /**
+   * @return false if no tuple of page_id can have a value of column for which `value comp_type constant` holds, with
+   * comp_type as in ComparisonExpression; true if one may, or if the page or column has no summary
+   */
+  bool MayMatch(page_id_t page_id, uint32_t column, const std::string &comp_type, const Field &constant);
+
+  /**
+   * Find the heap page after page_id in chain order, INVALID_PAGE_ID if it is the last.
+   * @return false if page_id is not in the map
+   */
+  bool GetNextPage(page_id_t page_id, page_id_t *next_page_id);
+
+ private:
+  union Value {
+    int32_t integer_;
+    float float_;
+  };
+
+  struct Summary {
+    Value min_;
+    Value max_;
+    uint32_t null_count_;
+  };
+  static_assert(sizeof(Summary) == ZoneMapPage::SIZE_SUMMARY, "A summary is stored as it is in memory.");
+
+  /** @return a summary of no value at all, its minimum is above its maximum */
+  Summary EmptySummary(size_t c) const;
+
+  /** Widen the summaries of an entry by row. Caller must hold latch_. */
+  void IncludeRow(uint32_t index, const Row &row);
+
+  /** @return true if a is below b, as values of the column of summary c */
+  bool Less(size_t c, const Value &a, const Value &b) const;
+
+  /**
+   * Mark the map page of an entry for the next flush, clearing the clean flag on disk first if it is set. Caller must
+   * hold latch_.
+   */
+  void MarkDirty(uint32_t index);
+
+  /** MarkDirty for the map page at position m of map_pages_. Caller must hold latch_. */
+  void MarkPageDirty(size_t m);
+
+  /** Set the clean flag of the first map page and write the page. Caller must hold latch_. */
+  bool WriteClean(bool clean);
+
+  /** TurnOff, caller must hold latch_. */
+  void TurnOffLocked();
+
+  BufferPoolManager *buffer_pool_manager_;
+  uint32_t page_size_;
+  std::vector<uint32_t> columns_;                  // table columns with a summary
+  std::vector<TypeId> types_;                      // type of each summarized column
+  std::vector<int32_t> summary_of_;                // summary of each table column, -1 if it has none
+  uint32_t entry_size_;                            // bytes of the entry of one heap page
+  uint32_t entries_per_page_;                      // capacity of one map page
+  std::vector<page_id_t> map_pages_;               // map pages in chain order
+  std::vector<bool> dirty_;                        // map pages changed since the last flush
+  bool clean_on_disk_{false};                      // the clean flag on disk is set
+  bool off_{false};                                // the map could not record a page, see TurnOff
+  std::vector<page_id_t> heap_pages_;              // heap pages in chain order
+  std::vector<Summary> summaries_;                 // summaries of each heap page, columns_.size() per page
+  std::unordered_map<page_id_t, uint32_t> index_;  // position of a heap page in heap_pages_
+  std::mutex latch_;
+};
+
+#endif  // MINISQL_ZONE_MAP_H
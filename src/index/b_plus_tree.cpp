@@ -17,8 +17,9 @@ BPlusTree::BPlusTree(index_id_t index_id, BufferPoolManager *buffer_pool_manager
       processor_(KM),
       leaf_max_size_(leaf_max_size),
       internal_max_size_(internal_max_size) {
-  if (leaf_max_size_==UNDEFINED_SIZE) leaf_max_size_=(PAGE_SIZE-LEAF_PAGE_HEADER_SIZE)/(KM.GetKeySize()+sizeof(RowId)) - 1;
-  if (internal_max_size_==UNDEFINED_SIZE) internal_max_size_=(PAGE_SIZE-INTERNAL_PAGE_HEADER_SIZE)/(KM.GetKeySize()+sizeof(page_id_t)) - 1;
+  int page_size=buffer_pool_manager_->GetPageSize()-PAGE_CHECKSUM_SIZE; //fanout grows with the page size of the database
+  if (leaf_max_size_==UNDEFINED_SIZE) leaf_max_size_=(page_size-LEAF_PAGE_HEADER_SIZE)/(KM.GetKeySize()+sizeof(RowId)) - 1;
+  if (internal_max_size_==UNDEFINED_SIZE) internal_max_size_=(page_size-INTERNAL_PAGE_HEADER_SIZE)/(KM.GetKeySize()+sizeof(page_id_t)) - 1;
   auto page=buffer_pool_manager_->FetchPage(INDEX_ROOTS_PAGE_ID);
   auto index_roots_page=reinterpret_cast<IndexRootsPage *>(page->GetData());
   index_roots_page->GetRootId(index_id, &root_page_id_);
@@ -26,6 +27,7 @@ BPlusTree::BPlusTree(index_id_t index_id, BufferPoolManager *buffer_pool_manager
 }
 
 void BPlusTree::Destroy(page_id_t current_page_id) {  //current_page_id==INVALID_PAGE_ID?
+  buffer_pool_manager_->ReleaseReservation(&reservation_);  //give the unused pages back
   if(current_page_id==root_page_id_){
     root_page_id_=INVALID_PAGE_ID;
     UpdateRootPageId();
@@ -94,7 +96,7 @@ bool BPlusTree::Insert(GenericKey *key, const RowId &value, Transaction *transac
  * tree's root page id and insert entry directly into leaf page.
  */
 void BPlusTree::StartNewTree(GenericKey *key, const RowId &value) {
-  auto page=buffer_pool_manager_->NewPage(root_page_id_);
+  auto page=buffer_pool_manager_->NewPage(root_page_id_, &reservation_);
   ASSERT(page!=nullptr, "Out of memory!");
   auto root_page=reinterpret_cast<LeafPage *>(page->GetData());
   root_page->Init(root_page_id_, INVALID_PAGE_ID, processor_.GetKeySize(), leaf_max_size_);
@@ -142,7 +144,7 @@ bool BPlusTree::InsertIntoLeaf(GenericKey *key, const RowId &value, Transaction
  */
 BPlusTreeInternalPage *BPlusTree::Split(InternalPage *node, Transaction *transaction) {
   page_id_t page_id;
-  auto page=buffer_pool_manager_->NewPage(page_id);
+  auto page=buffer_pool_manager_->NewPage(page_id, &reservation_);
   ASSERT(page!=nullptr, "Out of memory!");
   auto new_internal_page=reinterpret_cast<InternalPage *>(page->GetData());
   new_internal_page->Init(page_id, node->GetParentPageId(), node->GetKeySize(), internal_max_size_);
@@ -152,7 +154,7 @@ BPlusTreeInternalPage *BPlusTree::Split(InternalPage *node, Transaction *transac
 
 BPlusTreeLeafPage *BPlusTree::Split(LeafPage *node, Transaction *transaction) {
   page_id_t page_id;
-  auto page=buffer_pool_manager_->NewPage(page_id);
+  auto page=buffer_pool_manager_->NewPage(page_id, &reservation_);
   ASSERT(page!=nullptr, "Out of memory!");
   auto new_leaf_page=reinterpret_cast<LeafPage *>(page->GetData());
   new_leaf_page->Init(page_id, node->GetParentPageId(), node->GetKeySize(), leaf_max_size_);
@@ -172,7 +174,7 @@ BPlusTreeLeafPage *BPlusTree::Split(LeafPage *node, Transaction *transaction) {
 void BPlusTree::InsertIntoParent(BPlusTreePage *old_node, GenericKey *key, BPlusTreePage *new_node,
                                  Transaction *transaction) {
   if(old_node->IsRootPage()){
-    auto page=buffer_pool_manager_->NewPage(root_page_id_);
+    auto page=buffer_pool_manager_->NewPage(root_page_id_, &reservation_);
     ASSERT(page!=nullptr, "Out of memory");
     auto new_root_page=reinterpret_cast<InternalPage *>(page->GetData());
     new_root_page->Init(root_page_id_, INVALID_PAGE_ID, old_node->GetKeySize(), internal_max_size_);
@@ -8,6 +8,8 @@ IndexIterator::IndexIterator() = default;
 IndexIterator::IndexIterator(page_id_t page_id, BufferPoolManager *bpm, int index)
     : current_page_id(page_id), item_index(index), buffer_pool_manager(bpm) {
   page = reinterpret_cast<LeafPage *>(buffer_pool_manager->FetchPage(current_page_id)->GetData());
+  // range scans walk the leaf chain, start reading the following leaves
+  buffer_pool_manager->ReadAhead(page->GetNextPageId(), DEFAULT_READ_AHEAD_PAGES, LeafPage::ReadNextPageId);
 }
 
 IndexIterator::~IndexIterator() {
@@ -31,6 +33,8 @@ IndexIterator &IndexIterator::operator++() {
       current_page_id=page->GetNextPageId();
       page = reinterpret_cast<LeafPage *>(buffer_pool_manager->FetchPage(current_page_id)->GetData());
       item_index=0;
+      // the leaves prefetched last time are resident now, so this only reads the one at the end of the window
+      buffer_pool_manager->ReadAhead(page->GetNextPageId(), DEFAULT_READ_AHEAD_PAGES, LeafPage::ReadNextPageId);
     }
   }
   return *this;
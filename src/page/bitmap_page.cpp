@@ -1,5 +1,7 @@
 #include "page/bitmap_page.h"
 
+#include <cstring>
+
 #include "glog/logging.h"
 
 /**
@@ -7,22 +9,13 @@
  */
 template <size_t PageSize>
 bool BitmapPage<PageSize>::AllocatePage(uint32_t &page_offset) {
-  if(page_allocated_<GetMaxSupportedSize()){  //not full
-    while(!IsPageFree(next_free_page_)){
-      next_free_page_++;  //find next free page
-      if(next_free_page_==GetMaxSupportedSize()) break;
-    } 
-    page_offset=next_free_page_;
-    uint32_t byte_offset=page_offset/8, bit_offset=page_offset%8;
-    bytes[byte_offset] |= (1<<(7-bit_offset)); //update corresponding bit
-    page_allocated_++;  //add number of allocated pages
-    while(!IsPageFree(next_free_page_)){
-      next_free_page_++;  //find next free page
-      if(next_free_page_==GetMaxSupportedSize()) break;
-    }
-    return true;
-  }
-  else return false;
+  if(page_allocated_>=GetMaxSupportedSize()) return false;  //full
+  page_offset=FindFirstFree(next_free_page_);
+  uint32_t byte_offset=page_offset/8, bit_offset=page_offset%8;
+  bytes[byte_offset] |= (1<<(7-bit_offset)); //update corresponding bit
+  page_allocated_++;  //add number of allocated pages
+  next_free_page_=FindFirstFree(page_offset+1); //find next free page
+  return true;
 }
 
 /**
@@ -51,7 +44,54 @@ bool BitmapPage<PageSize>::IsPageFree(uint32_t page_offset) const {
 
 template <size_t PageSize>
 bool BitmapPage<PageSize>::IsPageFreeLow(uint32_t byte_index, uint8_t bit_index) const {
-  return false;
+  return (bytes[byte_index] & (1 << (7 - bit_index))) == 0;
+}
+
+template <size_t PageSize>
+bool BitmapPage<PageSize>::AllocatePageAt(uint32_t page_offset) {
+  if (!IsPageFree(page_offset)) return false;
+  bytes[page_offset / 8] |= (1 << (7 - page_offset % 8));
+  page_allocated_++;
+  if (page_offset == next_free_page_) next_free_page_ = FindFirstFree(page_offset + 1);
+  return true;
+}
+
+template <size_t PageSize>
+uint64_t BitmapPage<PageSize>::LoadWord(uint32_t word_index) const {
+  // page i is bit 7 - i % 8 of byte i / 8, so a big endian load puts page i of a word at bit 63 - i % 64
+  uint64_t word;
+  memcpy(&word, bytes + word_index * sizeof(uint64_t), sizeof(uint64_t));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  word = __builtin_bswap64(word);
+#endif
+  return word;
+}
+
+template <size_t PageSize>
+uint32_t BitmapPage<PageSize>::FindFirstFree(uint32_t from) const {
+  for (uint32_t word_index = from / 64; word_index < MAX_CHARS / sizeof(uint64_t); word_index++) {
+    uint64_t word = LoadWord(word_index);
+    if (word_index == from / 64) {
+      word |= from % 64 == 0 ? 0 : ~(~0ULL >> (from % 64));  // pages before from count as allocated
+    }
+    if (word != ~0ULL) {
+      return word_index * 64 + __builtin_clzll(~word);
+    }
+  }
+  return GetMaxSupportedSize();
+}
+
+template <size_t PageSize>
+uint32_t BitmapPage<PageSize>::FindFreeRun(uint32_t from, uint32_t count) const {
+  ASSERT(count > 0 && count % 64 == 0, "Runs are made of whole bitmap words.");
+  uint32_t words = count / 64;
+  uint32_t num_words = MAX_CHARS / sizeof(uint64_t);
+  for (uint32_t first = (from + count - 1) / count * words; first + words <= num_words; first += words) {
+    uint32_t i = 0;
+    while (i < words && LoadWord(first + i) == 0) i++;
+    if (i == words) return first * 64;
+  }
+  return GetMaxSupportedSize();
 }
 
 template class BitmapPage<64>;
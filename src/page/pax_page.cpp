@@ -0,0 +1,376 @@
+#include "page/pax_page.h"
+
+#include <algorithm>
+#include <functional>
+#include <tuple>
+
+void PaxPage::Init(page_id_t page_id, page_id_t prev_id, Schema *schema, LogManager *log_mgr, Transaction *txn) {
+  memcpy(GetData(), &page_id, sizeof(page_id));
+  SetPrevPageId(prev_id);
+  SetNextPageId(INVALID_PAGE_ID);
+  uint32_t column_count = schema->GetColumnCount();
+  uint32_t capacity = ComputeCapacity(schema, GetPageSize());
+  WriteHeader(OFFSET_CAPACITY, capacity);
+  WriteHeader(OFFSET_TUPLE_COUNT, 0);
+  WriteHeader(OFFSET_FREE_SPACE, GetPageSize() - PAGE_CHECKSUM_SIZE);  // the checksum stays at the end of the page
+  WriteHeader(OFFSET_USED_SLOTS, 0);
+  WriteHeader(OFFSET_GARBAGE, 0);
+  WriteHeader(OFFSET_COLUMN_COUNT, column_count);
+  uint32_t char_columns = 0;
+  char *char_bitmap = GetData() + SIZE_PAX_PAGE_HEADER;
+  memset(char_bitmap, 0, (column_count + 7) / 8);
+  for (uint32_t i = 0; i < column_count; i++) {
+    if (schema->GetColumn(i)->GetType() == TypeId::kTypeChar) {
+      char_bitmap[i / 8] |= 1 << (i % 8);
+      char_columns++;
+    }
+  }
+  WriteHeader(OFFSET_CHAR_COLUMN_COUNT, char_columns);
+  memset(GetSlotState(0), SLOT_EMPTY, capacity);
+}
+
+bool PaxPage::InsertTuple(Row &row, Schema *schema, Transaction *txn, LockManager *lock_manager,
+                          LogManager *log_manager) {
+  ASSERT(row.GetFieldCount() == GetColumnCount(), "Fields size do not match schema's column size.");
+  if (GetUsedSlots() >= GetCapacity()) {
+    return false;
+  }
+  uint32_t char_size = GetCharSize(row);
+  uint32_t free_chars = GetFreeSpacePointer() - GetCharAreaBegin();
+  if (char_size > free_chars) {
+    if (char_size > free_chars + GetGarbageBytes()) {
+      return false;
+    }
+    CompactChars();
+  }
+  // Reuse the first empty slot, there is one below the tuple count unless all slots up to it are in use.
+  uint32_t slot_num = 0;
+  while (slot_num < GetTupleCount() && *GetSlotState(slot_num) != SLOT_EMPTY) {
+    slot_num++;
+  }
+  if (slot_num == GetTupleCount()) {
+    WriteHeader(OFFSET_TUPLE_COUNT, slot_num + 1);
+  }
+  EncodeSlot(row, slot_num);
+  *GetSlotState(slot_num) = SLOT_LIVE;
+  WriteHeader(OFFSET_USED_SLOTS, GetUsedSlots() + 1);
+  row.SetRowId(RowId(GetTablePageId(), slot_num));
+  return true;
+}
+
+bool PaxPage::MarkDelete(const RowId &rid, Transaction *txn, LockManager *lock_manager, LogManager *log_manager) {
+  uint32_t slot_num = rid.GetSlotNum();
+  if (slot_num >= GetTupleCount() || *GetSlotState(slot_num) != SLOT_LIVE) {
+    return false;
+  }
+  *GetSlotState(slot_num) = SLOT_DELETED;
+  return true;
+}
+
+int PaxPage::UpdateTuple(const Row &new_row, Row *old_row, Schema *schema, Transaction *txn,
+                         LockManager *lock_manager, LogManager *log_manager) {
+  ASSERT(old_row != nullptr && old_row->GetRowId().Get() != INVALID_ROWID.Get(), "invalid old row.");
+  uint32_t slot_num = old_row->GetRowId().GetSlotNum();
+  if (slot_num >= GetTupleCount()) {
+    return 1;
+  }
+  if (*GetSlotState(slot_num) != SLOT_LIVE) {
+    return 2;
+  }
+  uint32_t char_size = GetCharSize(new_row);
+  uint32_t old_char_size = GetSlotCharSize(slot_num);
+  uint32_t free_chars = GetFreeSpacePointer() - GetCharAreaBegin();
+  if (char_size > free_chars + GetGarbageBytes() + old_char_size) {
+    return 3;
+  }
+  DecodeSlot(old_row, schema, slot_num, nullptr);
+  // The old char values become garbage, they are dropped right away if the new ones need their space.
+  WriteHeader(OFFSET_GARBAGE, GetGarbageBytes() + old_char_size);
+  if (char_size > free_chars) {
+    *GetSlotState(slot_num) = SLOT_EMPTY;
+    CompactChars();
+    *GetSlotState(slot_num) = SLOT_LIVE;
+  }
+  EncodeSlot(new_row, slot_num);
+  return 0;
+}
+
+void PaxPage::ApplyDelete(const RowId &rid, Transaction *txn, LogManager *log_manager) {
+  uint32_t slot_num = rid.GetSlotNum();
+  ASSERT(slot_num < GetTupleCount(), "Cannot have more slots than tuples.");
+  if (*GetSlotState(slot_num) != SLOT_EMPTY) {
+    ReleaseSlot(slot_num);
+  }
+}
+
+void PaxPage::RollbackDelete(const RowId &rid, Transaction *txn, LogManager *log_manager) {
+  uint32_t slot_num = rid.GetSlotNum();
+  ASSERT(slot_num < GetTupleCount(), "We can't have more slots than tuples.");
+  if (*GetSlotState(slot_num) == SLOT_DELETED) {
+    *GetSlotState(slot_num) = SLOT_LIVE;
+  }
+}
+
+bool PaxPage::GetTuple(Row *row, Schema *schema, Transaction *txn, LockManager *lock_manager) {
+  ASSERT(row != nullptr && row->GetRowId().Get() != INVALID_ROWID.Get(), "Invalid row.");
+  uint32_t slot_num = row->GetRowId().GetSlotNum();
+  if (slot_num >= GetTupleCount() || *GetSlotState(slot_num) != SLOT_LIVE) {
+    return false;
+  }
+  DecodeSlot(row, schema, slot_num, nullptr);
+  return true;
+}
+
+bool PaxPage::GetTuple(Row *row, Schema *schema, const std::vector<bool> &columns) {
+  uint32_t slot_num = row->GetRowId().GetSlotNum();
+  if (slot_num >= GetTupleCount() || *GetSlotState(slot_num) != SLOT_LIVE) {
+    return false;
+  }
+  DecodeSlot(row, schema, slot_num, &columns);
+  return true;
+}
+
+bool PaxPage::ReadTuple(Row *row, Schema *schema) {
+  uint32_t slot_num = row->GetRowId().GetSlotNum();
+  if (slot_num >= GetTupleCount() || *GetSlotState(slot_num) == SLOT_EMPTY) {
+    return false;
+  }
+  DecodeSlot(row, schema, slot_num, nullptr);
+  return true;
+}
+
+bool PaxPage::GetFirstTupleRid(RowId *first_rid) {
+  for (uint32_t i = 0; i < GetTupleCount(); i++) {
+    if (*GetSlotState(i) == SLOT_LIVE) {
+      first_rid->Set(GetTablePageId(), i);
+      return true;
+    }
+  }
+  first_rid->Set(INVALID_PAGE_ID, 0);
+  return false;
+}
+
+bool PaxPage::GetNextTupleRid(const RowId &cur_rid, RowId *next_rid) {
+  ASSERT(cur_rid.GetPageId() == GetTablePageId(), "Wrong table!");
+  for (auto i = cur_rid.GetSlotNum() + 1; i < GetTupleCount(); i++) {
+    if (*GetSlotState(i) == SLOT_LIVE) {
+      next_rid->Set(GetTablePageId(), i);
+      return true;
+    }
+  }
+  next_rid->Set(INVALID_PAGE_ID, 0);
+  return false;
+}
+
+bool PaxPage::Vacuum(Schema *schema, uint32_t *removed_tuples, std::vector<Row> *removed_rows) {
+  *removed_tuples = 0;
+  uint32_t tuple_count = GetTupleCount();
+  for (uint32_t i = 0; i < tuple_count; i++) {
+    if (*GetSlotState(i) != SLOT_DELETED) {
+      continue;
+    }
+    if (removed_rows != nullptr) {
+      removed_rows->emplace_back(RowId(GetTablePageId(), i));
+      DecodeSlot(&removed_rows->back(), schema, i, nullptr);
+    }
+    ReleaseSlot(i);
+    (*removed_tuples)++;
+  }
+  bool compacted = GetGarbageBytes() > 0;
+  if (compacted) {
+    CompactChars();
+  }
+  uint32_t new_count = tuple_count;
+  while (new_count > 0 && *GetSlotState(new_count - 1) == SLOT_EMPTY) {
+    new_count--;
+  }
+  WriteHeader(OFFSET_TUPLE_COUNT, new_count);
+  return *removed_tuples > 0 || compacted || new_count != tuple_count;
+}
+
+uint32_t PaxPage::GetFreeSpaceRemaining() {
+  if (GetUsedSlots() >= GetCapacity()) {
+    return 0;
+  }
+  if (GetCharColumnCount() == 0) {
+    return (GetCapacity() - GetUsedSlots()) * ((GetSlotBits(GetColumnCount()) + 7) / 8);
+  }
+  return GetFreeSpacePointer() - GetCharAreaBegin() + GetGarbageBytes();
+}
+
+uint32_t PaxPage::GetSpaceNeeded(const Row &row, Schema *schema) {
+  for (auto column : schema->GetColumns()) {
+    if (column->GetType() == TypeId::kTypeChar) {
+      return std::max<uint32_t>(GetCharSize(row), 1);  // a free slot alone is not enough if the map says 0
+    }
+  }
+  return (GetSlotBits(schema->GetColumnCount()) + 7) / 8;
+}
+
+uint32_t PaxPage::GetMaxFreeSpace(Schema *schema, uint32_t page_size) {
+  uint32_t column_count = schema->GetColumnCount();
+  uint32_t capacity = ComputeCapacity(schema, page_size);
+  if (capacity == 0) {
+    return 0;
+  }
+  bool has_chars = false;
+  for (auto column : schema->GetColumns()) {
+    has_chars |= column->GetType() == TypeId::kTypeChar;
+  }
+  if (!has_chars) {
+    return capacity * ((GetSlotBits(column_count) + 7) / 8);
+  }
+  uint32_t char_area_begin = SIZE_PAX_PAGE_HEADER + (column_count + 7) / 8 + capacity +
+                             (column_count * capacity + 7) / 8 + SIZE_ENTRY * column_count * capacity;
+  return page_size - PAGE_CHECKSUM_SIZE - char_area_begin;
+}
+
+uint32_t PaxPage::ComputeCapacity(Schema *schema, uint32_t page_size) {
+  uint32_t column_count = schema->GetColumnCount();
+  uint64_t fixed = SIZE_PAX_PAGE_HEADER + (column_count + 7) / 8 + 1;  // one more byte for the null bitmap rounding
+  if (page_size < PAGE_CHECKSUM_SIZE + fixed) {
+    return 0;
+  }
+  uint64_t usable = page_size - PAGE_CHECKSUM_SIZE - fixed;
+  uint64_t slot_bits = GetSlotBits(column_count);
+  // Expected bytes of the char values of a row, and the most a row can need once its long chars are out of line.
+  uint64_t expected_chars = 0;
+  uint64_t row_chars = 0;
+  uint32_t char_columns = 0;
+  for (auto column : schema->GetColumns()) {
+    if (column->GetType() != TypeId::kTypeChar) {
+      continue;
+    }
+    expected_chars += std::min<uint64_t>(column->GetLength(), page_size / TOAST_TUPLE_FRACTION) + sizeof(uint32_t);
+    row_chars += static_cast<uint64_t>(column->GetLength()) + sizeof(uint32_t);
+    char_columns++;
+  }
+  if (char_columns == 0) {
+    return static_cast<uint32_t>(usable * 8 / slot_bits);
+  }
+  uint64_t external_chars = (sizeof(uint32_t) + sizeof(page_id_t)) * char_columns;  // every char out of line
+  row_chars = std::min<uint64_t>(row_chars, std::max<uint64_t>(page_size / TOAST_TUPLE_FRACTION, external_chars));
+  if (usable <= row_chars) {
+    return 0;
+  }
+  // the slots must leave room for the largest row in an empty page
+  return static_cast<uint32_t>(
+      std::min(usable * 8 / (slot_bits + 8 * expected_chars), (usable - row_chars) * 8 / slot_bits));
+}
+
+uint32_t PaxPage::GetCharSize(const Row &row) {
+  uint32_t size = 0;
+  for (size_t i = 0; i < row.GetFieldCount(); i++) {
+    Field *field = row.GetField(i);
+    if (field->GetTypeId() == TypeId::kTypeChar && !field->IsNull()) {
+      size += field->GetSerializedSize();
+    }
+  }
+  return size;
+}
+
+bool PaxPage::IsNull(uint32_t column, uint32_t slot_num) {
+  uint32_t bit = column * GetCapacity() + slot_num;
+  return (GetSlotState(GetCapacity())[bit / 8] >> (bit % 8)) & 1;  // the null bitmap follows the slot states
+}
+
+void PaxPage::SetNull(uint32_t column, uint32_t slot_num, bool is_null) {
+  uint32_t bit = column * GetCapacity() + slot_num;
+  uint8_t *null_bitmap = GetSlotState(GetCapacity());
+  if (is_null) {
+    null_bitmap[bit / 8] |= 1 << (bit % 8);
+  } else {
+    null_bitmap[bit / 8] &= ~(1 << (bit % 8));
+  }
+}
+
+char *PaxPage::GetEntry(uint32_t column, uint32_t slot_num) {
+  uint32_t capacity = GetCapacity();
+  char *minipages = reinterpret_cast<char *>(GetSlotState(capacity)) + (GetColumnCount() * capacity + 7) / 8;
+  return minipages + SIZE_ENTRY * (column * capacity + slot_num);
+}
+
+uint32_t PaxPage::GetCharAreaBegin() {
+  return static_cast<uint32_t>(GetEntry(GetColumnCount(), 0) - GetData());
+}
+
+uint32_t PaxPage::GetSlotCharSize(uint32_t slot_num) {
+  uint32_t size = 0;
+  for (uint32_t i = 0; i < GetColumnCount(); i++) {
+    if (!IsCharColumn(i) || IsNull(i, slot_num)) {
+      continue;
+    }
+    size += TypeChar::GetStoredSize(GetData() + MACH_READ_UINT32(GetEntry(i, slot_num)));
+  }
+  return size;
+}
+
+void PaxPage::DecodeSlot(Row *row, Schema *schema, uint32_t slot_num, const std::vector<bool> *columns) {
+  ASSERT(row->GetFieldCount() == 0, "Non empty field in row.");
+  auto &fields = row->GetFields();
+  fields.reserve(GetColumnCount());
+  for (uint32_t i = 0; i < GetColumnCount(); i++) {
+    TypeId type = schema->GetColumn(i)->GetType();
+    Field *field = nullptr;  // allocated by the type
+    if ((columns != nullptr && !(*columns)[i]) || IsNull(i, slot_num)) {
+      Field::DeserializeFrom(nullptr, type, &field, true);
+    } else if (IsCharColumn(i)) {
+      Field::DeserializeFrom(GetData() + MACH_READ_UINT32(GetEntry(i, slot_num)), type, &field, false);
+    } else {
+      Field::DeserializeFrom(GetEntry(i, slot_num), type, &field, false);
+    }
+    fields.push_back(field);
+  }
+}
+
+void PaxPage::EncodeSlot(const Row &row, uint32_t slot_num) {
+  for (uint32_t i = 0; i < GetColumnCount(); i++) {
+    Field *field = row.GetField(i);
+    char *entry = GetEntry(i, slot_num);
+    SetNull(i, slot_num, field->IsNull());
+    if (field->IsNull()) {
+      memset(entry, 0, SIZE_ENTRY);
+    } else if (IsCharColumn(i)) {
+      uint32_t free_space_pointer = GetFreeSpacePointer() - field->GetSerializedSize();
+      field->SerializeTo(GetData() + free_space_pointer);
+      WriteHeader(OFFSET_FREE_SPACE, free_space_pointer);
+      MACH_WRITE_UINT32(entry, free_space_pointer);
+    } else {
+      uint32_t __attribute__((unused)) write_bytes = field->SerializeTo(entry);
+      ASSERT(write_bytes == SIZE_ENTRY, "Unexpected behavior in field serialize.");
+    }
+  }
+}
+
+void PaxPage::ReleaseSlot(uint32_t slot_num) {
+  WriteHeader(OFFSET_GARBAGE, GetGarbageBytes() + GetSlotCharSize(slot_num));
+  *GetSlotState(slot_num) = SLOT_EMPTY;
+  WriteHeader(OFFSET_USED_SLOTS, GetUsedSlots() - 1);
+}
+
+void PaxPage::CompactChars() {
+  // Move the values, highest offset first, so that each one only moves over space already freed.
+  std::vector<std::tuple<uint32_t, uint32_t, uint32_t>> values;  // offset, column, slot
+  for (uint32_t slot_num = 0; slot_num < GetTupleCount(); slot_num++) {
+    if (*GetSlotState(slot_num) == SLOT_EMPTY) {
+      continue;
+    }
+    for (uint32_t i = 0; i < GetColumnCount(); i++) {
+      if (IsCharColumn(i) && !IsNull(i, slot_num)) {
+        values.emplace_back(MACH_READ_UINT32(GetEntry(i, slot_num)), i, slot_num);
+      }
+    }
+  }
+  std::sort(values.begin(), values.end(), std::greater<>());
+  uint32_t free_space_pointer = GetPageSize() - PAGE_CHECKSUM_SIZE;
+  for (auto &[offset, column, slot_num] : values) {
+    uint32_t size = TypeChar::GetStoredSize(GetData() + offset);
+    free_space_pointer -= size;
+    if (free_space_pointer != offset) {
+      memmove(GetData() + free_space_pointer, GetData() + offset, size);
+      MACH_WRITE_UINT32(GetEntry(column, slot_num), free_space_pointer);
+    }
+  }
+  WriteHeader(OFFSET_FREE_SPACE, free_space_pointer);
+  WriteHeader(OFFSET_GARBAGE, 0);
+}
@@ -1,10 +1,13 @@
 #include "page/table_page.h"
 
+#include <algorithm>
+#include <functional>
+
 void TablePage::Init(page_id_t page_id, page_id_t prev_id, LogManager *log_mgr, Transaction *txn) {
   memcpy(GetData(), &page_id, sizeof(page_id));
   SetPrevPageId(prev_id);
   SetNextPageId(INVALID_PAGE_ID);
-  SetFreeSpacePointer(PAGE_SIZE);
+  SetFreeSpacePointer(GetPageSize() - PAGE_CHECKSUM_SIZE);  // the checksum stays at the end of the page
   SetTupleCount(0);
 }
 
@@ -163,6 +166,65 @@ bool TablePage::GetTuple(Row *row, Schema *schema, Transaction *txn, LockManager
   return true;
 }
 
+bool TablePage::ReadTuple(Row *row, Schema *schema) {
+  uint32_t slot_num = row->GetRowId().GetSlotNum();
+  if (slot_num >= GetTupleCount()) {
+    return false;
+  }
+  uint32_t tuple_size = UnsetDeletedFlag(GetTupleSize(slot_num));
+  if (tuple_size == 0) {
+    return false;
+  }
+  uint32_t __attribute__((unused)) read_bytes = row->DeserializeFrom(GetData() + GetTupleOffsetAtSlot(slot_num), schema);
+  ASSERT(tuple_size == read_bytes, "Unexpected behavior in tuple deserialize.");
+  return true;
+}
+
+bool TablePage::Vacuum(Schema *schema, uint32_t *removed_tuples, std::vector<Row> *removed_rows) {
+  *removed_tuples = 0;
+  uint32_t tuple_count = GetTupleCount();
+  for (uint32_t i = 0; i < tuple_count; i++) {
+    uint32_t tuple_size = GetTupleSize(i);
+    if (tuple_size == 0 || !IsDeleted(tuple_size)) {
+      continue;
+    }
+    if (removed_rows != nullptr) {
+      removed_rows->emplace_back(RowId(GetTablePageId(), i));
+      removed_rows->back().DeserializeFrom(GetData() + GetTupleOffsetAtSlot(i), schema);
+    }
+    SetTupleSize(i, 0);
+    SetTupleOffsetAtSlot(i, 0);
+    (*removed_tuples)++;
+  }
+  if (*removed_tuples > 0) {
+    // Move the live tuples, highest offset first, so that each one only moves over space already freed.
+    std::vector<std::pair<uint32_t, uint32_t>> live;
+    for (uint32_t i = 0; i < tuple_count; i++) {
+      if (GetTupleSize(i) != 0) {
+        live.emplace_back(GetTupleOffsetAtSlot(i), i);
+      }
+    }
+    std::sort(live.begin(), live.end(), std::greater<>());
+    uint32_t free_space_pointer = GetPageSize() - PAGE_CHECKSUM_SIZE;
+    for (auto &[offset, slot_num] : live) {
+      uint32_t tuple_size = GetTupleSize(slot_num);
+      free_space_pointer -= tuple_size;
+      if (free_space_pointer != offset) {
+        memmove(GetData() + free_space_pointer, GetData() + offset, tuple_size);
+        SetTupleOffsetAtSlot(slot_num, free_space_pointer);
+      }
+    }
+    SetFreeSpacePointer(free_space_pointer);
+  }
+  // Give the space of the empty slots at the end back to the tuple data.
+  uint32_t new_count = tuple_count;
+  while (new_count > 0 && GetTupleSize(new_count - 1) == 0) {
+    new_count--;
+  }
+  SetTupleCount(new_count);
+  return *removed_tuples > 0 || new_count != tuple_count;
+}
+
 bool TablePage::GetFirstTupleRid(RowId *first_rid) {
   // Find and return the first valid tuple.
   for (uint32_t i = 0; i < GetTupleCount(); i++) {
@@ -169,6 +169,12 @@ const char *GetSyntaxNodeTypeStr(SyntaxNodeType type) {
       return "kNodeTrxCommit";
     case kNodeTrxRollback:
       return "kNodeTrxRollback";
+    case kNodeShowBufferStatus:
+      return "kNodeShowBufferStatus";
+    case kNodeVacuum:
+      return "kNodeVacuum";
+    case kNodeTableLayout:
+      return "kNodeTableLayout";
     default:
       return "error type";
   }
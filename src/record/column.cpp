@@ -33,7 +33,8 @@ Column::Column(const Column *other)
       len_(other->len_),
       table_ind_(other->table_ind_),
       nullable_(other->nullable_),
-      unique_(other->unique_) {}
+      unique_(other->unique_),
+      dictionary_(other->dictionary_) {}
 
 /**
 * TODO: Student Implement
@@ -57,6 +58,8 @@ uint32_t Column::SerializeTo(char *buf) const {
   offset += 1;
   memcpy(buf+offset, &unique_, 1);
   offset += 1;
+  memcpy(buf+offset, &dictionary_, 1);  //store dictionary_
+  offset += 1;
   return offset;
 }
 
@@ -65,7 +68,7 @@ uint32_t Column::SerializeTo(char *buf) const {
  */
 uint32_t Column::GetSerializedSize() const {
   // replace with your code here
-  return 18 + name_.length() + sizeof(TypeId);
+  return 19 + name_.length() + sizeof(TypeId);
 }
 
 /**
@@ -94,10 +97,13 @@ uint32_t Column::DeserializeFrom(char *buf, Column *&column) {
   offset += 1;
   bool unique=MACH_READ_FROM(bool, buf+offset); //read unique_
   offset += 1;
+  bool dictionary=MACH_READ_FROM(bool, buf+offset); //read dictionary_
+  offset += 1;
   if (type == kTypeChar) {
     column = new Column(column_name, type, col_len, col_ind, nullable, unique);
   } else {
     column = new Column(column_name, type, col_ind, nullable, unique);
   }
+  column->SetDictionaryEncoded(dictionary);
   return offset;
 }
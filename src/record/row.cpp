@@ -12,12 +12,11 @@ uint32_t Row::SerializeTo(char *buf, Schema *schema) const {
   mempcpy(buf, &cnt, 4);  //store count
   offset += 4;
    
-  char *null_bitmap=new char[cnt/8+1];
+  char *null_bitmap=buf+offset;  //build the null bitmap in place
   memset(null_bitmap, 0, cnt/8+1);
   for(uint32_t i=0; i<cnt; i++){
     if(fields_[i]->IsNull()) null_bitmap[i/8] |= (1<<(7-i%8)); //null->set 1
   }
-  memcpy(buf+offset, null_bitmap, cnt/8+1); //store null bitmap
   offset += cnt/8+1;
 
   for(auto& pf: fields_){
@@ -35,15 +34,15 @@ uint32_t Row::DeserializeFrom(char *buf, Schema *schema) {
   memcpy(&cnt, buf, 4); //read count
   offset += 4;
   
-  char *null_bitmap = new char[cnt/8+1];
-  memcpy(null_bitmap, buf+offset, cnt/8+1); //read null bitmap
+  const char *null_bitmap = buf+offset;  //read null bitmap in place
   offset += cnt/8+1;
   
+  fields_.reserve(cnt);
   for(uint32_t i=0; i<cnt; i++){
     bool is_null=null_bitmap[i/8] & (1<<(7-i%8));
     TypeId type=schema->GetColumn(i)->GetType();
-    auto *f=new Field(type);
-    offset += fields_[i]->DeserializeFrom(buf+offset, type, &f, is_null);  //read fields
+    Field *f=nullptr;  //allocated by the type
+    offset += Field::DeserializeFrom(buf+offset, type, &f, is_null);  //read fields
     fields_.push_back(f);
   }
   return offset;
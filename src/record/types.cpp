@@ -228,6 +228,17 @@ CmpBool TypeFloat::CompareGreaterThanEquals(const Field &left, const Field &righ
 uint32_t TypeChar::SerializeTo(const Field &field, char *buf) const {
   if (!field.IsNull()) {
     uint32_t len = GetLength(field);
+    if (field.IsExternal()) {
+      // length with the external flag set, followed by the first overflow page
+      MACH_WRITE_UINT32(buf, len | EXTERNAL_MASK);
+      MACH_WRITE_INT32(buf + sizeof(uint32_t), field.GetExternalPageId());
+      return sizeof(uint32_t) + sizeof(page_id_t);
+    }
+    if (field.IsCoded()) {
+      // the code takes the place of the length, the value is in the dictionary of the column
+      MACH_WRITE_UINT32(buf, field.GetCode() | CODED_MASK);
+      return sizeof(uint32_t);
+    }
     memcpy(buf, &len, sizeof(uint32_t));
     memcpy(buf + sizeof(uint32_t), field.value_.chars_, len);
     return len + sizeof(uint32_t);
@@ -241,14 +252,37 @@ uint32_t TypeChar::DeserializeFrom(char *storage, Field **field, bool is_null) c
     return 0;
   }
   uint32_t len = MACH_READ_UINT32(storage);
+  if (len & EXTERNAL_MASK) {
+    // only the reference is decoded, the value is read when the column is needed
+    *field = new Field(TypeId::kTypeChar, MACH_READ_INT32(storage + sizeof(uint32_t)), len & ~EXTERNAL_MASK);
+    return sizeof(uint32_t) + sizeof(page_id_t);
+  }
+  if (len & CODED_MASK) {
+    *field = new Field(TypeId::kTypeChar, DictionaryCode{len & ~CODED_MASK});
+    return sizeof(uint32_t);
+  }
   *field = new Field(TypeId::kTypeChar, storage + sizeof(uint32_t), len, true);
   return len + sizeof(uint32_t);
 }
 
+uint32_t TypeChar::GetStoredSize(const char *storage) {
+  uint32_t len = MACH_READ_UINT32(storage);
+  if (len & EXTERNAL_MASK) {
+    return sizeof(uint32_t) + sizeof(page_id_t);
+  }
+  return (len & CODED_MASK) ? sizeof(uint32_t) : sizeof(uint32_t) + len;
+}
+
 uint32_t TypeChar::GetSerializedSize(const Field &field, bool is_null) const {
   if (is_null) {
     return 0;
   }
+  if (field.IsExternal()) {
+    return sizeof(uint32_t) + sizeof(page_id_t);
+  }
+  if (field.IsCoded()) {
+    return sizeof(uint32_t);
+  }
   uint32_t len = GetLength(field);
   return len + sizeof(uint32_t);
 }
@@ -266,6 +300,10 @@ CmpBool TypeChar::CompareEquals(const Field &left, const Field &right) const {
   if (left.IsNull() || right.IsNull()) {
     return CmpBool::kNull;
   }
+  if (left.IsCoded() || right.IsCoded()) {
+    // a column keeps a value inline only if its dictionary has no code for it
+    return GetCmpBool(left.IsCoded() && right.IsCoded() && left.GetCode() == right.GetCode());
+  }
   return GetCmpBool(CompareStrings(left.GetData(), left.GetLength(), right.GetData(), right.GetLength()) == 0);
 }
 
@@ -274,6 +312,9 @@ CmpBool TypeChar::CompareNotEquals(const Field &left, const Field &right) const
   if (left.IsNull() || right.IsNull()) {
     return CmpBool::kNull;
   }
+  if (left.IsCoded() || right.IsCoded()) {
+    return GetCmpBool(!left.IsCoded() || !right.IsCoded() || left.GetCode() != right.GetCode());
+  }
   return GetCmpBool(CompareStrings(left.GetData(), left.GetLength(), right.GetData(), right.GetLength()) != 0);
 }
 
@@ -282,6 +323,7 @@ CmpBool TypeChar::CompareLessThan(const Field &left, const Field &right) const {
   if (left.IsNull() || right.IsNull()) {
     return CmpBool::kNull;
   }
+  ASSERT(!left.IsCoded() && !right.IsCoded(), "Codes only compare for equality.");
   return GetCmpBool(CompareStrings(left.GetData(), left.GetLength(), right.GetData(), right.GetLength()) < 0);
 }
 
@@ -290,6 +332,7 @@ CmpBool TypeChar::CompareLessThanEquals(const Field &left, const Field &right) c
   if (left.IsNull() || right.IsNull()) {
     return CmpBool::kNull;
   }
+  ASSERT(!left.IsCoded() && !right.IsCoded(), "Codes only compare for equality.");
   return GetCmpBool(CompareStrings(left.GetData(), left.GetLength(), right.GetData(), right.GetLength()) <= 0);
 }
 
@@ -298,6 +341,7 @@ CmpBool TypeChar::CompareGreaterThan(const Field &left, const Field &right) cons
   if (left.IsNull() || right.IsNull()) {
     return CmpBool::kNull;
   }
+  ASSERT(!left.IsCoded() && !right.IsCoded(), "Codes only compare for equality.");
   return GetCmpBool(CompareStrings(left.GetData(), left.GetLength(), right.GetData(), right.GetLength()) > 0);
 }
 
@@ -306,5 +350,6 @@ CmpBool TypeChar::CompareGreaterThanEquals(const Field &left, const Field &right
   if (left.IsNull() || right.IsNull()) {
     return CmpBool::kNull;
   }
+  ASSERT(!left.IsCoded() && !right.IsCoded(), "Codes only compare for equality.");
   return GetCmpBool(CompareStrings(left.GetData(), left.GetLength(), right.GetData(), right.GetLength()) >= 0);
 }
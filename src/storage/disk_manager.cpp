@@ -1,87 +1,365 @@
 #include "storage/disk_manager.h"
 
+#include <fcntl.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstring>
 #include <filesystem>
 #include <stdexcept>
 
+#include "common/crc32c.h"
 #include "glog/logging.h"
 #include "page/bitmap_page.h"
 
-DiskManager::DiskManager(const std::string &db_file) : file_name_(db_file) {
+static_assert(DiskManager::BITMAP_SIZE % EXTENT_RESERVATION_SIZE == 0 && EXTENT_RESERVATION_SIZE % 64 == 0,
+              "A reservation is made of whole bitmap words and never crosses an extent.");
+
+static_assert(sizeof(off_t) == 8, "Database files larger than 2 GB need 64-bit file offsets.");
+
+static uint64_t ElapsedMicros(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+DiskManager::DiskManager(const std::string &db_file, IOBackend io_backend, uint32_t page_size, bool direct_io)
+    : file_name_(db_file) {
   std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
-  db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-  // directory or file does not exist
-  if (!db_io_.is_open()) {
-    db_io_.clear();
-    // create a new file
-    std::filesystem::path p = db_file;
-    if(p.has_parent_path()) std::filesystem::create_directories(p.parent_path());
-    db_io_.open(db_file, std::ios::binary | std::ios::trunc | std::ios::out);
-    db_io_.close();
-    // reopen with original mode
-    db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-    if (!db_io_.is_open()) {
-      throw std::exception();
+  // directory does not exist
+  std::filesystem::path p = db_file;
+  if(p.has_parent_path()) std::filesystem::create_directories(p.parent_path());
+  if (direct_io) {
+    db_fd_ = open(db_file.c_str(), O_RDWR | O_CREAT | O_DIRECT, 0644);
+    if (db_fd_ < 0 && errno == EINVAL) {
+      LOG(WARNING) << "Direct I/O is not supported for " << db_file << ", falling back to buffered I/O";
+    }
+    direct_io_ = db_fd_ >= 0;
+  }
+  if (db_fd_ < 0) {
+    db_fd_ = open(db_file.c_str(), O_RDWR | O_CREAT, 0644);
+  }
+  if (db_fd_ < 0) {
+    LOG(ERROR) << "Cannot open " << db_file << ": " << strerror(errno);
+    throw std::exception();
+  }
+  file_size_ = GetFileSize();
+  // the meta page fields fit in its first PAGE_SIZE bytes, read them before the page size of the file is known
+  alignas(PAGE_SIZE) char meta_head[PAGE_SIZE];
+  ReadPhysicalPage(META_PAGE_ID, meta_head);
+  DiskFileMetaPage *meta_page = reinterpret_cast<DiskFileMetaPage *>(meta_head);
+  if (file_size_ == 0) {
+    ASSERT(IsValidPageSize(page_size), "Invalid page size.");
+    meta_page->magic_ = DiskFileMetaPage::MAGIC;
+    meta_page->page_size_ = page_size;
+  } else if (meta_page->magic_ != DiskFileMetaPage::MAGIC || !IsValidPageSize(meta_page->page_size_) ||
+             meta_page->num_extents_ > MAX_EXTENTS) {
+    LOG(ERROR) << db_file << " is not a database file of this version";
+    close(db_fd_);
+    throw std::exception();
+  }
+  page_size_ = meta_page->page_size_;
+  meta_data_ = AllocatePageBuffer();
+  memcpy(meta_data_, meta_head, PAGE_SIZE);
+  meta_page = reinterpret_cast<DiskFileMetaPage *>(meta_data_);
+  for (uint32_t i = 0; i < meta_page->num_extents_; i++) {
+    if (meta_page->extent_used_page_[i] < BITMAP_SIZE) free_extents_.insert(i);
+  }
+  if (io_backend == IOBackend::IO_URING) {
+    io_uring_ = new IOUringQueue(IO_URING_QUEUE_DEPTH);
+    if (!io_uring_->IsValid()) {
+      LOG(WARNING) << "Falling back to synchronous I/O for " << db_file;
+      delete io_uring_;
+      io_uring_ = nullptr;
     }
   }
-  ReadPhysicalPage(META_PAGE_ID, meta_data_);
 }
 
 void DiskManager::Close() {
   std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
-  WritePhysicalPage(META_PAGE_ID, meta_data_);
   if (!closed) {
-    db_io_.close();
+    Sync();
+    delete io_uring_;
+    io_uring_ = nullptr;
+    close(db_fd_);
+    for (auto bitmap : bitmaps_) {
+      free(bitmap);
+    }
+    bitmaps_.clear();
     closed = true;
   }
 }
 
-void DiskManager::ReadPage(page_id_t logical_page_id, char *page_data) {
-  ASSERT(logical_page_id >= 0, "Invalid page id.");
+void DiskManager::Sync() {
+  {
+    std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+    WriteMetaData();
+  }
+  if (fsync(db_fd_) != 0) {
+    LOG(ERROR) << "I/O error while syncing: " << strerror(errno);
+  }
+}
+
+bool DiskManager::ReadPage(page_id_t logical_page_id, char *page_data) {
+  ASSERT(logical_page_id >= 0 && logical_page_id < MAX_VALID_PAGE_ID, "Invalid page id.");
   ReadPhysicalPage(MapPageId(logical_page_id), page_data);
+  return VerifyReadPage(logical_page_id, page_data);
 }
 
 void DiskManager::WritePage(page_id_t logical_page_id, const char *page_data) {
-  ASSERT(logical_page_id >= 0, "Invalid page id.");
-  WritePhysicalPage(MapPageId(logical_page_id), page_data);
+  ASSERT(logical_page_id >= 0 && logical_page_id < MAX_VALID_PAGE_ID, "Invalid page id.");
+  // the page may be written without its latch, the checksum is computed over a copy that can not change under it
+  char *copy = AllocatePageBuffer();
+  memcpy(copy, page_data, page_size_ - PAGE_CHECKSUM_SIZE);
+  SetChecksum(copy);
+  WritePhysicalPage(MapPageId(logical_page_id), copy);
+  free(copy);
+}
+
+void DiskManager::WritePages(std::vector<std::pair<page_id_t, char *>> &pages) {
+  // logical to physical mapping is monotonic, sorting by logical id sorts by file offset
+  std::sort(pages.begin(), pages.end(),
+            [](const std::pair<page_id_t, char *> &a, const std::pair<page_id_t, char *> &b) {
+              return a.first < b.first;
+            });
+  std::vector<page_id_t> page_ids(pages.size());
+  std::vector<char *> pages_data(pages.size());
+  // checksummed copies as in WritePage, aligned so that the ring can take them under O_DIRECT
+  char *copies = static_cast<char *>(aligned_alloc(PAGE_SIZE, pages.size() * page_size_));
+  for (size_t i = 0; i < pages.size(); i++) {
+    ASSERT(pages[i].first >= 0, "Invalid page id.");
+    page_ids[i] = pages[i].first;
+    pages_data[i] = copies + i * page_size_;
+    memcpy(pages_data[i], pages[i].second, page_size_ - PAGE_CHECKSUM_SIZE);
+    SetChecksum(pages_data[i]);
+  }
+  std::vector<struct iovec> iov;
+  std::vector<IORequest> requests;
+  BuildRequests(true, page_ids, pages_data.data(), UINT64_MAX, &iov, &requests);
+  bool use_ring = UseRing();
+  if (use_ring) {
+    auto start = std::chrono::steady_clock::now();
+    if (!io_uring_->Run(requests)) LOG(WARNING) << "io_uring batch failed, writing the failed runs synchronously";
+    write_time_us_.fetch_add(ElapsedMicros(start), std::memory_order_relaxed);
+  }
+  bool abandoned = false;
+  for (auto &request : requests) {
+    abandoned |= request.result_ == -EINPROGRESS;
+    const char *const *run = pages_data.data() + (request.iov_ - iov.data());
+    if (!use_ring || request.result_ != static_cast<int64_t>(request.iov_count_) * page_size_) {
+      // synchronous backend, or a failed or short write that is simply repeated
+      WritePhysicalPages(MapPageId(page_ids[request.iov_ - iov.data()]), run, request.iov_count_);
+      continue;
+    }
+    GrowFileSize(request.offset_ + request.result_);
+    pages_written_.fetch_add(request.iov_count_, std::memory_order_relaxed);
+    write_requests_.fetch_add(1, std::memory_order_relaxed);
+  }
+  // the kernel may still read the copies of a request given up in a torn down ring, they are never freed
+  if (!abandoned) free(copies);
+}
+
+std::vector<page_id_t> DiskManager::ReadPages(std::vector<std::pair<page_id_t, char *>> &pages) {
+  std::sort(pages.begin(), pages.end(),
+            [](const std::pair<page_id_t, char *> &a, const std::pair<page_id_t, char *> &b) {
+              return a.first < b.first;
+            });
+  std::vector<page_id_t> failed;
+  if (!UseRing() || !std::all_of(pages.begin(), pages.end(), [this](const std::pair<page_id_t, char *> &page) {
+        return CanTransfer(page.second);
+      })) {
+    for (auto &page : pages) {
+      if (!ReadPage(page.first, page.second)) failed.push_back(page.first);
+    }
+    return failed;
+  }
+  std::vector<page_id_t> page_ids(pages.size());
+  std::vector<char *> pages_data(pages.size());
+  for (size_t i = 0; i < pages.size(); i++) {
+    ASSERT(pages[i].first >= 0, "Invalid page id.");
+    page_ids[i] = pages[i].first;
+    pages_data[i] = pages[i].second;
+  }
+  // pages beyond the end of the file are not requested, they read as zeros
+  uint64_t file_size = file_size_.load();
+  for (size_t i = 0; i < pages.size(); i++) {
+    if (PageOffset(MapPageId(page_ids[i])) >= file_size) memset(pages_data[i], 0, page_size_);
+  }
+  std::vector<struct iovec> iov;
+  std::vector<IORequest> requests;
+  BuildRequests(false, page_ids, pages_data.data(), file_size, &iov, &requests);
+  auto start = std::chrono::steady_clock::now();
+  if (!io_uring_->Run(requests)) LOG(WARNING) << "io_uring batch failed, reading the failed runs synchronously";
+  std::vector<bool> abandoned(pages.size(), false);
+  read_time_us_.fetch_add(ElapsedMicros(start), std::memory_order_relaxed);
+  for (auto &request : requests) {
+    size_t first = request.iov_ - iov.data();
+    if (request.result_ == -EINPROGRESS) {
+      // given up in a torn down ring, the kernel may still write the pages, which are reported as failed
+      std::fill(abandoned.begin() + first, abandoned.begin() + first + request.iov_count_, true);
+      continue;
+    }
+    if (request.result_ < 0) {
+      for (size_t i = first; i < first + request.iov_count_; i++) {
+        ReadPhysicalPage(MapPageId(page_ids[i]), pages_data[i]);
+      }
+      continue;
+    }
+    // a short read ends at the end of the file, the rest of the run reads as zeros
+    size_t read_count = request.result_;
+    for (size_t i = first; i < first + request.iov_count_; i++) {
+      size_t page_start = (i - first) * page_size_;
+      if (read_count < page_start + page_size_) {
+        size_t valid = read_count > page_start ? read_count - page_start : 0;
+        memset(pages_data[i] + valid, 0, page_size_ - valid);
+      }
+    }
+    pages_read_.fetch_add(request.iov_count_, std::memory_order_relaxed);
+  }
+  for (size_t i = 0; i < pages.size(); i++) {
+    if (abandoned[i] || !VerifyReadPage(page_ids[i], pages_data[i])) failed.push_back(page_ids[i]);
+  }
+  return failed;
+}
+
+void DiskManager::BuildRequests(bool write, const std::vector<page_id_t> &page_ids, char *const *pages_data,
+                                uint64_t skip_from_offset, std::vector<struct iovec> *iov,
+                                std::vector<IORequest> *requests) {
+  iov->resize(page_ids.size());
+  uint64_t next_offset = UINT64_MAX;  // offset right after the last request
+  for (size_t i = 0; i < page_ids.size(); i++) {
+    uint64_t offset = PageOffset(MapPageId(page_ids[i]));
+    (*iov)[i].iov_base = pages_data[i];
+    (*iov)[i].iov_len = page_size_;
+    if (offset >= skip_from_offset) continue;
+    if (offset == next_offset && requests->back().iov_count_ < IOV_MAX) {
+      requests->back().iov_count_++;
+    } else {
+      requests->push_back({write, db_fd_, &(*iov)[i], 1, offset});
+    }
+    next_offset = offset + page_size_;
+  }
 }
 
 /**
  * TODO: Student Implement
  */
-page_id_t DiskManager::AllocatePage() {
+page_id_t DiskManager::AllocatePage(ExtentReservation *reservation) {
+  std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+  if(reservation==nullptr) return AllocateUnreservedPage();
+  while(true){
+    while(reservation->next_page_id_<reservation->end_page_id_){ //hand out the next page of the run
+      page_id_t id=reservation->next_page_id_++;
+      if(AllocatePageAt(id)) return id;
+    }
+    if(reservation->end_page_id_!=INVALID_PAGE_ID){ //run used up, reserve the next one
+      reserved_.erase(reservation->end_page_id_-EXTENT_RESERVATION_SIZE);
+    }
+    page_id_t start=ReserveRun(reservation->end_page_id_);
+    if(start==INVALID_PAGE_ID){ //no whole run is free any more, fall back to single pages
+      reservation->next_page_id_=reservation->end_page_id_=INVALID_PAGE_ID;
+      return AllocateUnreservedPage();
+    }
+    reservation->next_page_id_=start;
+    reservation->end_page_id_=start+EXTENT_RESERVATION_SIZE;
+  }
+}
+
+void DiskManager::ReleaseReservation(ExtentReservation *reservation) {
+  std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+  if (reservation->end_page_id_ != INVALID_PAGE_ID) {
+    reserved_.erase(reservation->end_page_id_ - EXTENT_RESERVATION_SIZE);
+  }
+  reservation->next_page_id_ = reservation->end_page_id_ = INVALID_PAGE_ID;
+}
+
+page_id_t DiskManager::AllocateUnreservedPage() {
+  DiskFileMetaPage *meta_page = reinterpret_cast<DiskFileMetaPage *>(meta_data_);
+  for (auto it = free_extents_.begin();; ++it) {
+    if (it == free_extents_.end()) {
+      // every free page left is reserved, open a new extent
+      if (meta_page->num_extents_ == MAX_EXTENTS) {
+        LOG(ERROR) << "No free page left in " << file_name_;
+        return INVALID_PAGE_ID;
+      }
+      it = free_extents_.insert(meta_page->num_extents_++).first;
+    }
+    auto bitmap = GetBitmap(*it);
+    page_id_t extent_start = *it * BITMAP_SIZE;
+    uint32_t offset = bitmap->FindFirstFree(0);
+    // skip the runs reserved by someone
+    while (offset < BITMAP_SIZE && reserved_.count(extent_start + offset - offset % EXTENT_RESERVATION_SIZE)) {
+      offset = bitmap->FindFirstFree(offset - offset % EXTENT_RESERVATION_SIZE + EXTENT_RESERVATION_SIZE);
+    }
+    if (offset < BITMAP_SIZE) {
+      AllocatePageAt(extent_start + offset);
+      return extent_start + offset;
+    }
+  }
+}
+
+bool DiskManager::AllocatePageAt(page_id_t logical_page_id) {
   DiskFileMetaPage *meta_page = reinterpret_cast<DiskFileMetaPage *>(meta_data_);
-  meta_page->num_allocated_pages_++;  //total number of allocated pages
-  uint32_t i;
-  for(i=0; i<meta_page->num_extents_; i++){
-    if(meta_page->extent_used_page_[i]<BITMAP_SIZE) break;
+  uint32_t extent_id = logical_page_id / BITMAP_SIZE;
+  if (!GetBitmap(extent_id)->AllocatePageAt(logical_page_id % BITMAP_SIZE)) {
+    return false;
   }
-  if(i==meta_page->num_extents_){ //all existing extents are full
-    meta_page->num_extents_++;  //open a new extent
+  bitmap_dirty_[extent_id] = true;
+  meta_page->num_allocated_pages_++;
+  if (++meta_page->extent_used_page_[extent_id] == BITMAP_SIZE) {
+    free_extents_.erase(extent_id);
   }
-  meta_page->extent_used_page_[i]++;  //this extent's allocated pages
-  char page_data[PAGE_SIZE];
-  ReadPhysicalPage(i*(BITMAP_SIZE+1)+1, page_data); //read bitmap
-  BitmapPage<PAGE_SIZE> *bit_map = reinterpret_cast<BitmapPage<PAGE_SIZE> *>(page_data);
-  uint32_t bit_map_next_page;
-  bit_map->AllocatePage(bit_map_next_page); //update bitmap
-  WritePhysicalPage(i*(BITMAP_SIZE+1)+1, page_data);  //write back bitmap
-  return i*BITMAP_SIZE+bit_map_next_page; //number of data pages before this extent add page offset in this extent
+  return true;
+}
+
+page_id_t DiskManager::ReserveRun(page_id_t preferred) {
+  DiskFileMetaPage *meta_page = reinterpret_cast<DiskFileMetaPage *>(meta_data_);
+  // the run right after the previous one keeps the owner's pages in one sequence
+  if (preferred != INVALID_PAGE_ID && preferred / BITMAP_SIZE < meta_page->num_extents_ &&
+      reserved_.count(preferred) == 0) {
+    uint32_t offset = preferred % BITMAP_SIZE;
+    if (GetBitmap(preferred / BITMAP_SIZE)->FindFreeRun(offset, EXTENT_RESERVATION_SIZE) == offset) {
+      reserved_.insert(preferred);
+      return preferred;
+    }
+  }
+  for (uint32_t extent_id : free_extents_) {
+    auto bitmap = GetBitmap(extent_id);
+    page_id_t extent_start = extent_id * BITMAP_SIZE;
+    uint32_t offset = bitmap->FindFreeRun(0, EXTENT_RESERVATION_SIZE);
+    while (offset < BITMAP_SIZE && reserved_.count(extent_start + offset)) {
+      offset = bitmap->FindFreeRun(offset + EXTENT_RESERVATION_SIZE, EXTENT_RESERVATION_SIZE);
+    }
+    if (offset < BITMAP_SIZE) {
+      reserved_.insert(extent_start + offset);
+      return extent_start + offset;
+    }
+  }
+  // no free run left, open a new extent
+  if (meta_page->num_extents_ == MAX_EXTENTS) {
+    return INVALID_PAGE_ID;
+  }
+  uint32_t extent_id = meta_page->num_extents_++;
+  free_extents_.insert(extent_id);
+  reserved_.insert(extent_id * BITMAP_SIZE);
+  return extent_id * BITMAP_SIZE;
 }
 
 /**
  * TODO: Student Implement
  */
 void DiskManager::DeAllocatePage(page_id_t logical_page_id) {
+  std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
   DiskFileMetaPage *meta_page = reinterpret_cast<DiskFileMetaPage *>(meta_data_);
-  meta_page->num_allocated_pages_--;  //decrease total number of allocated pages
   uint32_t i=logical_page_id / BITMAP_SIZE; //number of extent
+  if(i>=meta_page->num_extents_ || !GetBitmap(i)->DeAllocatePage(logical_page_id % BITMAP_SIZE)) return; //not allocated
+  bitmap_dirty_[i]=true;
+  meta_page->num_allocated_pages_--;  //decrease total number of allocated pages
   meta_page->extent_used_page_[i]--;  //decrease this extent's allocated pages
-  char page_data[PAGE_SIZE];
-  ReadPhysicalPage(i*(BITMAP_SIZE+1)+1, page_data); //read bitmap
-  BitmapPage<PAGE_SIZE> *bit_map = reinterpret_cast<BitmapPage<PAGE_SIZE> *>(page_data);
-  bit_map->DeAllocatePage(logical_page_id % BITMAP_SIZE); //update bitmap
-  WritePhysicalPage(i*(BITMAP_SIZE+1)+1, page_data);  //write back
+  free_extents_.insert(i);
   //no need to delete bitmap page becuase it doesn't matter
 }
 
@@ -89,12 +367,33 @@ void DiskManager::DeAllocatePage(page_id_t logical_page_id) {
  * TODO: Student Implement
  */
 bool DiskManager::IsPageFree(page_id_t logical_page_id) {
+  std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+  DiskFileMetaPage *meta_page = reinterpret_cast<DiskFileMetaPage *>(meta_data_);
   uint32_t i=logical_page_id / BITMAP_SIZE; //number of extent
-  char page_data[PAGE_SIZE];
-  ReadPhysicalPage(i*(BITMAP_SIZE+1)+1, page_data); //read bitmap
-  BitmapPage<PAGE_SIZE> *bit_map = reinterpret_cast<BitmapPage<PAGE_SIZE> *>(page_data);
-  return bit_map->IsPageFree(logical_page_id % BITMAP_SIZE);
-  //no need to write back because there is no update
+  if(i>=meta_page->num_extents_) return true;
+  return GetBitmap(i)->IsPageFree(logical_page_id % BITMAP_SIZE);
+}
+
+BitmapPage<PAGE_SIZE> *DiskManager::GetBitmap(uint32_t extent_id) {
+  if (extent_id >= bitmaps_.size()) {
+    bitmaps_.resize(extent_id + 1, nullptr);
+    bitmap_dirty_.resize(extent_id + 1, false);
+  }
+  if (bitmaps_[extent_id] == nullptr) {
+    bitmaps_[extent_id] = AllocatePageBuffer();  // the bitmap uses the first PAGE_SIZE bytes
+    ReadPhysicalPage(extent_id * (BITMAP_SIZE + 1) + 1, bitmaps_[extent_id]);
+  }
+  return reinterpret_cast<BitmapPage<PAGE_SIZE> *>(bitmaps_[extent_id]);
+}
+
+void DiskManager::WriteMetaData() {
+  for (size_t i = 0; i < bitmaps_.size(); i++) {
+    if (bitmap_dirty_[i]) {
+      WritePhysicalPage(i * (BITMAP_SIZE + 1) + 1, bitmaps_[i]);
+      bitmap_dirty_[i] = false;
+    }
+  }
+  WritePhysicalPage(META_PAGE_ID, meta_data_);
 }
 
 /**
@@ -104,45 +403,150 @@ page_id_t DiskManager::MapPageId(page_id_t logical_page_id) {
   return logical_page_id / BITMAP_SIZE + 2 + logical_page_id; //number of bitmap: logical_page_id/BITMAP_SIZE+1, meta page: 1
 }
 
-int DiskManager::GetFileSize(const std::string &file_name) {
+DiskStats DiskManager::GetStats() const {
+  DiskStats stats;
+  stats.pages_read_ = pages_read_.load(std::memory_order_relaxed);
+  stats.pages_written_ = pages_written_.load(std::memory_order_relaxed);
+  stats.bytes_read_ = stats.pages_read_ * page_size_;
+  stats.bytes_written_ = stats.pages_written_ * page_size_;
+  stats.write_requests_ = write_requests_.load(std::memory_order_relaxed);
+  stats.read_time_us_ = read_time_us_.load(std::memory_order_relaxed);
+  stats.write_time_us_ = write_time_us_.load(std::memory_order_relaxed);
+  stats.checksum_failures_ = checksum_failures_.load(std::memory_order_relaxed);
+  stats.checksum_verify_ns_ = checksum_verify_ns_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void DiskManager::SetChecksum(char *page_data) const {
+  uint32_t checksum = Crc32c(page_data, page_size_ - PAGE_CHECKSUM_SIZE);
+  memcpy(page_data + page_size_ - PAGE_CHECKSUM_SIZE, &checksum, PAGE_CHECKSUM_SIZE);
+}
+
+bool DiskManager::VerifyChecksum(const char *page_data) const {
+  uint32_t checksum;
+  memcpy(&checksum, page_data + page_size_ - PAGE_CHECKSUM_SIZE, PAGE_CHECKSUM_SIZE);
+  if (checksum == Crc32c(page_data, page_size_ - PAGE_CHECKSUM_SIZE)) {
+    return true;
+  }
+  // a page that was allocated but never written reads as zeros
+  return checksum == 0 && page_data[0] == 0 && memcmp(page_data, page_data + 1, page_size_ - 1) == 0;
+}
+
+bool DiskManager::VerifyReadPage(page_id_t logical_page_id, const char *page_data) {
+  auto start = std::chrono::steady_clock::now();
+  bool valid = VerifyChecksum(page_data);
+  checksum_verify_ns_.fetch_add(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count(),
+      std::memory_order_relaxed);
+  if (!valid) {
+    checksum_failures_.fetch_add(1, std::memory_order_relaxed);
+    LOG(ERROR) << "Checksum mismatch on page " << logical_page_id << " of " << file_name_;
+  }
+  return valid;
+}
+
+char *DiskManager::AllocatePageBuffer() const {
+  char *buffer = static_cast<char *>(aligned_alloc(PAGE_SIZE, page_size_));
+  memset(buffer, 0, page_size_);
+  return buffer;
+}
+
+uint64_t DiskManager::GetFileSize() {
   struct stat stat_buf;
-  int rc = stat(file_name.c_str(), &stat_buf);
-  return rc == 0 ? stat_buf.st_size : -1;
+  int rc = fstat(db_fd_, &stat_buf);
+  return rc == 0 ? stat_buf.st_size : 0;
+}
+
+void DiskManager::GrowFileSize(uint64_t end_offset) {
+  uint64_t size = file_size_.load();
+  while (size < end_offset && !file_size_.compare_exchange_weak(size, end_offset)) {
+  }
 }
 
 void DiskManager::ReadPhysicalPage(page_id_t physical_page_id, char *page_data) {
-  int offset = physical_page_id * PAGE_SIZE;
-  // check if read beyond file length
-  if (offset >= GetFileSize(file_name_)) {
+  if (!CanTransfer(page_data)) {
+    char *bounce = AllocatePageBuffer();
+    ReadPhysicalPage(physical_page_id, bounce);
+    memcpy(page_data, bounce, page_size_);
+    free(bounce);
+    return;
+  }
+  auto start = std::chrono::steady_clock::now();
+  uint64_t offset = PageOffset(physical_page_id);
+  size_t read_count = 0;
+  // reading beyond the end of the file gives zeros
+  if (offset < file_size_.load()) {
+    while (read_count < page_size_) {
+      ssize_t n =
+          pread(db_fd_, page_data + read_count, page_size_ - read_count, static_cast<off_t>(offset + read_count));
+      if (n < 0 && errno == EINTR) continue;
+      if (n < 0) {
+        LOG(ERROR) << "I/O error while reading: " << strerror(errno);
+      }
+      if (n <= 0) break;
+      read_count += n;
+    }
+  }
+  if (read_count < page_size_) {
 #ifdef ENABLE_BPM_DEBUG
     LOG(INFO) << "Read less than a page" << std::endl;
 #endif
-    memset(page_data, 0, PAGE_SIZE);
-  } else {
-    // set read cursor to offset
-    db_io_.seekp(offset);
-    db_io_.read(page_data, PAGE_SIZE);
-    // if file ends before reading PAGE_SIZE
-    int read_count = db_io_.gcount();
-    if (read_count < PAGE_SIZE) {
-#ifdef ENABLE_BPM_DEBUG
-      LOG(INFO) << "Read less than a page" << std::endl;
-#endif
-      memset(page_data + read_count, 0, PAGE_SIZE - read_count);
-    }
+    memset(page_data + read_count, 0, page_size_ - read_count);
   }
+  pages_read_.fetch_add(1, std::memory_order_relaxed);
+  read_time_us_.fetch_add(ElapsedMicros(start), std::memory_order_relaxed);
 }
 
 void DiskManager::WritePhysicalPage(page_id_t physical_page_id, const char *page_data) {
-  size_t offset = static_cast<size_t>(physical_page_id) * PAGE_SIZE;
-  // set write cursor to offset
-  db_io_.seekp(offset);
-  db_io_.write(page_data, PAGE_SIZE);
-  // check for I/O error
-  if (db_io_.bad()) {
-    LOG(ERROR) << "I/O error while writing";
+  WritePhysicalPages(physical_page_id, &page_data, 1);
+}
+
+void DiskManager::WritePhysicalPages(page_id_t first_physical_page_id, const char *const *pages_data, size_t count) {
+  if (!std::all_of(pages_data, pages_data + count, [this](const char *data) { return CanTransfer(data); })) {
+    std::vector<char *> bounce(count);
+    for (size_t i = 0; i < count; i++) {
+      bounce[i] = AllocatePageBuffer();
+      memcpy(bounce[i], pages_data[i], page_size_);
+    }
+    WritePhysicalPages(first_physical_page_id, bounce.data(), count);
+    for (auto buffer : bounce) {
+      free(buffer);
+    }
     return;
   }
-  // needs to flush to keep disk file in sync
-  db_io_.flush();
-}
\ No newline at end of file
+  auto start = std::chrono::steady_clock::now();
+  uint64_t offset = PageOffset(first_physical_page_id);
+  // one positional request for the whole run, durability is left to Sync
+  std::vector<struct iovec> iov(count);
+  for (size_t i = 0; i < count; i++) {
+    iov[i].iov_base = const_cast<char *>(pages_data[i]);
+    iov[i].iov_len = page_size_;
+  }
+  size_t first = 0;
+  while (first < count) {
+    int n_iov = static_cast<int>(std::min<size_t>(count - first, IOV_MAX));
+    ssize_t n = pwritev(db_fd_, iov.data() + first, n_iov, static_cast<off_t>(offset));
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) {
+      LOG(ERROR) << "I/O error while writing: " << strerror(errno);
+      return;
+    }
+    // Under O_DIRECT the next request must start page aligned again, so a page written in part is written again.
+    if (direct_io_) {
+      n -= n % static_cast<ssize_t>(page_size_);
+    }
+    offset += n;
+    // skip what was written, a short write may end inside a page
+    while (n > 0) {
+      size_t done = std::min<size_t>(n, iov[first].iov_len);
+      iov[first].iov_base = static_cast<char *>(iov[first].iov_base) + done;
+      iov[first].iov_len -= done;
+      n -= done;
+      if (iov[first].iov_len == 0) first++;
+    }
+  }
+  GrowFileSize(offset);
+  pages_written_.fetch_add(count, std::memory_order_relaxed);
+  write_requests_.fetch_add(1, std::memory_order_relaxed);
+  write_time_us_.fetch_add(ElapsedMicros(start), std::memory_order_relaxed);
+}
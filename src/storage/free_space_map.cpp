@@ -0,0 +1,251 @@
+#include "storage/free_space_map.h"
+
+#include <algorithm>
+
+#include "glog/logging.h"
+
+FreeSpaceMap::FreeSpaceMap(BufferPoolManager *buffer_pool_manager)
+    : buffer_pool_manager_(buffer_pool_manager),
+      page_size_(buffer_pool_manager->GetPageSize()),
+      entries_per_page_(FreeSpaceMapPage::GetCapacity(page_size_)) {}
+
+bool FreeSpaceMap::Create(ExtentReservation *reservation) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  page_id_t page_id;
+  auto page = buffer_pool_manager_->NewPage(page_id, reservation);
+  if (page == nullptr) {
+    return false;
+  }
+  reinterpret_cast<FreeSpaceMapPage *>(page->GetData())->Init(page_size_);
+  buffer_pool_manager_->UnpinPage(page_id, true);
+  map_pages_.push_back(page_id);
+  return true;
+}
+
+void FreeSpaceMap::Load(page_id_t first_page_id) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  page_id_t page_id = first_page_id;
+  while (page_id != INVALID_PAGE_ID) {
+    auto page = buffer_pool_manager_->FetchPage(page_id);
+    if (page == nullptr) {
+      LOG(ERROR) << "Cannot read free space map page " << page_id;
+      break;
+    }
+    auto map_page = reinterpret_cast<FreeSpaceMapPage *>(page->GetData());
+    map_pages_.push_back(page_id);
+    for (uint32_t i = 0; i < map_page->GetCount(); i++) {
+      index_[map_page->GetPageId(i)] = heap_pages_.size();
+      heap_pages_.push_back(map_page->GetPageId(i));
+      categories_.push_back(map_page->GetCategory(i));
+    }
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    page_id = map_page->GetNextPageId();
+  }
+  block_max_.assign((categories_.size() + BLOCK_SIZE - 1) / BLOCK_SIZE, 0);
+  for (uint32_t i = 0; i < categories_.size(); i += BLOCK_SIZE) {
+    UpdateBlockMax(i);
+  }
+}
+
+void FreeSpaceMap::Destroy() {
+  std::scoped_lock<std::mutex> lock(latch_);
+  for (auto page_id : map_pages_) {
+    buffer_pool_manager_->DeletePage(page_id);
+  }
+  map_pages_.clear();
+  heap_pages_.clear();
+  categories_.clear();
+  block_max_.clear();
+  index_.clear();
+  claimed_.clear();
+  hint_ = 0;
+}
+
+page_id_t FreeSpaceMap::FindPage(uint32_t space) {
+  uint64_t required = (static_cast<uint64_t>(space) * 256 + page_size_ - 1) / page_size_;
+  if (required > 255) {
+    return INVALID_PAGE_ID;
+  }
+  std::scoped_lock<std::mutex> lock(latch_);
+  size_t i = Search(required, false);
+  return i < heap_pages_.size() ? heap_pages_[i] : INVALID_PAGE_ID;
+}
+
+page_id_t FreeSpaceMap::ClaimPage(uint32_t space) {
+  uint64_t required = (static_cast<uint64_t>(space) * 256 + page_size_ - 1) / page_size_;
+  if (required > 255) {
+    return INVALID_PAGE_ID;
+  }
+  std::scoped_lock<std::mutex> lock(latch_);
+  size_t i = Search(required, true);
+  if (i == heap_pages_.size()) {
+    return INVALID_PAGE_ID;
+  }
+  claimed_.insert(heap_pages_[i]);
+  return heap_pages_[i];
+}
+
+void FreeSpaceMap::ReleasePage(page_id_t page_id) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  claimed_.erase(page_id);
+}
+
+size_t FreeSpaceMap::Search(uint64_t required, bool skip_claimed) {
+  size_t num_blocks = block_max_.size();
+  // start at the block of the last hit, an append-only load then finds the last page right away
+  size_t first_block = hint_ / BLOCK_SIZE;
+  for (size_t n = 0; n < num_blocks; n++) {
+    size_t block = (first_block + n) % num_blocks;
+    if (block_max_[block] < required) continue;
+    size_t end = std::min<size_t>((block + 1) * BLOCK_SIZE, categories_.size());
+    for (size_t i = block * BLOCK_SIZE; i < end; i++) {
+      if (categories_[i] >= required && !(skip_claimed && claimed_.count(heap_pages_[i]) > 0)) {
+        hint_ = i;
+        return i;
+      }
+    }
+  }
+  return heap_pages_.size();
+}
+
+void FreeSpaceMap::Update(page_id_t page_id, uint32_t free_space) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  auto it = index_.find(page_id);
+  if (it == index_.end()) {
+    return;
+  }
+  uint8_t category = ToCategory(free_space, page_size_);
+  if (categories_[it->second] == category) {
+    return;
+  }
+  categories_[it->second] = category;
+  UpdateBlockMax(it->second);
+  WriteEntry(it->second);
+}
+
+bool FreeSpaceMap::AddPage(page_id_t page_id, uint32_t free_space, ExtentReservation *reservation, bool claim) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  auto index = static_cast<uint32_t>(heap_pages_.size());
+  if (index == map_pages_.size() * entries_per_page_) {
+    // the last map page is full, chain a new one
+    page_id_t new_page_id;
+    auto new_page = buffer_pool_manager_->NewPage(new_page_id, reservation);
+    if (new_page == nullptr) {
+      return false;
+    }
+    reinterpret_cast<FreeSpaceMapPage *>(new_page->GetData())->Init(page_size_);
+    buffer_pool_manager_->UnpinPage(new_page_id, true);
+    auto last_page = buffer_pool_manager_->FetchPage(map_pages_.back());
+    if (last_page == nullptr) {
+      buffer_pool_manager_->DeletePage(new_page_id);
+      return false;
+    }
+    reinterpret_cast<FreeSpaceMapPage *>(last_page->GetData())->SetNextPageId(new_page_id);
+    buffer_pool_manager_->UnpinPage(map_pages_.back(), true);
+    map_pages_.push_back(new_page_id);
+  }
+  index_[page_id] = index;
+  heap_pages_.push_back(page_id);
+  if (claim) {
+    claimed_.insert(page_id);
+  }
+  categories_.push_back(ToCategory(free_space, page_size_));
+  if (index % BLOCK_SIZE == 0) {
+    block_max_.push_back(0);
+  }
+  UpdateBlockMax(index);
+  WriteEntry(index);
+  return true;
+}
+
+void FreeSpaceMap::RemovePages(const std::vector<page_id_t> &page_ids) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  std::unordered_set<page_id_t> removed(page_ids.begin(), page_ids.end());
+  size_t first = heap_pages_.size();  // first entry that moves
+  size_t kept = 0;
+  for (size_t i = 0; i < heap_pages_.size(); i++) {
+    if (removed.count(heap_pages_[i]) > 0) {
+      index_.erase(heap_pages_[i]);
+      claimed_.erase(heap_pages_[i]);
+      first = std::min(first, i);
+      continue;
+    }
+    heap_pages_[kept] = heap_pages_[i];
+    categories_[kept] = categories_[i];
+    index_[heap_pages_[kept]] = kept;
+    kept++;
+  }
+  if (first == heap_pages_.size()) {
+    return;
+  }
+  heap_pages_.resize(kept);
+  categories_.resize(kept);
+  block_max_.assign((kept + BLOCK_SIZE - 1) / BLOCK_SIZE, 0);
+  for (uint32_t i = 0; i < kept; i += BLOCK_SIZE) {
+    UpdateBlockMax(i);
+  }
+  hint_ = 0;
+  // rewrite the map pages from the first moved entry on, the last one needed ends the chain
+  size_t needed = std::max<size_t>(1, (kept + entries_per_page_ - 1) / entries_per_page_);
+  for (size_t m = std::min(first / entries_per_page_, needed - 1); m < needed; m++) {
+    auto page = buffer_pool_manager_->FetchPage(map_pages_[m]);
+    if (page == nullptr) {
+      LOG(WARNING) << "Cannot update free space map page " << map_pages_[m];
+      continue;
+    }
+    auto map_page = reinterpret_cast<FreeSpaceMapPage *>(page->GetData());
+    size_t begin = m * entries_per_page_;
+    auto count = static_cast<uint32_t>(std::min<size_t>(entries_per_page_, kept - begin));
+    for (uint32_t i = 0; i < count; i++) {
+      map_page->SetEntry(i, heap_pages_[begin + i], categories_[begin + i]);
+    }
+    map_page->SetCount(count);
+    if (m + 1 == needed) {
+      map_page->SetNextPageId(INVALID_PAGE_ID);
+    }
+    buffer_pool_manager_->UnpinPage(map_pages_[m], true);
+  }
+  for (size_t m = needed; m < map_pages_.size(); m++) {
+    buffer_pool_manager_->DeletePage(map_pages_[m]);
+  }
+  map_pages_.resize(needed);
+}
+
+page_id_t FreeSpaceMap::GetLastPage() {
+  std::scoped_lock<std::mutex> lock(latch_);
+  return heap_pages_.empty() ? INVALID_PAGE_ID : heap_pages_.back();
+}
+
+size_t FreeSpaceMap::GetPageCount() {
+  std::scoped_lock<std::mutex> lock(latch_);
+  return heap_pages_.size();
+}
+
+std::vector<page_id_t> FreeSpaceMap::GetPages() {
+  std::scoped_lock<std::mutex> lock(latch_);
+  return heap_pages_;
+}
+
+void FreeSpaceMap::WriteEntry(uint32_t index) {
+  page_id_t map_page_id = map_pages_[index / entries_per_page_];
+  auto page = buffer_pool_manager_->FetchPage(map_page_id);
+  if (page == nullptr) {
+    // the in-memory map stays right, the map page catches up with the next change
+    LOG(WARNING) << "Cannot update free space map page " << map_page_id;
+    return;
+  }
+  auto map_page = reinterpret_cast<FreeSpaceMapPage *>(page->GetData());
+  uint32_t slot = index % entries_per_page_;
+  map_page->SetEntry(slot, heap_pages_[index], categories_[index]);
+  if (slot >= map_page->GetCount()) {
+    map_page->SetCount(slot + 1);
+  }
+  buffer_pool_manager_->UnpinPage(map_page_id, true);
+}
+
+void FreeSpaceMap::UpdateBlockMax(uint32_t index) {
+  size_t block = index / BLOCK_SIZE;
+  auto begin = categories_.begin() + block * BLOCK_SIZE;
+  auto end = categories_.begin() + std::min<size_t>((block + 1) * BLOCK_SIZE, categories_.size());
+  block_max_[block] = *std::max_element(begin, end);
+}
@@ -0,0 +1,200 @@
+#include "storage/io_uring_queue.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define MINISQL_HAVE_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "glog/logging.h"
+
+#ifdef MINISQL_HAVE_IO_URING
+
+// polls of the completion ring without progress before the requests in flight are given up, one millisecond apart
+static constexpr int IO_URING_DRAIN_RETRIES = 100;
+
+static unsigned *RingField(void *ring, uint32_t offset) {
+  return reinterpret_cast<unsigned *>(static_cast<char *>(ring) + offset);
+}
+
+IOUringQueue::IOUringQueue(unsigned entries) {
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  int fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+  if (fd < 0) {
+    LOG(WARNING) << "io_uring is not available: " << strerror(errno);
+    return;
+  }
+  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single_mmap) {
+    sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+  }
+  sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+  if (sq_ring_ == MAP_FAILED) {
+    sq_ring_ = nullptr;
+    close(fd);
+    LOG(WARNING) << "Cannot map io_uring submission ring: " << strerror(errno);
+    return;
+  }
+  if (single_mmap) {
+    cq_ring_ = sq_ring_;
+  } else {
+    cq_ring_ = mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    if (cq_ring_ == MAP_FAILED) {
+      cq_ring_ = nullptr;
+      munmap(sq_ring_, sq_ring_size_);
+      sq_ring_ = nullptr;
+      close(fd);
+      LOG(WARNING) << "Cannot map io_uring completion ring: " << strerror(errno);
+      return;
+    }
+  }
+  sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+  sqes_ = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+  if (sqes_ == MAP_FAILED) {
+    sqes_ = nullptr;
+    if (cq_ring_ != sq_ring_) munmap(cq_ring_, cq_ring_size_);
+    munmap(sq_ring_, sq_ring_size_);
+    sq_ring_ = cq_ring_ = nullptr;
+    close(fd);
+    LOG(WARNING) << "Cannot map io_uring submission entries: " << strerror(errno);
+    return;
+  }
+  sq_head_ = RingField(sq_ring_, params.sq_off.head);
+  sq_tail_ = RingField(sq_ring_, params.sq_off.tail);
+  sq_mask_ = RingField(sq_ring_, params.sq_off.ring_mask);
+  sq_array_ = RingField(sq_ring_, params.sq_off.array);
+  cq_head_ = RingField(cq_ring_, params.cq_off.head);
+  cq_tail_ = RingField(cq_ring_, params.cq_off.tail);
+  cq_mask_ = RingField(cq_ring_, params.cq_off.ring_mask);
+  cqes_ = static_cast<char *>(cq_ring_) + params.cq_off.cqes;
+  sq_entries_ = params.sq_entries;
+  ring_fd_ = fd;
+  valid_.store(true, std::memory_order_release);
+}
+
+IOUringQueue::~IOUringQueue() { TearDown(); }
+
+void IOUringQueue::TearDown() {
+  if (ring_fd_ < 0) return;
+  valid_.store(false, std::memory_order_release);
+  munmap(sqes_, sqes_size_);
+  if (cq_ring_ != sq_ring_) munmap(cq_ring_, cq_ring_size_);
+  munmap(sq_ring_, sq_ring_size_);
+  close(ring_fd_);
+  ring_fd_ = -1;
+}
+
+int IOUringQueue::Enter(unsigned to_submit, unsigned min_complete) {
+  return static_cast<int>(
+      syscall(__NR_io_uring_enter, ring_fd_, to_submit, min_complete, IORING_ENTER_GETEVENTS, nullptr, 0));
+}
+
+unsigned IOUringQueue::Reap(std::vector<IORequest> &requests) {
+  auto cqes = static_cast<struct io_uring_cqe *>(cqes_);
+  unsigned head = *cq_head_;
+  unsigned reaped = 0;
+  while (head != __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+    struct io_uring_cqe *cqe = &cqes[head & *cq_mask_];
+    requests[cqe->user_data].result_ = cqe->res;
+    head++;
+    reaped++;
+  }
+  __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+  return reaped;
+}
+
+bool IOUringQueue::Run(std::vector<IORequest> &requests) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  for (auto &request : requests) {
+    request.result_ = -EIO;
+  }
+  if (!IsValid()) return false;
+  auto sqes = static_cast<struct io_uring_sqe *>(sqes_);
+  size_t next = 0;         // first request not queued yet
+  unsigned in_flight = 0;  // taken by the kernel and not completed
+  bool failed = false;     // io_uring_enter failed, no more requests are queued
+  int drain_retries = 0;
+  while ((!failed && next < requests.size()) || in_flight > 0) {
+    // fill the submission ring with as many requests as it holds, it is empty at this point
+    size_t first = next;
+    unsigned tail = *sq_tail_;
+    while (!failed && next < requests.size() && in_flight + (next - first) < sq_entries_) {
+      IORequest &request = requests[next];
+      unsigned index = tail & *sq_mask_;
+      struct io_uring_sqe *sqe = &sqes[index];
+      memset(sqe, 0, sizeof(*sqe));
+      sqe->opcode = request.write_ ? IORING_OP_WRITEV : IORING_OP_READV;
+      sqe->fd = request.fd_;
+      sqe->addr = reinterpret_cast<uint64_t>(request.iov_);
+      sqe->len = request.iov_count_;
+      sqe->off = request.offset_;
+      sqe->user_data = next;
+      sq_array_[index] = index;
+      tail++;
+      next++;
+    }
+    __atomic_store_n(sq_tail_, tail, __ATOMIC_RELEASE);
+    // submit the queued requests and wait for at least one completion
+    auto queued = static_cast<unsigned>(next - first);
+    int ret = Enter(queued, 1);
+    int error = ret < 0 ? errno : 0;
+    // the kernel takes entries in order and may have taken some even if the call failed, its head tells how many
+    unsigned taken = queued - (tail - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE));
+    for (size_t i = first; i < first + taken; i++) {
+      requests[i].result_ = -EINPROGRESS;
+    }
+    in_flight += taken;
+    if (taken < queued) {
+      // take the rest back, they are queued again or, after a failure, left with -EIO
+      __atomic_store_n(sq_tail_, tail - (queued - taken), __ATOMIC_RELEASE);
+      next = first + taken;
+    }
+    unsigned reaped = Reap(requests);
+    in_flight -= reaped;
+    if (ret >= 0 || error == EINTR) continue;
+    if (!failed) {
+      LOG(ERROR) << "io_uring_enter failed: " << strerror(error);
+      failed = true;
+    } else if (reaped == 0) {
+      // completions are posted to the ring without the call, keep polling it for a while
+      if (++drain_retries > IO_URING_DRAIN_RETRIES) break;
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+  if (in_flight > 0) {
+    LOG(ERROR) << "Cannot reap " << in_flight << " io_uring requests, tearing the ring down";
+    TearDown();
+  }
+  return !failed;
+}
+
+#else
+
+IOUringQueue::IOUringQueue(unsigned) { LOG(WARNING) << "io_uring is not supported by this build"; }
+
+IOUringQueue::~IOUringQueue() = default;
+
+int IOUringQueue::Enter(unsigned, unsigned) {
+  errno = ENOSYS;
+  return -1;
+}
+
+bool IOUringQueue::Run(std::vector<IORequest> &requests) {
+  for (auto &request : requests) {
+    request.result_ = -EIO;
+  }
+  return false;
+}
+
+#endif
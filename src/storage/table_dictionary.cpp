@@ -0,0 +1,135 @@
+#include "storage/table_dictionary.h"
+
+#include "glog/logging.h"
+
+bool TableDictionary::Create(ExtentReservation *reservation) {
+  latch_.WLock();
+  page_id_t page_id;
+  auto page = buffer_pool_manager_->NewPage(page_id, reservation);
+  if (page != nullptr) {
+    reinterpret_cast<DictionaryPage *>(page->GetData())->Init();
+    buffer_pool_manager_->UnpinPage(page_id, true);
+    pages_.push_back(page_id);
+  }
+  latch_.WUnlock();
+  return page != nullptr;
+}
+
+void TableDictionary::Load(page_id_t first_page_id) {
+  latch_.WLock();
+  page_id_t page_id = first_page_id;
+  while (page_id != INVALID_PAGE_ID) {
+    auto page = buffer_pool_manager_->FetchPage(page_id);
+    if (page == nullptr) {
+      LOG(ERROR) << "Cannot read dictionary page " << page_id;
+      break;
+    }
+    auto dictionary_page = reinterpret_cast<DictionaryPage *>(page->GetData());
+    pages_.push_back(page_id);
+    uint32_t offset = 0;
+    while (offset < dictionary_page->GetSize()) {
+      uint32_t column, len;
+      const char *data;
+      offset = dictionary_page->ReadEntry(offset, &column, &data, &len);
+      auto &dictionary = columns_[column];
+      dictionary.codes_.emplace(std::string(data, len), dictionary.values_.size());
+      dictionary.values_.emplace_back(data, len);
+    }
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    page_id = dictionary_page->GetNextPageId();
+  }
+  latch_.WUnlock();
+}
+
+void TableDictionary::Destroy() {
+  latch_.WLock();
+  for (auto page_id : pages_) {
+    buffer_pool_manager_->DeletePage(page_id);
+  }
+  pages_.clear();
+  columns_.clear();
+  latch_.WUnlock();
+}
+
+bool TableDictionary::Encode(uint32_t column, const char *data, uint32_t len, uint32_t *code,
+                             ExtentReservation *reservation) {
+  *code = NO_CODE;
+  if (len > static_cast<uint32_t>(DICTIONARY_MAX_VALUE_LEN) || Find(column, data, len, code)) {
+    return true;
+  }
+  latch_.WLock();
+  std::string value(data, len);
+  auto &dictionary = columns_[column];
+  auto it = dictionary.codes_.find(value);  // another inserter may have added it meanwhile
+  bool written = true;
+  if (it != dictionary.codes_.end()) {
+    *code = it->second;
+  } else if (dictionary.values_.size() < static_cast<size_t>(DICTIONARY_MAX_CODES)) {
+    written = !pages_.empty() && AppendEntry(column, value, reservation);
+    if (written) {
+      *code = dictionary.values_.size();
+      dictionary.codes_.emplace(value, *code);
+      dictionary.values_.push_back(std::move(value));
+    }
+  }
+  latch_.WUnlock();
+  return written;
+}
+
+bool TableDictionary::Find(uint32_t column, const char *data, uint32_t len, uint32_t *code) {
+  latch_.RLock();
+  bool found = false;
+  auto dictionary = columns_.find(column);
+  if (dictionary != columns_.end()) {
+    auto it = dictionary->second.codes_.find(std::string(data, len));
+    if (it != dictionary->second.codes_.end()) {
+      *code = it->second;
+      found = true;
+    }
+  }
+  latch_.RUnlock();
+  return found;
+}
+
+char *TableDictionary::Decode(uint32_t column, uint32_t code, uint32_t *len) {
+  latch_.RLock();
+  char *data = nullptr;
+  auto dictionary = columns_.find(column);
+  if (dictionary != columns_.end() && code < dictionary->second.values_.size()) {
+    auto &value = dictionary->second.values_[code];
+    *len = value.size();
+    data = new char[value.size()];
+    memcpy(data, value.data(), value.size());
+  }
+  latch_.RUnlock();
+  return data;
+}
+
+bool TableDictionary::AppendEntry(uint32_t column, const std::string &value, ExtentReservation *reservation) {
+  uint32_t page_size = buffer_pool_manager_->GetPageSize();
+  page_id_t last_id = pages_.back();
+  auto page = buffer_pool_manager_->FetchPage(last_id);
+  if (page == nullptr) {
+    return false;
+  }
+  auto last = reinterpret_cast<DictionaryPage *>(page->GetData());
+  if (last->GetSize() + DictionaryPage::GetEntrySize(value.size()) <= DictionaryPage::GetCapacity(page_size)) {
+    last->AppendEntry(column, value.data(), value.size());
+    buffer_pool_manager_->UnpinPage(last_id, true);
+    return true;
+  }
+  page_id_t page_id;
+  auto new_page = buffer_pool_manager_->NewPage(page_id, reservation);
+  if (new_page == nullptr) {
+    buffer_pool_manager_->UnpinPage(last_id, false);
+    return false;
+  }
+  auto dictionary_page = reinterpret_cast<DictionaryPage *>(new_page->GetData());
+  dictionary_page->Init();
+  dictionary_page->AppendEntry(column, value.data(), value.size());
+  buffer_pool_manager_->UnpinPage(page_id, true);
+  last->SetNextPageId(page_id);
+  buffer_pool_manager_->UnpinPage(last_id, true);
+  pages_.push_back(page_id);
+  return true;
+}
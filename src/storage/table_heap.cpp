@@ -1,40 +1,190 @@
 #include "storage/table_heap.h"
 
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
 /**
  * TODO: Student Implement
  */
 bool TableHeap::InsertTuple(Row &row, Transaction *txn) {
-  if(row.GetSerializedSize(schema_) > PAGE_SIZE-32) return false; //can't be stored
-  page_id_t id=first_page_id_;
-  auto p=reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(id));
-
-  p->WLatch();  //write latch
-  while(!p->InsertTuple(row, schema_, txn, lock_manager_, log_manager_)){ //can't be stored in this page
-    id=p->GetNextPageId();  //get next page's id
-    if(id!=INVALID_PAGE_ID){ //next_page exists
-      p->WUnlatch();  //write unlatch
-      buffer_pool_manager_->UnpinPage(p->GetPageId(), p->IsDirty());  //unpin it, because FetchPage() pinned it
-      p=reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(id));
-    }
-    else{ //no page can store it, thus we should open a new page
-      auto p2=reinterpret_cast<TablePage *>(buffer_pool_manager_->NewPage(id));
-      if(p2==nullptr){  //no enough space in bufferpool
-        p->WUnlatch();
-        buffer_pool_manager_->UnpinPage(p->GetPageId(), p->IsDirty());
-        return false;
+  if(!NeedsToast(row) && !NeedsEncoding(row)) return InsertStored(row, txn);
+  Row stored(row);  //the caller keeps the inline values
+  if(!EncodeRow(stored)) return false;
+  if(NeedsToast(stored) && !ToastRow(stored)) return false;  //codes may already make the row small enough
+  bool inserted=InsertStored(stored, txn);
+  if(inserted) row.SetRowId(stored.GetRowId());
+  else FreeOverflow(stored);
+  return inserted;
+}
+
+bool TableHeap::InsertStored(Row &row, Transaction *txn) {
+  uint32_t space=GetSpaceNeeded(row);
+  if(space > max_space_) return false; //can't be stored
+  while(true){
+    page_id_t id=GetInsertPage(space);  //this thread's page, concurrent inserters fill other pages
+    if(id==INVALID_PAGE_ID){
+      Row *rows=&row;
+      return InsertIntoNewPage(&rows, 1, txn)==1;
+    }
+    auto p=reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(id));
+    if(p==nullptr) return false;
+    p->WLatch();  //write latch
+    bool inserted=WithPage(p, [&](auto *page){
+      return page->InsertTuple(row, schema_, txn, lock_manager_, log_manager_);
+    });
+    if(inserted){
+      Row *rows=&row;
+      zone_map_.Include(id, &rows, 1);  //under the page latch, so a vacuum of the page can not miss the row
+    }
+    uint32_t free_space=GetFreeSpace(p);
+    p->WUnlatch();
+    buffer_pool_manager_->UnpinPage(id, inserted);
+    free_space_map_.Update(id, free_space);  //a failed insert corrects the map, so the page is not picked again
+    if(inserted) return true;
+    ReleaseInsertPage(id);  //no room for this row, move on to another page
+  }
+}
+
+bool TableHeap::InsertTuples(std::vector<Row> &rows, std::vector<RowId> &rids, Transaction *txn) {
+  std::vector<Row> toasted;  //copies of the rows with codes and long chars moved out of line
+  toasted.reserve(rows.size());
+  std::vector<Row *> batch;
+  batch.reserve(rows.size());
+  bool fits=true;
+  for(auto &row: rows){
+    Row *stored=&row;
+    if(NeedsToast(row) || NeedsEncoding(row)){
+      toasted.emplace_back(row);
+      stored=&toasted.back();
+      if(!EncodeRow(*stored) || (NeedsToast(*stored) && !ToastRow(*stored))){
+        toasted.pop_back();
+        fits=false;
+        break;
       }
-      p2->WLatch();
-      p2->Init(id, p->GetPageId(), log_manager_, txn);
-      p2->SetNextPageId(INVALID_PAGE_ID);
-      p->SetNextPageId(id);
-      p->WUnlatch();
-      buffer_pool_manager_->UnpinPage(p->GetPageId(), p->IsDirty());
-      p=p2;
     }
+    //check every row first, so an oversized row fails the batch before anything is inserted
+    if(GetSpaceNeeded(*stored) > max_space_){
+      fits=false;
+      break;
+    }
+    batch.push_back(stored);
+  }
+  if(!fits){
+    for(auto &row: toasted) FreeOverflow(row);
+    return false;
+  }
+  rids.reserve(rids.size()+rows.size());
+  size_t next=0;
+  bool inserted=true;
+  while(next<batch.size()){
+    page_id_t id=GetInsertPage(GetSpaceNeeded(*batch[next]));
+    if(id==INVALID_PAGE_ID){
+      size_t count=InsertIntoNewPage(&batch[next], batch.size()-next, txn);
+      if(count==0){
+        inserted=false;
+        break;
+      }
+      for(size_t i=next; i<next+count; i++) rids.push_back(batch[i]->GetRowId());
+      next+=count;
+      continue;
+    }
+    auto p=reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(id));
+    if(p==nullptr){
+      inserted=false;
+      break;
+    }
+    size_t first=next;
+    p->WLatch();  //one latch and pin for every row that fits in this page
+    WithPage(p, [&](auto *page){
+      while(next<batch.size() && page->InsertTuple(*batch[next], schema_, txn, lock_manager_, log_manager_)){
+        rids.push_back(batch[next]->GetRowId());
+        next++;
+      }
+    });
+    zone_map_.Include(id, &batch[first], next-first);
+    uint32_t free_space=GetFreeSpace(p);
+    p->WUnlatch();
+    buffer_pool_manager_->UnpinPage(id, next>first);
+    free_space_map_.Update(id, free_space);
+    if(next<batch.size()) ReleaseInsertPage(id);  //the page is full for the next row
   }
+  for(size_t i=0; i<batch.size(); i++){
+    if(i<next) rows[i].SetRowId(batch[i]->GetRowId());
+    else if(batch[i]!=&rows[i]) FreeOverflow(*batch[i]);  //overflow pages of rows that were not inserted
+  }
+  return inserted;
+}
+
+size_t TableHeap::InsertIntoNewPage(Row **rows, size_t count, Transaction *txn) {
+  std::scoped_lock<std::mutex> lock(extend_latch_);
+  page_id_t last_id=free_space_map_.GetLastPage();
+  auto last=reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(last_id));
+  if(last==nullptr) return 0;
+  page_id_t id;
+  auto p=reinterpret_cast<TablePage *>(buffer_pool_manager_->NewPage(id, &reservation_));
+  if(p==nullptr){  //no enough space in bufferpool
+    buffer_pool_manager_->UnpinPage(last_id, false);
+    return 0;
+  }
+  p->WLatch();
+  InitPage(p, id, last_id, txn);
+  size_t inserted=0;
+  WithPage(p, [&](auto *page){
+    while(inserted<count && page->InsertTuple(*rows[inserted], schema_, txn, lock_manager_, log_manager_)) inserted++;
+  });
+  ASSERT(inserted>0, "A row that passed the size check must fit in an empty page.");
+  zone_map_.AddPage(id, &reservation_);  //before scans can reach the page, turns the map off if it is full
+  zone_map_.Include(id, rows, inserted);
+  last->WLatch();
+  last->SetNextPageId(id);  //link the new page at the end of the chain
+  last->WUnlatch();
+  buffer_pool_manager_->UnpinPage(last_id, true);
+  bool has_room=inserted==count;  //a page that is not full yet becomes the page of this thread
+  free_space_map_.AddPage(id, GetFreeSpace(p), &reservation_, has_room);
   p->WUnlatch();
-  buffer_pool_manager_->UnpinPage(p->GetPageId(), true);  //set is_dirty to true
-  return true;
+  buffer_pool_manager_->UnpinPage(id, true);
+  if(has_room){
+    std::scoped_lock<std::mutex> insert_lock(insert_pages_latch_);
+    insert_pages_[std::this_thread::get_id()]=id;
+  }
+  return inserted;
+}
+
+page_id_t TableHeap::GetInsertPage(uint32_t space) {
+  auto thread_id=std::this_thread::get_id();
+  {
+    std::scoped_lock<std::mutex> lock(insert_pages_latch_);
+    auto it=insert_pages_.find(thread_id);
+    if(it!=insert_pages_.end()) return it->second;
+  }
+  page_id_t id=free_space_map_.ClaimPage(space);  //skips the pages of other threads
+  if(id!=INVALID_PAGE_ID){
+    std::scoped_lock<std::mutex> lock(insert_pages_latch_);
+    insert_pages_[thread_id]=id;
+  }
+  return id;
+}
+
+void TableHeap::ReleaseInsertPage() {
+  page_id_t page_id;
+  {
+    std::scoped_lock<std::mutex> lock(insert_pages_latch_);
+    auto it=insert_pages_.find(std::this_thread::get_id());
+    if(it==insert_pages_.end()) return;
+    page_id=it->second;
+    insert_pages_.erase(it);
+  }
+  free_space_map_.ReleasePage(page_id);
+}
+
+void TableHeap::ReleaseInsertPage(page_id_t page_id) {
+  {
+    std::scoped_lock<std::mutex> lock(insert_pages_latch_);
+    auto it=insert_pages_.find(std::this_thread::get_id());
+    if(it!=insert_pages_.end() && it->second==page_id) insert_pages_.erase(it);
+  }
+  free_space_map_.ReleasePage(page_id);
 }
 
 bool TableHeap::MarkDelete(const RowId &rid, Transaction *txn) {
@@ -46,9 +196,10 @@ bool TableHeap::MarkDelete(const RowId &rid, Transaction *txn) {
   }
   // Otherwise, mark the tuple as deleted.
   page->WLatch();
-  page->MarkDelete(rid, txn, lock_manager_, log_manager_);
+  bool marked=WithPage(page, [&](auto *p){ return p->MarkDelete(rid, txn, lock_manager_, log_manager_); });
   page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
+  buffer_pool_manager_->UnpinPage(page->GetTablePageId(), marked);
+  if(marked) dead_tuples_++;  //space the next vacuum gets back
   return true;
 }
 
@@ -56,33 +207,54 @@ bool TableHeap::MarkDelete(const RowId &rid, Transaction *txn) {
  * TODO: Student Implement
  */
 bool TableHeap::UpdateTuple(const Row &row, const RowId &rid, Transaction *txn) {
+  const Row *target=&row;
+  Row toasted;
+  if(NeedsToast(row) || NeedsEncoding(row)){  //long chars of the new row go to new overflow pages
+    toasted=row;
+    if(!EncodeRow(toasted) || (NeedsToast(toasted) && !ToastRow(toasted))) return false;
+    target=&toasted;
+  }
   // Find the page which contains the tuple.
   auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
   // If the page could not be found, then abort the transaction.
-  if(page==nullptr) return false;
+  if(page==nullptr){
+    FreeOverflow(toasted);
+    return false;
+  }
   Row old_row=Row(rid);
+  Row released=Row(rid);  //the old tuple, its overflow pages are freed once it is replaced
   page->WLatch();
-  int type=page->UpdateTuple(row, &old_row, schema_, txn, lock_manager_, log_manager_);
+  int type=WithPage(page, [&](auto *p){
+    if(has_char_columns_) p->ReadTuple(&released, schema_);
+    return p->UpdateTuple(*target, &old_row, schema_, txn, lock_manager_, log_manager_);
+  });
   switch(type){
     case 0: //success
+      if(zone_map_.IsEnabled()){
+        Row *rows=const_cast<Row *>(target);
+        zone_map_.Include(rid.GetPageId(), &rows, 1);
+      }
+      free_space_map_.Update(rid.GetPageId(), GetFreeSpace(page));
       page->WUnlatch();
       buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
+      FreeOverflow(released);
       return true;
     case 1: //slot number is invalid
-      page->WUnlatch();
-      buffer_pool_manager_->UnpinPage(page->GetTablePageId(), false);
-      return false;
     case 2: //tuple is deleted
       page->WUnlatch();
       buffer_pool_manager_->UnpinPage(page->GetTablePageId(), false);
+      FreeOverflow(toasted);
       return false;
-    case 3: //not enough space
-      page->ApplyDelete(rid, txn, log_manager_);
+    default: //not enough space
+      WithPage(page, [&](auto *p){ p->ApplyDelete(rid, txn, log_manager_); });
+      free_space_map_.Update(rid.GetPageId(), GetFreeSpace(page));
       page->WUnlatch();
       buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
-      Row new_row=Row(row); //create another non-const row
-      if(InsertTuple(new_row, txn)) return true;
-      else return false;
+      FreeOverflow(released);
+      Row new_row=Row(*target); //create another non-const row
+      if(InsertStored(new_row, txn)) return true;
+      FreeOverflow(new_row);
+      return false;
   }
 }
 
@@ -92,22 +264,97 @@ bool TableHeap::UpdateTuple(const Row &row, const RowId &rid, Transaction *txn)
 void TableHeap::ApplyDelete(const RowId &rid, Transaction *txn) {
   // Step1: Find the page which contains the tuple.
   auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
+  if(page==nullptr){  //corrupted or no free frame, the tuple stays marked deleted and vacuum removes it later
+    LOG(ERROR) << "Cannot read page " << rid.GetPageId() << " to delete a tuple";
+    return;
+  }
   // Step2: Delete the tuple from the page.
+  Row released(rid);
   page->WLatch();
-  page->ApplyDelete(rid, txn, log_manager_);
+  WithPage(page, [&](auto *p){
+    if(has_char_columns_) p->ReadTuple(&released, schema_);  //the overflow pages of the tuple are freed with it
+    p->ApplyDelete(rid, txn, log_manager_);
+  });
+  free_space_map_.Update(rid.GetPageId(), GetFreeSpace(page));  //the space of the tuple is free again
   page->WUnlatch();
   buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
+  FreeOverflow(released);
 }
 
 void TableHeap::RollbackDelete(const RowId &rid, Transaction *txn) {
   // Find the page which contains the tuple.
   auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
-  assert(page != nullptr);
+  if(page==nullptr){
+    LOG(ERROR) << "Cannot read page " << rid.GetPageId() << " to roll back a delete";
+    return;
+  }
   // Rollback to delete.
   page->WLatch();
-  page->RollbackDelete(rid, txn, log_manager_);
+  WithPage(page, [&](auto *p){ p->RollbackDelete(rid, txn, log_manager_); });
   page->WUnlatch();
   buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
+  if(dead_tuples_>0) dead_tuples_--;
+}
+
+uint32_t TableHeap::Vacuum(uint32_t *freed_pages) {
+  std::scoped_lock<std::mutex> lock(extend_latch_);  //no page is appended while the chain changes
+  dead_tuples_=0;
+  uint32_t removed=0;
+  std::vector<page_id_t> freed;
+  page_id_t prev_id=INVALID_PAGE_ID;  //last page that stays in the chain
+  page_id_t page_id=first_page_id_;
+  page_id_t unreadable_id=INVALID_PAGE_ID;
+  while(page_id!=INVALID_PAGE_ID){
+    auto page=reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+    if(page==nullptr){  //the pages freed so far are still dropped from the maps
+      unreadable_id=page_id;
+      break;
+    }
+    uint32_t removed_tuples;
+    std::vector<Row> released;
+    page->WLatch();
+    bool dirty=WithPage(page, [&](auto *p){
+      return p->Vacuum(schema_, &removed_tuples, has_char_columns_ ? &released : nullptr);
+    });
+    if(removed_tuples>0 && zone_map_.IsEnabled()) ResetZoneMap(page);  //drop the values of the removed tuples
+    if(page->GetPrevPageId()!=prev_id){  //the page before it was freed
+      page->SetPrevPageId(prev_id);
+      dirty=true;
+    }
+    bool empty=WithPage(page, [](auto *p){ return p->IsEmpty(); }) && page_id!=first_page_id_;
+    page_id_t next_id=page->GetNextPageId();
+    uint32_t free_space=GetFreeSpace(page);
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, dirty);
+    removed+=removed_tuples;
+    for(auto &row: released) FreeOverflow(row);
+    auto prev=empty ? reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(prev_id)) : nullptr;
+    if(prev!=nullptr && buffer_pool_manager_->DeletePage(page_id)){  //a page still pinned by someone stays
+      prev->WLatch();
+      prev->SetNextPageId(next_id);  //unlink the freed page
+      prev->WUnlatch();
+      buffer_pool_manager_->UnpinPage(prev_id, true);
+      freed.push_back(page_id);
+    }
+    else{
+      if(prev!=nullptr) buffer_pool_manager_->UnpinPage(prev_id, false);
+      free_space_map_.Update(page_id, free_space);
+      prev_id=page_id;
+    }
+    page_id=next_id;
+  }
+  free_space_map_.RemovePages(freed);
+  zone_map_.RemovePages(freed);
+  {
+    std::scoped_lock<std::mutex> insert_lock(insert_pages_latch_);  //threads inserting into a freed page pick another
+    for(auto it=insert_pages_.begin(); it!=insert_pages_.end();){
+      if(std::find(freed.begin(), freed.end(), it->second)!=freed.end()) it=insert_pages_.erase(it);
+      else ++it;
+    }
+  }
+  if(freed_pages!=nullptr) *freed_pages=freed.size();
+  if(unreadable_id!=INVALID_PAGE_ID) ThrowUnreadable(unreadable_id);
+  return removed;
 }
 
 /**
@@ -115,19 +362,257 @@ void TableHeap::RollbackDelete(const RowId &rid, Transaction *txn) {
  */
 bool TableHeap::GetTuple(Row *row, Transaction *txn) {
   auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(row->GetRowId().GetPageId()));
-  bool ret=page->GetTuple(row, schema_, txn, lock_manager_);
+  if(page==nullptr) return false;  //corrupted or no free frame
+  bool ret=WithPage(page, [&](auto *p){ return p->GetTuple(row, schema_, txn, lock_manager_); });
   buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
   return ret;
 }
 
+void TableHeap::ResetZoneMap(TablePage *page) {
+  std::vector<Row> live;
+  RowId rid, next_rid;
+  WithPage(page, [&](auto *p){
+    for(bool found=p->GetFirstTupleRid(&rid); found; rid=next_rid){
+      live.emplace_back(rid);
+      p->GetTuple(&live.back(), schema_, nullptr, lock_manager_);
+      found=p->GetNextTupleRid(rid, &next_rid);
+    }
+  });
+  std::vector<Row *> rows;
+  rows.reserve(live.size());
+  for(auto &row: live) rows.push_back(&row);
+  zone_map_.Reset(page->GetTablePageId(), rows.data(), rows.size());
+}
+
+void TableHeap::RebuildZoneMap() {
+  for(page_id_t page_id=first_page_id_; page_id!=INVALID_PAGE_ID;){
+    auto page=reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+    if(page==nullptr){
+      LOG(ERROR) << "Cannot read page " << page_id << " to rebuild the zone map";
+      zone_map_.TurnOff();
+      return;
+    }
+    zone_map_.AddPage(page_id, &reservation_);
+    page->RLatch();
+    ResetZoneMap(page);
+    page_id_t next_id=page->GetNextPageId();
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    page_id=next_id;
+  }
+}
+
+page_id_t TableHeap::SkipPages(page_id_t page_id, const PageFilter &page_filter) {
+  while(page_id!=INVALID_PAGE_ID && !page_filter(page_id)){
+    page_id_t next_id;
+    if(!zone_map_.GetNextPage(page_id, &next_id)){  //not in the map, so it may match
+      return page_id;
+    }
+    page_id=next_id;
+  }
+  return page_id;
+}
+
+void TableHeap::ThrowUnreadable(page_id_t page_id) {
+  throw std::runtime_error("Cannot read page "+std::to_string(page_id)+" of the table");
+}
+
+bool TableHeap::LoadExternalFields(Row &row, const std::vector<bool> *columns) {
+  if(!LoadOverflowFields(row, columns)) return false;
+  if(!has_dictionary_columns_) return true;
+  for(size_t i=0; i<row.GetFieldCount(); i++){
+    Field *field=row.GetField(i);
+    if(!field->IsCoded() || (columns!=nullptr && !(*columns)[i])) continue;
+    uint32_t len;
+    char *data=dictionary_.Decode(i, field->GetCode(), &len);
+    if(data==nullptr) return false;
+    field->LoadCoded(data, len);
+  }
+  return true;
+}
+
+bool TableHeap::FindCode(uint32_t column, const Field &field, uint32_t *code) {
+  if(!schema_->GetColumn(column)->IsDictionaryEncoded() || field.IsNull() || field.IsCoded()) return false;
+  return dictionary_.Find(column, field.GetData(), field.GetLength(), code);
+}
+
+bool TableHeap::LoadOverflowFields(Row &row, const std::vector<bool> *columns) {
+  for(size_t i=0; i<row.GetFieldCount(); i++){
+    Field *field=row.GetField(i);
+    if(!field->IsExternal() || (columns!=nullptr && !(*columns)[i])) continue;
+    char *data=new char[field->GetLength()];
+    if(!ReadOverflow(field->GetExternalPageId(), field->GetLength(), data)){
+      delete[] data;
+      return false;
+    }
+    field->LoadExternal(data);
+  }
+  return true;
+}
+
+bool TableHeap::NeedsToast(const Row &row) {
+  if(!has_char_columns_) return false;
+  for(size_t i=0; i<row.GetFieldCount(); i++){
+    if(row.GetField(i)->IsExternal()) return true;  //rows never share overflow pages, a reference is written anew
+  }
+  return row.GetSerializedSize(schema_) > buffer_pool_manager_->GetPageSize()/TOAST_TUPLE_FRACTION;
+}
+
+bool TableHeap::NeedsEncoding(const Row &row) {
+  if(!has_dictionary_columns_) return false;
+  for(size_t i=0; i<row.GetFieldCount(); i++){
+    Field *field=row.GetField(i);
+    if(!schema_->GetColumn(i)->IsDictionaryEncoded() || field->IsNull() || field->IsCoded()) continue;
+    if(field->GetLength()<=static_cast<uint32_t>(DICTIONARY_MAX_VALUE_LEN)) return true;  //longer ones stay inline
+  }
+  return false;
+}
+
+bool TableHeap::EncodeRow(Row &row) {
+  if(!has_dictionary_columns_) return true;
+  if(!LoadOverflowFields(row, nullptr)) return false;  //a short value read from another row may be out of line
+  auto &fields=row.GetFields();
+  for(size_t i=0; i<fields.size(); i++){
+    Field *field=fields[i];
+    if(!schema_->GetColumn(i)->IsDictionaryEncoded() || field->IsNull() || field->IsCoded()) continue;
+    uint32_t code;
+    if(!dictionary_.Encode(i, field->GetData(), field->GetLength(), &code, &overflow_reservation_)) return false;
+    if(code==TableDictionary::NO_CODE) continue;  //stays inline
+    delete fields[i];
+    fields[i]=new Field(kTypeChar, DictionaryCode{code});
+  }
+  return true;
+}
+
+bool TableHeap::ToastRow(Row &row) {
+  if(!LoadOverflowFields(row, nullptr)) return false;
+  auto &fields=row.GetFields();
+  uint32_t threshold=buffer_pool_manager_->GetPageSize()/TOAST_TUPLE_FRACTION;
+  while(row.GetSerializedSize(schema_) > threshold){
+    size_t longest=fields.size();  //longest inline char, moving it out of line shrinks the row the most
+    for(size_t i=0; i<fields.size(); i++){
+      Field *field=fields[i];
+      if(field->GetTypeId()!=kTypeChar || field->IsNull() || field->IsExternal()) continue;
+      if(field->GetLength()<=sizeof(page_id_t)) continue;  //no smaller as a reference
+      if(longest==fields.size() || field->GetLength()>fields[longest]->GetLength()) longest=i;
+    }
+    if(longest==fields.size()) break;  //nothing left to move
+    uint32_t len=fields[longest]->GetLength();
+    page_id_t first_page_id=WriteOverflow(fields[longest]->GetData(), len);
+    if(first_page_id==INVALID_PAGE_ID){
+      FreeOverflow(row);
+      return false;
+    }
+    delete fields[longest];
+    fields[longest]=new Field(kTypeChar, first_page_id, len);
+  }
+  return true;
+}
+
+page_id_t TableHeap::WriteOverflow(const char *data, uint32_t len) {
+  uint32_t capacity=OverflowPage::GetCapacity(buffer_pool_manager_->GetPageSize());
+  page_id_t first_page_id=INVALID_PAGE_ID;
+  page_id_t prev_id=INVALID_PAGE_ID;
+  OverflowPage *prev=nullptr;
+  uint32_t offset=0;
+  while(offset<len){
+    page_id_t id;
+    auto page=buffer_pool_manager_->NewPage(id, &overflow_reservation_);
+    if(page==nullptr){  //no enough space in bufferpool, give back the part already written
+      if(prev!=nullptr) buffer_pool_manager_->UnpinPage(prev_id, true);
+      FreeOverflowChain(first_page_id);
+      return INVALID_PAGE_ID;
+    }
+    auto overflow=reinterpret_cast<OverflowPage *>(page->GetData());
+    overflow->Init();
+    uint32_t size=std::min(capacity, len-offset);
+    overflow->SetData(data+offset, size);
+    offset+=size;
+    if(prev==nullptr) first_page_id=id;
+    else{
+      prev->SetNextPageId(id);
+      buffer_pool_manager_->UnpinPage(prev_id, true);
+    }
+    prev=overflow;
+    prev_id=id;
+  }
+  if(prev!=nullptr) buffer_pool_manager_->UnpinPage(prev_id, true);
+  return first_page_id;
+}
+
+bool TableHeap::ReadOverflow(page_id_t page_id, uint32_t len, char *buf) {
+  uint32_t offset=0;
+  while(page_id!=INVALID_PAGE_ID){
+    auto page=buffer_pool_manager_->FetchPage(page_id);
+    if(page==nullptr) return false;
+    auto overflow=reinterpret_cast<OverflowPage *>(page->GetData());
+    uint32_t size=overflow->GetSize();
+    if(offset+size>len){  //the chain does not match the length in the tuple
+      buffer_pool_manager_->UnpinPage(page_id, false);
+      return false;
+    }
+    memcpy(buf+offset, overflow->GetData(), size);
+    offset+=size;
+    page_id_t next_page_id=overflow->GetNextPageId();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    page_id=next_page_id;
+  }
+  return offset==len;
+}
+
+void TableHeap::FreeOverflowChain(page_id_t page_id) {
+  while(page_id!=INVALID_PAGE_ID){
+    auto page=buffer_pool_manager_->FetchPage(page_id);
+    if(page==nullptr) return;
+    page_id_t next_page_id=reinterpret_cast<OverflowPage *>(page->GetData())->GetNextPageId();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    buffer_pool_manager_->DeletePage(page_id);
+    page_id=next_page_id;
+  }
+}
+
+void TableHeap::FreeOverflow(Row &row) {
+  for(auto field: row.GetFields()){
+    if(field->IsExternal()) FreeOverflowChain(field->GetExternalPageId());
+  }
+}
+
+void TableHeap::FreeOverflowOfPage(page_id_t page_id) {
+  if(!has_char_columns_) return;
+  auto page=reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+  if(page==nullptr) return;
+  std::vector<Row> released;
+  RowId rid, next_rid;
+  WithPage(page, [&](auto *p){
+    for(bool found=p->GetFirstTupleRid(&rid); found; rid=next_rid){
+      released.emplace_back(rid);
+      p->ReadTuple(&released.back(), schema_);
+      found=p->GetNextTupleRid(rid, &next_rid);
+    }
+  });
+  buffer_pool_manager_->UnpinPage(page_id, false);
+  for(auto &row: released) FreeOverflow(row);
+}
+
 void TableHeap::DeleteTable(page_id_t page_id) {
   if (page_id != INVALID_PAGE_ID) {
+    FreeOverflowOfPage(page_id);
     auto temp_table_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));  // 删除table_heap
+    if (temp_table_page == nullptr) {  //the rest of the chain can not be found, its pages stay allocated
+      LOG(ERROR) << "Cannot read page " << page_id << " while deleting a table";
+      buffer_pool_manager_->DeletePage(page_id);
+      return;
+    }
     if (temp_table_page->GetNextPageId() != INVALID_PAGE_ID)
       DeleteTable(temp_table_page->GetNextPageId());
     buffer_pool_manager_->UnpinPage(page_id, false);
     buffer_pool_manager_->DeletePage(page_id);
   } else {
+    buffer_pool_manager_->ReleaseReservation(&reservation_);
+    buffer_pool_manager_->ReleaseReservation(&overflow_reservation_);
+    free_space_map_.Destroy();
+    dictionary_.Destroy();
+    zone_map_.Destroy();
     DeleteTable(first_page_id_);
   }
 }
@@ -135,18 +620,34 @@ void TableHeap::DeleteTable(page_id_t page_id) {
 /**
  * TODO: Student Implement
  */
-TableIterator TableHeap::Begin(Transaction *txn) {
-  RowId *first_rid=new RowId();
-  auto first_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(first_page_id_)); //first page
-  first_page->GetFirstTupleRid(first_rid);  //first row
-  buffer_pool_manager_->UnpinPage(first_page_id_, false);
-  return TableIterator(first_rid, this, txn);
+TableIterator TableHeap::Begin(Transaction *txn, BufferAccessStrategy *strategy, const std::vector<bool> *columns,
+                               const PageFilter *page_filter) {
+  return TableIterator(this, first_page_id_, txn, strategy, columns, page_filter);
 }
 
 /**
  * TODO: Student Implement
  */
 TableIterator TableHeap::End() {
-  RowId *default_rid=new RowId(); //page_id_=INVALID_PAGE_ID, sloct_num_=0
-  return TableIterator(default_rid, this, nullptr);
+  return TableIterator();  //page_id_=INVALID_PAGE_ID, sloct_num_=0
+}
+
+bool TableHeap::ScanPage(page_id_t page_id, BufferAccessStrategy *strategy, const std::vector<bool> *columns,
+                         std::deque<Row> *rows) {
+  auto page=reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id, strategy));
+  if(page==nullptr) return false;
+  bool some_columns=columns!=nullptr && layout_==TableLayout::PAX;  //only the minipages of these columns are read
+  RowId rid, next_rid;
+  page->RLatch();
+  WithPage(page, [&](auto *p){
+    for(bool found=p->GetFirstTupleRid(&rid); found; rid=next_rid){
+      rows->emplace_back(rid);
+      if(some_columns) static_cast<PaxPage *>(page)->GetTuple(&rows->back(), schema_, *columns);
+      else p->GetTuple(&rows->back(), schema_, nullptr, lock_manager_);
+      found=p->GetNextTupleRid(rid, &next_rid);
+    }
+  });
+  page->RUnlatch();
+  buffer_pool_manager_->UnpinPage(page_id, false);
+  return true;
 }
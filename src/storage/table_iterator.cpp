@@ -6,31 +6,44 @@
 /**
  * TODO: Student Implement
  */
-TableIterator::TableIterator() {}
-
-TableIterator::TableIterator(RowId* rid, TableHeap* th, Transaction* txn) {
-  row_=new Row(*rid);
-  if(rid->GetPageId()!=INVALID_PAGE_ID){
-    page_=reinterpret_cast<TablePage *>(th->buffer_pool_manager_->FetchPage(rid->GetPageId()));
-    heap_=th;
-    txn_=txn;
-    th->GetTuple(row_, txn);
-    th->buffer_pool_manager_->UnpinPage(rid->GetPageId(), false);
+TableIterator::TableIterator() : row_(INVALID_ROWID) {}
+
+TableIterator::TableIterator(TableHeap* th, page_id_t first_page_id, Transaction* txn, BufferAccessStrategy *strategy,
+                             const std::vector<bool> *columns, const PageFilter *page_filter)
+    : row_(RowId(first_page_id, 0)), heap_(th), txn_(txn), strategy_(strategy) {
+  if(columns!=nullptr && heap_->layout_==TableLayout::PAX) columns_=*columns;
+  if(page_filter!=nullptr && heap_->HasZoneMap()){
+    page_filter_=*page_filter;
+    first_page_id=heap_->SkipPages(first_page_id, page_filter_);
+    if(first_page_id==INVALID_PAGE_ID){  //no page can hold a matching tuple
+      row_.SetRowId(INVALID_ROWID);
+      return;
+    }
   }
+  page_=reinterpret_cast<TablePage *>(heap_->buffer_pool_manager_->FetchPage(first_page_id, strategy_));
+  if(page_==nullptr) TableHeap::ThrowUnreadable(first_page_id);
+  // start reading the following pages while this one is being scanned, unless they may be skipped
+  if(!page_filter_){
+    heap_->buffer_pool_manager_->ReadAhead(page_->GetNextPageId(), DEFAULT_READ_AHEAD_PAGES,
+                                           TablePage::ReadNextPageId);
+  }
+  Seek(0);
 }
 
-TableIterator::TableIterator(const TableIterator &other) {
-  row_=new Row(*other.row_);
-  page_=other.page_;
-  heap_=other.heap_;
-  txn_=other.txn_;
+TableIterator::TableIterator(const TableIterator &other)
+    : row_(other.row_), heap_(other.heap_), txn_(other.txn_), strategy_(other.strategy_), columns_(other.columns_),
+      page_filter_(other.page_filter_) {}
+
+TableIterator::TableIterator(TableIterator &&other) noexcept
+    : row_(other.row_), heap_(other.heap_), page_(other.page_), txn_(other.txn_), strategy_(other.strategy_),
+      columns_(std::move(other.columns_)), page_filter_(std::move(other.page_filter_)) {
+  other.page_=nullptr;  //the pin moves with the iterator
 }
 
-TableIterator::~TableIterator() {}
+TableIterator::~TableIterator() { Release(); }
 
 bool TableIterator::operator==(const TableIterator &itr) const {
-  if(row_==nullptr && itr.row_==nullptr) return true;
-  return row_->GetRowId().Get()==itr.row_->GetRowId().Get();
+  return row_.GetRowId().Get()==itr.row_.GetRowId().Get();
 }
 
 bool TableIterator::operator!=(const TableIterator &itr) const {
@@ -38,41 +51,48 @@ bool TableIterator::operator!=(const TableIterator &itr) const {
 }
 
 const Row &TableIterator::operator*() {
-  return *row_;
+  return row_;
 }
 
 Row *TableIterator::operator->() {
-  return row_;
+  return &row_;
 }
 
-TableIterator &TableIterator::operator=(const TableIterator &itr) noexcept {
+TableIterator &TableIterator::operator=(const TableIterator &itr) {
+  if(this==&itr) return *this;
+  Release();
   row_=itr.row_;
-  page_=itr.page_;
   heap_=itr.heap_;
   txn_=itr.txn_;
+  strategy_=itr.strategy_;
+  columns_=itr.columns_;
+  page_filter_=itr.page_filter_;
+  return *this;
+}
+
+TableIterator &TableIterator::operator=(TableIterator &&itr) noexcept {
+  if(this==&itr) return *this;
+  Release();
+  row_=itr.row_;
+  heap_=itr.heap_;
+  page_=itr.page_;
+  txn_=itr.txn_;
+  strategy_=itr.strategy_;
+  columns_=std::move(itr.columns_);
+  page_filter_=std::move(itr.page_filter_);
+  itr.page_=nullptr;
   return *this;
 }
 
 // ++iter
 TableIterator &TableIterator::operator++() {
-  auto next_rid=new RowId();
-  if(page_->GetNextTupleRid(row_->GetRowId(), next_rid)){
-    row_=new Row(*next_rid);  //assign rid
-    heap_->GetTuple(row_, txn_);  //assign other members of row_
-  }
-  else{ //go to next page
-    auto next_pid=page_->GetNextPageId();
-    if(next_pid==INVALID_PAGE_ID) row_->SetRowId(RowId());  //no more pages
-    else{
-      page_=reinterpret_cast<TablePage *>(heap_->buffer_pool_manager_->FetchPage(next_pid));
-      if(page_->GetFirstTupleRid(next_rid)){  //first_rid exists
-        row_=new Row(*next_rid);
-        heap_->GetTuple(row_, txn_);
-      }
-      else row_->SetRowId(RowId()); //first_rid not exists
-      heap_->buffer_pool_manager_->UnpinPage(page_->GetPageId(), true);
-    }
+  RowId rid=row_.GetRowId();
+  if(rid.GetPageId()==INVALID_PAGE_ID) return *this;  //already at the end
+  if(page_==nullptr){  //a copy pins the page of its tuple again
+    page_=reinterpret_cast<TablePage *>(heap_->buffer_pool_manager_->FetchPage(rid.GetPageId(), strategy_));
+    if(page_==nullptr) TableHeap::ThrowUnreadable(rid.GetPageId());
   }
+  Seek(rid.GetSlotNum()+1);
   return *this;
 }
 
@@ -80,5 +100,49 @@ TableIterator &TableIterator::operator++() {
 TableIterator TableIterator::operator++(int) {
   TableIterator old(*this);
   ++(*this);
-  return TableIterator(old);
+  return old;
+}
+
+void TableIterator::Seek(uint32_t slot) {
+  while(true){
+    RowId rid;
+    page_->RLatch();
+    bool found=heap_->WithPage(page_, [&](auto *page){
+      return slot==0 ? page->GetFirstTupleRid(&rid)
+                     : page->GetNextTupleRid(RowId(page->GetTablePageId(), slot-1), &rid);
+    });
+    if(found){
+      row_.destroy();
+      row_.SetRowId(rid);
+      if(!columns_.empty()){  //only the minipages of the scanned columns are read
+        static_cast<PaxPage *>(page_)->GetTuple(&row_, heap_->schema_, columns_);
+      }
+      else{
+        heap_->WithPage(page_, [&](auto *page){ page->GetTuple(&row_, heap_->schema_, txn_, heap_->lock_manager_); });
+      }
+    }
+    page_id_t next_page_id=page_->GetNextPageId();
+    page_->RUnlatch();
+    if(found) return;
+    Release();  //go to next page
+    if(page_filter_) next_page_id=heap_->SkipPages(next_page_id, page_filter_);
+    if(next_page_id==INVALID_PAGE_ID){  //no more pages
+      row_.SetRowId(INVALID_ROWID);
+      return;
+    }
+    page_=reinterpret_cast<TablePage *>(heap_->buffer_pool_manager_->FetchPage(next_page_id, strategy_));
+    if(page_==nullptr) TableHeap::ThrowUnreadable(next_page_id);  //the iterator stays on its last tuple
+    if(!page_filter_){
+      heap_->buffer_pool_manager_->ReadAhead(page_->GetNextPageId(), DEFAULT_READ_AHEAD_PAGES,
+                                             TablePage::ReadNextPageId);
+    }
+    slot=0;
+  }
+}
+
+void TableIterator::Release() {
+  if(page_!=nullptr){
+    heap_->buffer_pool_manager_->UnpinPage(page_->GetTablePageId(), false);
+    page_=nullptr;
+  }
 }
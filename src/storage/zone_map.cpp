@@ -0,0 +1,375 @@
+#include "storage/zone_map.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <climits>
+#include <unordered_set>
+
+#include "glog/logging.h"
+
+ZoneMap::ZoneMap(BufferPoolManager *buffer_pool_manager, Schema *schema)
+    : buffer_pool_manager_(buffer_pool_manager), page_size_(buffer_pool_manager->GetPageSize()) {
+  summary_of_.assign(schema->GetColumnCount(), -1);
+  for (uint32_t i = 0; i < schema->GetColumnCount(); i++) {
+    TypeId type = schema->GetColumn(i)->GetType();
+    if (type == TypeId::kTypeInt || type == TypeId::kTypeFloat) {
+      summary_of_[i] = static_cast<int32_t>(columns_.size());
+      columns_.push_back(i);
+      types_.push_back(type);
+    }
+  }
+  entry_size_ = ZoneMapPage::GetEntrySize(columns_.size());
+  entries_per_page_ = ZoneMapPage::GetCapacity(page_size_, entry_size_);
+  if (entries_per_page_ == 0) {
+    // the summaries of a page do not fit in a map page, the table has no zone map
+    columns_.clear();
+    types_.clear();
+    summary_of_.assign(schema->GetColumnCount(), -1);
+  }
+}
+
+bool ZoneMap::Create(ExtentReservation *reservation) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  page_id_t page_id;
+  auto page = buffer_pool_manager_->NewPage(page_id, reservation);
+  if (page == nullptr) {
+    return false;
+  }
+  auto map_page = reinterpret_cast<ZoneMapPage *>(page->GetData());
+  map_page->Init(entry_size_);
+  map_page->SetClean(false);  // the first page of the heap is not in it yet
+  buffer_pool_manager_->UnpinPage(page_id, true);
+  map_pages_.push_back(page_id);
+  dirty_.push_back(false);
+  return true;
+}
+
+bool ZoneMap::Load(page_id_t first_page_id) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  bool clean = true;
+  page_id_t page_id = first_page_id;
+  while (page_id != INVALID_PAGE_ID) {
+    auto page = buffer_pool_manager_->FetchPage(page_id);
+    if (page == nullptr) {
+      LOG(ERROR) << "Cannot read zone map page " << page_id;
+      clean = false;
+      break;
+    }
+    auto map_page = reinterpret_cast<ZoneMapPage *>(page->GetData());
+    if (map_pages_.empty()) {
+      clean = map_page->IsClean();
+    }
+    map_pages_.push_back(page_id);
+    dirty_.push_back(false);
+    for (uint32_t i = 0; i < map_page->GetCount(); i++) {
+      char *entry = map_page->GetEntry(i);
+      page_id_t heap_page_id;
+      memcpy(&heap_page_id, entry, sizeof(page_id_t));
+      index_[heap_page_id] = heap_pages_.size();
+      heap_pages_.push_back(heap_page_id);
+      for (size_t c = 0; c < columns_.size(); c++) {
+        Summary summary;
+        memcpy(&summary, entry + sizeof(page_id_t) + c * ZoneMapPage::SIZE_SUMMARY, ZoneMapPage::SIZE_SUMMARY);
+        summaries_.push_back(summary);
+      }
+    }
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    page_id = map_page->GetNextPageId();
+  }
+  clean_on_disk_ = clean;
+  if (!clean) {
+    // the heap may have changed after the map was written, the caller lists its pages again
+    heap_pages_.clear();
+    summaries_.clear();
+    index_.clear();
+    dirty_.assign(map_pages_.size(), true);
+  }
+  return clean;
+}
+
+void ZoneMap::Flush() {
+  std::scoped_lock<std::mutex> lock(latch_);
+  if (off_ || map_pages_.empty()) {
+    return;  // stays unclean on disk
+  }
+  bool written = true;
+  for (size_t m = 0; m < map_pages_.size(); m++) {
+    if (!dirty_[m]) {
+      continue;
+    }
+    auto page = buffer_pool_manager_->FetchPage(map_pages_[m]);
+    if (page == nullptr) {
+      LOG(WARNING) << "Cannot write zone map page " << map_pages_[m];
+      written = false;
+      continue;
+    }
+    auto map_page = reinterpret_cast<ZoneMapPage *>(page->GetData());
+    size_t begin = std::min<size_t>(m * entries_per_page_, heap_pages_.size());
+    auto count = static_cast<uint32_t>(std::min<size_t>(entries_per_page_, heap_pages_.size() - begin));
+    map_page->SetNextPageId(m + 1 < map_pages_.size() ? map_pages_[m + 1] : INVALID_PAGE_ID);
+    map_page->SetCount(count);
+    for (uint32_t i = 0; i < count; i++) {
+      char *entry = map_page->GetEntry(i);
+      memcpy(entry, &heap_pages_[begin + i], sizeof(page_id_t));
+      memcpy(entry + sizeof(page_id_t), &summaries_[(begin + i) * columns_.size()],
+             columns_.size() * ZoneMapPage::SIZE_SUMMARY);
+    }
+    buffer_pool_manager_->UnpinPage(map_pages_[m], true);
+    // on disk before the clean flag, which is on the first page
+    buffer_pool_manager_->FlushPage(map_pages_[m]);
+    dirty_[m] = false;
+  }
+  if (written && !clean_on_disk_) {
+    clean_on_disk_ = WriteClean(true);
+  }
+}
+
+void ZoneMap::TurnOff() {
+  std::scoped_lock<std::mutex> lock(latch_);
+  TurnOffLocked();
+}
+
+bool ZoneMap::IsUsable() {
+  std::scoped_lock<std::mutex> lock(latch_);
+  return !off_ && !map_pages_.empty();
+}
+
+void ZoneMap::Destroy() {
+  std::scoped_lock<std::mutex> lock(latch_);
+  for (auto page_id : map_pages_) {
+    buffer_pool_manager_->DeletePage(page_id);
+  }
+  map_pages_.clear();
+  dirty_.clear();
+  clean_on_disk_ = false;
+  heap_pages_.clear();
+  summaries_.clear();
+  index_.clear();
+}
+
+void ZoneMap::AddPage(page_id_t page_id, ExtentReservation *reservation) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  if (off_ || map_pages_.empty()) {
+    return;
+  }
+  auto index = static_cast<uint32_t>(heap_pages_.size());
+  if (index == map_pages_.size() * entries_per_page_) {
+    // the last map page is full, chain a new one, the link is written by the next flush
+    page_id_t new_page_id;
+    auto new_page = buffer_pool_manager_->NewPage(new_page_id, reservation);
+    if (new_page == nullptr) {
+      // a heap page missing from the map would be stepped over by GetNextPage
+      LOG(WARNING) << "Cannot extend zone map, it is turned off";
+      TurnOffLocked();
+      return;
+    }
+    reinterpret_cast<ZoneMapPage *>(new_page->GetData())->Init(entry_size_);
+    buffer_pool_manager_->UnpinPage(new_page_id, true);
+    MarkPageDirty(map_pages_.size() - 1);
+    map_pages_.push_back(new_page_id);
+    dirty_.push_back(true);
+  }
+  index_[page_id] = index;
+  heap_pages_.push_back(page_id);
+  for (size_t c = 0; c < columns_.size(); c++) {
+    summaries_.push_back(EmptySummary(c));
+  }
+  MarkDirty(index);
+}
+
+void ZoneMap::RemovePages(const std::vector<page_id_t> &page_ids) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  if (off_ || page_ids.empty()) {
+    return;
+  }
+  MarkPageDirty(0);  // clears the clean flag before any map page is freed
+  std::unordered_set<page_id_t> removed(page_ids.begin(), page_ids.end());
+  size_t first = heap_pages_.size();  // first entry that moves
+  size_t kept = 0;
+  size_t width = columns_.size();
+  for (size_t i = 0; i < heap_pages_.size(); i++) {
+    if (removed.count(heap_pages_[i]) > 0) {
+      index_.erase(heap_pages_[i]);
+      first = std::min(first, i);
+      continue;
+    }
+    heap_pages_[kept] = heap_pages_[i];
+    std::copy_n(summaries_.begin() + i * width, width, summaries_.begin() + kept * width);
+    index_[heap_pages_[kept]] = kept;
+    kept++;
+  }
+  if (first == heap_pages_.size()) {
+    return;
+  }
+  heap_pages_.resize(kept);
+  summaries_.resize(kept * width);
+  // the map pages from the first moved entry on are rewritten, those no longer needed are freed
+  size_t needed = std::max<size_t>(1, (kept + entries_per_page_ - 1) / entries_per_page_);
+  for (size_t m = needed; m < map_pages_.size(); m++) {
+    buffer_pool_manager_->DeletePage(map_pages_[m]);
+  }
+  map_pages_.resize(needed);
+  dirty_.resize(needed);
+  for (size_t m = std::min(first / entries_per_page_, needed - 1); m < needed; m++) {
+    MarkPageDirty(m);
+  }
+}
+
+void ZoneMap::Include(page_id_t page_id, Row *const *rows, size_t count) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  auto it = index_.find(page_id);
+  if (it == index_.end()) {
+    return;
+  }
+  size_t width = columns_.size();
+  std::vector<Summary> old(summaries_.begin() + it->second * width, summaries_.begin() + (it->second + 1) * width);
+  for (size_t i = 0; i < count; i++) {
+    IncludeRow(it->second, *rows[i]);
+  }
+  // most inserts leave the summaries as they were
+  if (memcmp(old.data(), &summaries_[it->second * width], width * sizeof(Summary)) != 0) {
+    MarkDirty(it->second);
+  }
+}
+
+void ZoneMap::Reset(page_id_t page_id, Row *const *rows, size_t count) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  auto it = index_.find(page_id);
+  if (it == index_.end()) {
+    return;
+  }
+  for (size_t c = 0; c < columns_.size(); c++) {
+    summaries_[it->second * columns_.size() + c] = EmptySummary(c);
+  }
+  for (size_t i = 0; i < count; i++) {
+    IncludeRow(it->second, *rows[i]);
+  }
+  MarkDirty(it->second);
+}
+
+bool ZoneMap::MayMatch(page_id_t page_id, uint32_t column, const std::string &comp_type, const Field &constant) {
+  if (column >= summary_of_.size() || summary_of_[column] < 0) {
+    return true;
+  }
+  auto c = static_cast<size_t>(summary_of_[column]);
+  Summary summary;
+  {
+    std::scoped_lock<std::mutex> lock(latch_);
+    auto it = index_.find(page_id);
+    if (it == index_.end()) {
+      return true;
+    }
+    summary = summaries_[it->second * columns_.size() + c];
+  }
+  bool has_values = !Less(c, summary.max_, summary.min_);
+  if (comp_type == "is") {
+    return summary.null_count_ > 0;
+  }
+  if (comp_type == "not") {
+    return has_values;
+  }
+  if (constant.IsNull() || constant.GetTypeId() != types_[c]) {
+    return true;
+  }
+  if (!has_values) {
+    return false;  // a comparison with a null is never true
+  }
+  Value value;
+  constant.SerializeTo(reinterpret_cast<char *>(&value));
+  if (comp_type == "=") {
+    return !Less(c, value, summary.min_) && !Less(c, summary.max_, value);
+  }
+  if (comp_type == "<>") {
+    return Less(c, summary.min_, summary.max_) || Less(c, value, summary.min_) || Less(c, summary.min_, value);
+  }
+  if (comp_type == "<") {
+    return Less(c, summary.min_, value);
+  }
+  if (comp_type == "<=") {
+    return !Less(c, value, summary.min_);
+  }
+  if (comp_type == ">") {
+    return Less(c, value, summary.max_);
+  }
+  if (comp_type == ">=") {
+    return !Less(c, summary.max_, value);
+  }
+  return true;
+}
+
+bool ZoneMap::GetNextPage(page_id_t page_id, page_id_t *next_page_id) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  auto it = index_.find(page_id);
+  if (it == index_.end()) {
+    return false;
+  }
+  *next_page_id = it->second + 1 < heap_pages_.size() ? heap_pages_[it->second + 1] : INVALID_PAGE_ID;
+  return true;
+}
+
+void ZoneMap::MarkDirty(uint32_t index) { MarkPageDirty(index / entries_per_page_); }
+
+void ZoneMap::MarkPageDirty(size_t m) {
+  if (clean_on_disk_) {
+    // the map on disk must not be trusted once it falls behind the heap
+    clean_on_disk_ = !WriteClean(false);
+  }
+  dirty_[m] = true;
+}
+
+bool ZoneMap::WriteClean(bool clean) {
+  auto page = buffer_pool_manager_->FetchPage(map_pages_.front());
+  if (page == nullptr) {
+    LOG(WARNING) << "Cannot update zone map page " << map_pages_.front();
+    return false;
+  }
+  reinterpret_cast<ZoneMapPage *>(page->GetData())->SetClean(clean);
+  buffer_pool_manager_->UnpinPage(map_pages_.front(), true);
+  return buffer_pool_manager_->FlushPage(map_pages_.front());
+}
+
+void ZoneMap::TurnOffLocked() {
+  if (clean_on_disk_) {
+    clean_on_disk_ = !WriteClean(false);
+  }
+  off_ = true;
+  heap_pages_.clear();
+  summaries_.clear();
+  index_.clear();
+}
+
+ZoneMap::Summary ZoneMap::EmptySummary(size_t c) const {
+  Summary summary;
+  if (types_[c] == TypeId::kTypeInt) {
+    summary.min_.integer_ = INT32_MAX;
+    summary.max_.integer_ = INT32_MIN;
+  } else {
+    summary.min_.float_ = FLT_MAX;
+    summary.max_.float_ = -FLT_MAX;
+  }
+  summary.null_count_ = 0;
+  return summary;
+}
+
+void ZoneMap::IncludeRow(uint32_t index, const Row &row) {
+  for (size_t c = 0; c < columns_.size(); c++) {
+    Field *field = row.GetField(columns_[c]);
+    Summary &summary = summaries_[index * columns_.size() + c];
+    if (field->IsNull()) {
+      summary.null_count_++;
+      continue;
+    }
+    Value value;
+    field->SerializeTo(reinterpret_cast<char *>(&value));
+    if (Less(c, value, summary.min_)) {
+      summary.min_ = value;
+    }
+    if (Less(c, summary.max_, value)) {
+      summary.max_ = value;
+    }
+  }
+}
+
+bool ZoneMap::Less(size_t c, const Value &a, const Value &b) const {
+  return types_[c] == TypeId::kTypeInt ? a.integer_ < b.integer_ : a.float_ < b.float_;
+}
@@ -1,8 +1,13 @@
 #include "buffer/buffer_pool_manager.h"
 
+#include <algorithm>
+#include <chrono>
 #include <cstdio>
+#include <fstream>
 #include <random>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "gtest/gtest.h"
 
@@ -61,8 +66,9 @@ TEST(BufferPoolManagerTest, BinaryDataTest) {
     bpm->UnpinPage(page_id_temp, false);
   }
   // Scenario: We should be able to fetch the data we wrote a while ago.
+  // The last bytes of a page hold its checksum.
   page0 = bpm->FetchPage(0);
-  EXPECT_EQ(0, memcmp(page0->GetData(), random_binary_data, PAGE_SIZE));
+  EXPECT_EQ(0, memcmp(page0->GetData(), random_binary_data, PAGE_SIZE - PAGE_CHECKSUM_SIZE));
   EXPECT_EQ(true, bpm->UnpinPage(0, true));
 
   // Shutdown the disk manager and remove the temporary file we created.
@@ -71,4 +77,530 @@ TEST(BufferPoolManagerTest, BinaryDataTest) {
 
   delete bpm;
   delete disk_manager;
-}
\ No newline at end of file
+}
+TEST(BufferPoolManagerTest, PartitionedPoolTest) {
+  const std::string db_name = "bpm_partition_test.db";
+  const size_t buffer_pool_size = 10;
+  const size_t num_instances = 4;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, num_instances);
+  ASSERT_EQ(num_instances, bpm->GetNumInstances());
+
+  // Scenario: instances hold 3, 3, 2 and 2 frames, and page i goes to instance i % 4, so ten pages fill the pool.
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    auto *page = bpm->NewPage(page_id_temp);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(i, page_id_temp);
+    snprintf(page->GetData(), PAGE_SIZE, "page-%d", page_id_temp);
+  }
+
+  // Scenario: the instance owning the next page id is full, the page id must be given back.
+  EXPECT_EQ(nullptr, bpm->NewPage(page_id_temp));
+  EXPECT_EQ(nullptr, bpm->NewPage(page_id_temp));
+  EXPECT_TRUE(bpm->IsPageFree(buffer_pool_size));
+
+  // Scenario: unpinning a page of instance 2 makes room for page 10 there.
+  EXPECT_TRUE(bpm->UnpinPage(2, true));
+  EXPECT_NE(nullptr, bpm->NewPage(page_id_temp));
+  EXPECT_EQ(buffer_pool_size, page_id_temp);
+  EXPECT_TRUE(bpm->UnpinPage(page_id_temp, false));
+
+  // Scenario: page 2 was written back on eviction and can be read again.
+  auto *page2 = bpm->FetchPage(2);
+  ASSERT_NE(nullptr, page2);
+  EXPECT_STREQ("page-2", page2->GetData());
+
+  // Scenario: a clean unpin must not hide an earlier dirty unpin of the same page.
+  ASSERT_EQ(page2, bpm->FetchPage(2));
+  snprintf(page2->GetData(), PAGE_SIZE, "page-2-updated");
+  EXPECT_TRUE(bpm->UnpinPage(2, true));
+  EXPECT_TRUE(bpm->UnpinPage(2, false));
+  EXPECT_FALSE(bpm->UnpinPage(2, false));
+  EXPECT_TRUE(bpm->UnpinPage(6, true));
+  for (page_id_t id : {14, 18, 22}) {
+    ASSERT_NE(nullptr, bpm->FetchPage(id));
+    EXPECT_TRUE(bpm->UnpinPage(id, false));
+  }
+  page2 = bpm->FetchPage(2);
+  ASSERT_NE(nullptr, page2);
+  EXPECT_STREQ("page-2-updated", page2->GetData());
+  EXPECT_TRUE(bpm->UnpinPage(2, false));
+  for (page_id_t i = 0; i < static_cast<page_id_t>(buffer_pool_size); ++i) {
+    if (i % num_instances != 2) {
+      EXPECT_TRUE(bpm->UnpinPage(i, true));
+    }
+  }
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, FullInstanceTest) {
+  const std::string db_name = "bpm_full_instance_test.db";
+  const size_t buffer_pool_size = 8;
+  const size_t num_instances = 4;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, num_instances);
+
+  // Scenario: pages 0 and 4 stay pinned and fill instance 0, every other instance has room.
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(page_id_temp));
+    if (page_id_temp % num_instances != 0) {
+      EXPECT_TRUE(bpm->UnpinPage(page_id_temp, true));
+    }
+  }
+
+  // Scenario: page 8 belongs to the full instance 0, so the page goes to instance 1 as page 9 and page 8 stays free.
+  ASSERT_NE(nullptr, bpm->NewPage(page_id_temp));
+  EXPECT_EQ(9, page_id_temp);
+  EXPECT_TRUE(bpm->IsPageFree(8));
+  EXPECT_TRUE(bpm->UnpinPage(page_id_temp, true));
+  ASSERT_NE(nullptr, bpm->NewPage(page_id_temp));
+  EXPECT_EQ(10, page_id_temp);
+  EXPECT_TRUE(bpm->IsPageFree(8));
+
+  // Scenario: once every frame is pinned the call fails and gives back every page id it tried.
+  std::vector<page_id_t> pinned = {0, 4, 10};
+  while (true) {
+    auto *page = bpm->NewPage(page_id_temp);
+    if (page == nullptr) break;
+    pinned.push_back(page_id_temp);
+  }
+  EXPECT_EQ(buffer_pool_size, pinned.size());
+  page_id_t next_page_id = *std::max_element(pinned.begin(), pinned.end()) + 1;
+  for (page_id_t id = 8; id < next_page_id + static_cast<page_id_t>(num_instances); ++id) {
+    if (id != 9 && std::find(pinned.begin(), pinned.end(), id) == pinned.end()) {
+      EXPECT_TRUE(bpm->IsPageFree(id));
+    }
+  }
+  for (auto id : pinned) {
+    EXPECT_TRUE(bpm->UnpinPage(id, false));
+  }
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, ConcurrentPartitionedTest) {
+  const std::string db_name = "bpm_concurrent_test.db";
+  const size_t buffer_pool_size = 64;
+  const int num_threads = 8;
+  const int pages_per_thread = 32;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, 8);
+
+  std::vector<std::thread> threads;
+  std::vector<std::vector<page_id_t>> thread_pages(num_threads);
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t]() {
+      for (int i = 0; i < pages_per_thread; i++) {
+        page_id_t page_id;
+        Page *page = nullptr;
+        while ((page = bpm->NewPage(page_id)) == nullptr) {
+          std::this_thread::yield();
+        }
+        snprintf(page->GetData(), PAGE_SIZE, "%d", page_id);
+        thread_pages[t].push_back(page_id);
+        bpm->UnpinPage(page_id, true);
+      }
+      for (auto page_id : thread_pages[t]) {
+        Page *page = nullptr;
+        while ((page = bpm->FetchPage(page_id)) == nullptr) {
+          std::this_thread::yield();
+        }
+        EXPECT_EQ(std::to_string(page_id), page->GetData());
+        bpm->UnpinPage(page_id, false);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, BackgroundFlushTest) {
+  const std::string db_name = "bpm_flush_test.db";
+  const size_t buffer_pool_size = 16;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, 2);
+
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    auto *page = bpm->NewPage(page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page-%d", page_id_temp);
+    // keep the last page pinned, the flusher must leave it alone
+    if (i + 1 < buffer_pool_size) {
+      EXPECT_TRUE(bpm->UnpinPage(page_id_temp, true));
+    }
+  }
+
+  // Scenario: the flusher writes unpinned dirty pages back until every instance is entirely clean.
+  bpm->StartFlusher(1.0, 1);
+  char data[PAGE_SIZE];
+  for (int retry = 0; retry < 1000; retry++) {
+    disk_manager->ReadPage(buffer_pool_size - 2, data);
+    if (strcmp(data, ("page-" + std::to_string(buffer_pool_size - 2)).c_str()) == 0) break;
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  bpm->StopFlusher();
+  for (page_id_t i = 0; i + 1 < static_cast<page_id_t>(buffer_pool_size); ++i) {
+    disk_manager->ReadPage(i, data);
+    EXPECT_EQ("page-" + std::to_string(i), std::string(data));
+  }
+
+  // Scenario: pages modified after the flush are dirty again and reach the disk through FlushAllPages.
+  auto *page0 = bpm->FetchPage(0);
+  ASSERT_NE(nullptr, page0);
+  snprintf(page0->GetData(), PAGE_SIZE, "page-0-updated");
+  EXPECT_TRUE(bpm->UnpinPage(0, true));
+  bpm->FlushAllPages();
+  disk_manager->ReadPage(0, data);
+  EXPECT_STREQ("page-0-updated", data);
+  disk_manager->ReadPage(buffer_pool_size - 1, data);
+  EXPECT_EQ("page-" + std::to_string(buffer_pool_size - 1), std::string(data));
+  EXPECT_TRUE(bpm->UnpinPage(buffer_pool_size - 1, false));
+
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+static page_id_t ChainNextPageId(const char *page_data) {
+  return *reinterpret_cast<const page_id_t *>(page_data);
+}
+
+TEST(BufferPoolManagerTest, ReadAheadTest) {
+  const std::string db_name = "bpm_read_ahead_test.db";
+  const size_t buffer_pool_size = 8;
+  const page_id_t chain_length = 6;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  // Build a chain of pages on disk, each page stores the id of the next one in its first bytes.
+  char data[PAGE_SIZE];
+  for (page_id_t i = 0; i < chain_length; ++i) {
+    ASSERT_EQ(i, disk_manager->AllocatePage());
+    memset(data, 0, PAGE_SIZE);
+    page_id_t next_page_id = i + 1 < chain_length ? i + 1 : INVALID_PAGE_ID;
+    memcpy(data, &next_page_id, sizeof(page_id_t));
+    snprintf(data + sizeof(page_id_t), PAGE_SIZE - sizeof(page_id_t), "page-%d", i);
+    disk_manager->WritePage(i, data);
+  }
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, 2);
+
+  // Scenario: read ahead the first four pages of the chain.
+  bpm->ReadAhead(0, 4, ChainNextPageId);
+  bpm->DrainReadAhead();
+
+  // Scenario: change the pages on disk behind the buffer pool, prefetched pages still show the old content.
+  for (page_id_t i = 0; i < chain_length; ++i) {
+    memset(data, 0, PAGE_SIZE);
+    snprintf(data + sizeof(page_id_t), PAGE_SIZE - sizeof(page_id_t), "changed-%d", i);
+    disk_manager->WritePage(i, data);
+  }
+  for (page_id_t i = 0; i < chain_length; ++i) {
+    auto *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    std::string expected = (i < 4 ? "page-" : "changed-") + std::to_string(i);
+    EXPECT_EQ(expected, std::string(page->GetData() + sizeof(page_id_t)));
+    EXPECT_TRUE(bpm->UnpinPage(i, false));
+  }
+
+  // Scenario: read-ahead never pins, every frame can still be used.
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+  bpm->ReadAhead(0, chain_length, ChainNextPageId);
+  bpm->DrainReadAhead();
+  std::vector<page_id_t> page_ids(buffer_pool_size);
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    EXPECT_NE(nullptr, bpm->NewPage(page_ids[i]));
+  }
+  for (auto page_id : page_ids) {
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, BulkReadStrategyTest) {
+  const std::string db_name = "bpm_bulk_read_test.db";
+  const size_t buffer_pool_size = 8;
+  const page_id_t cold_pages = 20;
+  const page_id_t hot_pages = 4;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+  // Pages [0, cold_pages) are scanned, the following hot_pages pages are used by point queries.
+  page_id_t page_id_temp;
+  for (page_id_t i = 0; i < cold_pages + hot_pages; ++i) {
+    auto *page = bpm->NewPage(page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page-%d", page_id_temp);
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, true));
+  }
+  bpm->FlushAllPages();
+
+  // Scenario: a scan through a two frame ring reads every cold page.
+  BufferAccessStrategy strategy(2);
+  for (page_id_t i = 0; i < cold_pages; ++i) {
+    auto *page = bpm->FetchPage(i, &strategy);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page-" + std::to_string(i), std::string(page->GetData()));
+    EXPECT_TRUE(bpm->UnpinPage(i, false));
+  }
+
+  // Scenario: the hot pages are still cached, changing them on disk behind the pool is not visible.
+  char data[PAGE_SIZE];
+  memset(data, 0, PAGE_SIZE);
+  snprintf(data, PAGE_SIZE, "changed");
+  for (page_id_t i = cold_pages; i < cold_pages + hot_pages; ++i) {
+    disk_manager->WritePage(i, data);
+  }
+  for (page_id_t i = cold_pages; i < cold_pages + hot_pages; ++i) {
+    auto *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page-" + std::to_string(i), std::string(page->GetData()));
+    EXPECT_TRUE(bpm->UnpinPage(i, false));
+  }
+
+  // Scenario: the same scan without a strategy pushes them out.
+  for (page_id_t i = 0; i < cold_pages; ++i) {
+    ASSERT_NE(nullptr, bpm->FetchPage(i));
+    EXPECT_TRUE(bpm->UnpinPage(i, false));
+  }
+  auto *page = bpm->FetchPage(cold_pages);
+  ASSERT_NE(nullptr, page);
+  EXPECT_STREQ("changed", page->GetData());
+  EXPECT_TRUE(bpm->UnpinPage(cold_pages, false));
+
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, StatsTest) {
+  const std::string db_name = "bpm_stats_test.db";
+  const size_t buffer_pool_size = 4;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, 2);
+  auto disk_before = disk_manager->GetStats();
+
+  // Scenario: six new dirty pages in four frames evict two dirty pages.
+  page_id_t page_id_temp;
+  for (int i = 0; i < 6; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(page_id_temp));
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, true));
+  }
+  auto stats = bpm->GetStats();
+  EXPECT_EQ(2, stats.evictions_);
+  EXPECT_EQ(2, stats.dirty_evictions_);
+
+  // Scenario: pages 4 and 5 are resident, pages 0 and 1 are not.
+  for (page_id_t i : {4, 5, 0, 1}) {
+    ASSERT_NE(nullptr, bpm->FetchPage(i));
+    EXPECT_TRUE(bpm->UnpinPage(i, false));
+  }
+  stats = bpm->GetStats();
+  EXPECT_EQ(2, stats.hits_);
+  EXPECT_EQ(2, stats.misses_);
+
+  // Scenario: the disk counters see the page reads and writes.
+  auto disk_after = disk_manager->GetStats();
+  EXPECT_LE(disk_before.pages_read_ + 2, disk_after.pages_read_);
+  EXPECT_LE(disk_before.pages_written_ + 4, disk_after.pages_written_);
+  EXPECT_EQ(disk_after.pages_written_ * PAGE_SIZE, disk_after.bytes_written_);
+
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, WarmUpTest) {
+  const std::string db_name = "bpm_warm_up_test.db";
+  const std::string list_name = "bpm_warm_up_test.db.resident";
+  const size_t buffer_pool_size = 8;
+
+  remove(db_name.c_str());
+  remove(list_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, 2);
+
+  // Scenario: twelve pages are written, the last eight stay resident.
+  page_id_t page_id_temp;
+  for (int i = 0; i < 12; ++i) {
+    auto *page = bpm->NewPage(page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page-%d", page_id_temp);
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, true));
+  }
+  auto resident = bpm->GetResidentPages();
+  std::sort(resident.begin(), resident.end());
+  EXPECT_EQ(std::vector<page_id_t>({4, 5, 6, 7, 8, 9, 10, 11}), resident);
+  ASSERT_TRUE(bpm->SaveResidentPages(list_name));
+  delete bpm;
+
+  // Scenario: a new pool loads the same pages in the background, the list is used only once.
+  bpm = new BufferPoolManager(buffer_pool_size, disk_manager, 2);
+  ASSERT_TRUE(bpm->LoadResidentPages(list_name));
+  EXPECT_FALSE(bpm->LoadResidentPages(list_name));
+  bpm->DrainReadAhead();
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+  auto stats = bpm->GetStats();
+  EXPECT_EQ(8, stats.prefetched_pages_);
+  for (page_id_t i = 4; i < 12; ++i) {
+    auto *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page-" + std::to_string(i), std::string(page->GetData()));
+    EXPECT_TRUE(bpm->UnpinPage(i, false));
+  }
+  stats = bpm->GetStats();
+  EXPECT_EQ(8, stats.hits_);
+  EXPECT_EQ(0, stats.misses_);
+
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, DirectIOTest) {
+  const std::string db_name = "bpm_direct_io_test.db";
+  const size_t buffer_pool_size = 16;
+  const int num_pages = 64;
+  for (IOBackend backend : {IOBackend::SYNC, IOBackend::IO_URING}) {
+    remove(db_name.c_str());
+    auto *disk_manager = new DiskManager(db_name, backend, PAGE_SIZE, true);
+    auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, 2);
+    // Scenario: frames are page aligned, so that O_DIRECT can read and write them in place.
+    for (int i = 0; i < num_pages; i++) {
+      page_id_t page_id;
+      auto *page = bpm->NewPage(page_id);
+      ASSERT_NE(nullptr, page);
+      ASSERT_EQ(i, page_id);
+      EXPECT_EQ(0, reinterpret_cast<uintptr_t>(page->GetData()) % PAGE_SIZE);
+      snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+      bpm->UnpinPage(page_id, true);
+    }
+    for (int i = 0; i < num_pages; i++) {
+      auto *page = bpm->FetchPage(i);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ("page " + std::to_string(i), std::string(page->GetData()));
+      bpm->UnpinPage(i, false);
+    }
+    // Scenario: buffers that are not aligned go through a bounce buffer.
+    std::vector<char> buffer(PAGE_SIZE + 1);
+    disk_manager->WritePage(num_pages, buffer.data() + 1);
+    disk_manager->ReadPage(0, buffer.data() + 1);
+    EXPECT_EQ("page 0", std::string(buffer.data() + 1));
+    delete bpm;
+    delete disk_manager;
+    // Scenario: what was written with direct I/O reads back with buffered I/O.
+    disk_manager = new DiskManager(db_name);
+    for (int i = 0; i < num_pages; i++) {
+      disk_manager->ReadPage(i, buffer.data());
+      EXPECT_EQ("page " + std::to_string(i), std::string(buffer.data()));
+    }
+    delete disk_manager;
+  }
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, HugePagesTest) {
+  const std::string db_name = "bpm_huge_pages_test.db";
+  const size_t buffer_pool_size = 2 * HUGE_PAGE_SIZE / PAGE_SIZE;  // a huge page for each instance
+  const int num_pages = 64;
+  // reserved huge pages are only taken if the system has some left
+  size_t free_huge_pages = 0;
+  std::ifstream meminfo("/proc/meminfo");
+  for (std::string key; meminfo >> key;) {
+    if (key == "HugePages_Free:") {
+      meminfo >> free_huge_pages;
+      break;
+    }
+  }
+  for (bool huge_pages : {false, true}) {
+    remove(db_name.c_str());
+    auto *disk_manager = new DiskManager(db_name);
+    auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, 2, ReplacerType::LRU, huge_pages);
+    // Scenario: huge pages are off unless asked for, and without reserved ones the pool falls back to normal pages.
+    if (!huge_pages || free_huge_pages < 2) {
+      EXPECT_FALSE(bpm->IsHugePageBacked());
+    }
+    // Scenario: either way the frames are page aligned and pages are written and read back.
+    for (int i = 0; i < num_pages; i++) {
+      page_id_t page_id;
+      auto *page = bpm->NewPage(page_id);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ(0, reinterpret_cast<uintptr_t>(page->GetData()) % PAGE_SIZE);
+      snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+      bpm->UnpinPage(page_id, true);
+    }
+    bpm->FlushAllPages();
+    for (int i = 0; i < num_pages; i++) {
+      auto *page = bpm->FetchPage(i);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ("page " + std::to_string(i), std::string(page->GetData()));
+      bpm->UnpinPage(i, false);
+    }
+    delete bpm;
+    delete disk_manager;
+  }
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, CorruptPageTest) {
+  const std::string db_name = "bpm_corrupt_page_test.db";
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(4, disk_manager);
+  for (int i = 0; i < 2; i++) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+    bpm->UnpinPage(page_id, true);
+  }
+  delete bpm;
+  delete disk_manager;
+  {
+    std::fstream file(db_name, std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(2 * PAGE_SIZE + 1);  // logical page 0
+    file.put('X');
+  }
+  // Scenario: a corrupted page is not handed out and its frame can be reused.
+  disk_manager = new DiskManager(db_name);
+  bpm = new BufferPoolManager(1, disk_manager);
+  EXPECT_EQ(nullptr, bpm->FetchPage(0));
+  auto *page = bpm->FetchPage(1);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ("page 1", std::string(page->GetData()));
+  bpm->UnpinPage(1, false);
+  EXPECT_EQ(1, disk_manager->GetStats().checksum_failures_);
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
@@ -0,0 +1,104 @@
+#include "buffer/lru_k_replacer.h"
+#include "gtest/gtest.h"
+
+TEST(LRUKReplacerTest, SampleTest) {
+  LRUKReplacer lru_k_replacer(7, 2);
+
+  // Scenario: frames 1 to 6 are read once, frame 1 is read again later.
+  for (int i = 1; i <= 6; i++) {
+    lru_k_replacer.Pin(i);
+    lru_k_replacer.Unpin(i);
+  }
+  lru_k_replacer.Pin(1);
+  lru_k_replacer.Unpin(1);
+  EXPECT_EQ(6, lru_k_replacer.Size());
+
+  // Scenario: frames seen only once have infinite backward distance and go first, oldest first.
+  int value;
+  lru_k_replacer.Victim(&value);
+  EXPECT_EQ(2, value);
+  lru_k_replacer.Victim(&value);
+  EXPECT_EQ(3, value);
+  lru_k_replacer.Victim(&value);
+  EXPECT_EQ(4, value);
+
+  // Scenario: pinned frames cannot be victims.
+  lru_k_replacer.Pin(3);
+  lru_k_replacer.Pin(5);
+  EXPECT_EQ(2, lru_k_replacer.Size());
+
+  // Scenario: 5 now has two accesses, 6 still one, 1 has two accesses older than those of 5.
+  lru_k_replacer.Unpin(5);
+  lru_k_replacer.Victim(&value);
+  EXPECT_EQ(6, value);
+  lru_k_replacer.Victim(&value);
+  EXPECT_EQ(1, value);
+  lru_k_replacer.Victim(&value);
+  EXPECT_EQ(5, value);
+  EXPECT_FALSE(lru_k_replacer.Victim(&value));
+}
+
+TEST(LRUKReplacerTest, ScanResistanceTest) {
+  LRUKReplacer lru_k_replacer(10, 2);
+
+  // Scenario: frames 0 and 1 are hot, e.g. B+ tree root and internal page.
+  for (int round = 0; round < 3; round++) {
+    lru_k_replacer.Pin(0);
+    lru_k_replacer.Unpin(0);
+    lru_k_replacer.Pin(1);
+    lru_k_replacer.Unpin(1);
+  }
+  // Scenario: a scan touches frames 2 to 9, reading each one many times in a row.
+  for (int i = 2; i < 10; i++) {
+    for (int tuple = 0; tuple < 5; tuple++) {
+      lru_k_replacer.Pin(i);
+      lru_k_replacer.Unpin(i);
+    }
+  }
+  // Scenario: every scanned frame is evicted before the hot ones.
+  int value;
+  for (int i = 2; i < 10; i++) {
+    ASSERT_TRUE(lru_k_replacer.Victim(&value));
+    EXPECT_EQ(i, value);
+  }
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(0, value);
+
+  // Scenario: a removed frame forgets its history.
+  lru_k_replacer.Remove(1);
+  EXPECT_EQ(0, lru_k_replacer.Size());
+  lru_k_replacer.Pin(1);
+  lru_k_replacer.Unpin(1);
+  lru_k_replacer.Pin(2);
+  lru_k_replacer.Unpin(2);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(1, value);
+}
+
+TEST(LRUKReplacerTest, PrefetchTest) {
+  LRUKReplacer lru_k_replacer(10, 2);
+
+  // Scenario: frames 0 and 9 are hot, frames 1 to 3 are brought in by read-ahead without being pinned.
+  for (int round = 0; round < 2; round++) {
+    lru_k_replacer.Pin(0);
+    lru_k_replacer.Unpin(0);
+    lru_k_replacer.Pin(9);
+    lru_k_replacer.Unpin(9);
+  }
+  for (int i = 1; i <= 3; i++) {
+    lru_k_replacer.Unpin(i);
+  }
+  // Scenario: the scan then reads each prefetched frame once, which is still their first access.
+  for (int i = 1; i <= 3; i++) {
+    lru_k_replacer.Pin(i);
+    lru_k_replacer.Unpin(i);
+  }
+  EXPECT_EQ(5, lru_k_replacer.Size());
+  int value;
+  for (int i = 1; i <= 3; i++) {
+    ASSERT_TRUE(lru_k_replacer.Victim(&value));
+    EXPECT_EQ(i, value);
+  }
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(0, value);
+}
@@ -57,6 +57,16 @@ TEST(CatalogTest, CatalogTableTest) {
   ASSERT_EQ(table_info, table_info_02);
   auto *table_heap = table_info->GetTableHeap();
   ASSERT_TRUE(table_heap != nullptr);
+  TableInfo *pax_info = nullptr;
+  catalog_01->CreateTable("table-pax", schema.get(), &txn, pax_info, TableLayout::PAX);
+  ASSERT_EQ(TableLayout::PAX, pax_info->GetTableHeap()->GetLayout());
+  TableInfo *dict_info = nullptr;
+  columns[1]->SetDictionaryEncoded(true);
+  catalog_01->CreateTable("table-dict", schema.get(), &txn, dict_info);
+  page_id_t dictionary_page_id = dict_info->GetTableHeap()->GetDictionaryPageId();
+  ASSERT_NE(INVALID_PAGE_ID, dictionary_page_id);
+  page_id_t zone_map_page_id = dict_info->GetTableHeap()->GetZoneMapPageId();
+  ASSERT_NE(INVALID_PAGE_ID, zone_map_page_id);
   delete db_01;
   /** Stage 2: Testing catalog loading */
   auto db_02 = new DBStorageEngine(db_file_name, false);
@@ -64,6 +74,13 @@ TEST(CatalogTest, CatalogTableTest) {
   TableInfo *table_info_03 = nullptr;
   ASSERT_EQ(DB_TABLE_NOT_EXIST, catalog_02->GetTable("table-2", table_info_03));
   ASSERT_EQ(DB_SUCCESS, catalog_02->GetTable("table-1", table_info_03));
+  ASSERT_EQ(TableLayout::ROW, table_info_03->GetTableHeap()->GetLayout());
+  ASSERT_EQ(DB_SUCCESS, catalog_02->GetTable("table-pax", table_info_03));
+  ASSERT_EQ(TableLayout::PAX, table_info_03->GetTableHeap()->GetLayout());
+  ASSERT_EQ(DB_SUCCESS, catalog_02->GetTable("table-dict", table_info_03));
+  ASSERT_TRUE(table_info_03->GetSchema()->GetColumn(1)->IsDictionaryEncoded());
+  ASSERT_EQ(dictionary_page_id, table_info_03->GetTableHeap()->GetDictionaryPageId());
+  ASSERT_EQ(zone_map_page_id, table_info_03->GetTableHeap()->GetZoneMapPageId());
   delete db_02;
 }
 
@@ -1,13 +1,17 @@
 //
 // Created by njz on 2023/1/26.
 //
+#include "executor/executors/seq_scan_executor.h"
 #include "executor/plans/delete_plan.h"
 #include "executor/plans/insert_plan.h"
 #include "executor/plans/seq_scan_plan.h"
 #include "executor/plans/update_plan.h"
 #include "executor/plans/values_plan.h"
+#include "planner/expressions/logic_expression.h"
 #include "executor_test_util.h"  // NOLINT
 
+#include <fstream>
+
 // SELECT id FROM table-1 WHERE id < 500
 TEST_F(ExecutorTest, SimpleSeqScanTest) {
   // Construct query plan
@@ -155,3 +159,98 @@ TEST_F(ExecutorTest, SimpleUpdateTest) {
     ASSERT_TRUE(row.GetField(1)->CompareEquals(Field(kTypeChar, const_cast<char *>("minisql"), 7, false)));
   }
 }
+
+// SELECT id, name FROM table-1 WHERE account < 0 OR id >= 9000, on the calling thread and on scan workers
+TEST_F(ExecutorTest, ParallelSeqScanTest) {
+  TableInfo *table_info;
+  GetExecutorContext()->GetCatalog()->GetTable("table-1", table_info);
+  TableHeap *table_heap = table_info->GetTableHeap();
+  char characters[64];
+  memset(characters, 'x', sizeof(characters));
+  for (int i = 1000; i < 10000; i++) {
+    Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, characters, 64, true),
+                  Field(TypeId::kTypeFloat, static_cast<float>(i % 7) - 3.f)};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+  }
+  ASSERT_GE(table_heap->GetPageCount(), PARALLEL_SCAN_MIN_PAGES);
+  const Schema *schema = table_info->GetSchema();
+  auto col_id = MakeColumnValueExpression(*schema, 0, "id");
+  auto col_name = MakeColumnValueExpression(*schema, 0, "name");
+  auto col_account = MakeColumnValueExpression(*schema, 0, "account");
+  auto negative = MakeComparisonExpression(col_account, MakeConstantValueExpression(Field(kTypeFloat, 0.f)), "<");
+  auto last = MakeComparisonExpression(col_id, MakeConstantValueExpression(Field(kTypeInt, 9000)), ">=");
+  auto predicate = std::make_shared<LogicExpression>(negative, last, LogicType::Or);
+  auto out_schema = MakeOutputSchema({{"id", col_id}, {"name", col_name}});
+  auto plan = make_shared<SeqScanPlanNode>(out_schema, table_info->GetTableName(), predicate);
+
+  GetExecutorContext()->SetScanWorkers(1);
+  std::vector<Row> serial{};
+  ASSERT_EQ(DB_SUCCESS, GetExecutionEngine()->ExecutePlan(plan, &serial, GetTxn(), GetExecutorContext()));
+  GetExecutorContext()->SetScanWorkers(4);
+  std::vector<Row> parallel{};
+  ASSERT_EQ(DB_SUCCESS, GetExecutionEngine()->ExecutePlan(plan, &parallel, GetTxn(), GetExecutorContext()));
+
+  // Verify: the workers return the same rows in the same order
+  ASSERT_GT(serial.size(), 1000);
+  ASSERT_EQ(serial.size(), parallel.size());
+  for (size_t i = 0; i < serial.size(); i++) {
+    ASSERT_EQ(serial[i].GetRowId().Get(), parallel[i].GetRowId().Get());
+    ASSERT_TRUE(serial[i].GetField(0)->CompareEquals(*parallel[i].GetField(0)));
+    ASSERT_TRUE(serial[i].GetField(1)->CompareEquals(*parallel[i].GetField(1)));
+  }
+  // Verify: scans open at the same time share the scan pool, as the two sides of a join do
+  SeqScanExecutor outer(GetExecutorContext(), plan.get());
+  SeqScanExecutor inner(GetExecutorContext(), plan.get());
+  outer.Init();
+  inner.Init();
+  Row outer_row, inner_row;
+  RowId outer_rid, inner_rid;
+  for (size_t i = 0; i < serial.size(); i++) {
+    ASSERT_TRUE(outer.Next(&outer_row, &outer_rid));
+    ASSERT_TRUE(inner.Next(&inner_row, &inner_rid));
+    ASSERT_EQ(serial[i].GetRowId().Get(), outer_rid.Get());
+    ASSERT_EQ(serial[i].GetRowId().Get(), inner_rid.Get());
+  }
+  EXPECT_FALSE(outer.Next(&outer_row, &outer_rid));
+  EXPECT_FALSE(inner.Next(&inner_row, &inner_rid));
+}
+
+TEST_F(ExecutorTest, UnreadablePageScanTest) {
+  TableInfo *table_info;
+  GetExecutorContext()->GetCatalog()->GetTable("table-1", table_info);
+  TableHeap *table_heap = table_info->GetTableHeap();
+  char characters[64];
+  memset(characters, 'x', sizeof(characters));
+  for (int i = 1000; i < 10000; i++) {
+    Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, characters, 64, true),
+                  Field(TypeId::kTypeFloat, 0.f)};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+  }
+  std::vector<page_id_t> pages = table_heap->GetPageIds();
+  ASSERT_GE(pages.size(), PARALLEL_SCAN_MIN_PAGES);
+  page_id_t corrupt_page_id = pages[pages.size() / 2];
+  ASSERT_LT(corrupt_page_id, static_cast<page_id_t>(DiskManager::BITMAP_SIZE));
+  std::string db_file_name = GetStorageEngine()->db_file_name_;
+  CloseDatabase();
+  {
+    std::fstream file(db_file_name, std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp((corrupt_page_id + 2) * PAGE_SIZE + 100);  // after the meta page and the bitmap page
+    file.put('X');
+  }
+  OpenDatabase();
+  GetExecutorContext()->GetCatalog()->GetTable("table-1", table_info);
+  const Schema *schema = table_info->GetSchema();
+  auto col_id = MakeColumnValueExpression(*schema, 0, "id");
+  auto out_schema = MakeOutputSchema({{"id", col_id}});
+  auto plan = make_shared<SeqScanPlanNode>(out_schema, table_info->GetTableName(), nullptr);
+
+  // Verify: serial and parallel scans both fail on the page instead of returning the rows of the other pages
+  for (size_t workers : {1, 4}) {
+    GetExecutorContext()->SetScanWorkers(workers);
+    std::vector<Row> result_set{};
+    EXPECT_EQ(DB_FAILED, GetExecutionEngine()->ExecutePlan(plan, &result_set, GetTxn(), GetExecutorContext()));
+    EXPECT_TRUE(result_set.empty());
+  }
+}
@@ -58,7 +58,7 @@ class ExecutorTest : public ::testing::Test {
       delete[] characters;
     }
     // Create an executor context for our executors
-    exec_ctx_ = std::make_unique<ExecuteContext>(txn_, db_test_->catalog_mgr_, db_test_->bpm_);
+    exec_ctx_ = db_test_->MakeExecuteContext(txn_);
 
     // Construct the executor engine for the test
     execution_engine_ = std::make_unique<ExecuteEngine>();
@@ -67,6 +67,22 @@ class ExecutorTest : public ::testing::Test {
   /** Called after every executor test. */
   void TearDown() override { delete db_test_; };
 
+  /** Close the database, its file can then be changed before OpenDatabase. */
+  void CloseDatabase() {
+    exec_ctx_.reset();
+    delete db_test_;
+    db_test_ = nullptr;
+  }
+
+  /** Open the database closed by CloseDatabase again from its file. */
+  void OpenDatabase() {
+    db_test_ = new DBStorageEngine("executor_test.db", false);
+    exec_ctx_ = db_test_->MakeExecuteContext(txn_);
+  }
+
+  /** @return The storage engine of the test database. */
+  DBStorageEngine *GetStorageEngine() { return db_test_; }
+
   /** @return The executor context for our test instance. */
   ExecuteContext *GetExecutorContext() { return exec_ctx_.get(); }
 
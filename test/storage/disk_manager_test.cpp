@@ -1,8 +1,20 @@
 #include "storage/disk_manager.h"
 
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <fstream>
+#include <random>
+#include <string>
+#include <thread>
 #include <unordered_set>
+#include <vector>
 
+#include "common/crc32c.h"
 #include "gtest/gtest.h"
+#include "storage/io_uring_queue.h"
 
 TEST(DiskManagerTest, BitMapPageTest) {
   const size_t size = 512;
@@ -56,4 +68,394 @@ TEST(DiskManagerTest, FreePageAllocationTest) {
   EXPECT_EQ(DiskManager::BITMAP_SIZE - 2, meta_page->GetExtentUsedPage(0));
   EXPECT_EQ(DiskManager::BITMAP_SIZE - 3, meta_page->GetExtentUsedPage(1));
   remove(db_name.c_str());
-}
\ No newline at end of file
+}
+
+TEST(DiskManagerTest, ConcurrentPageIOTest) {
+  std::string db_name = "disk_io_test.db";
+  remove(db_name.c_str());
+  const int num_threads = 4;
+  const int pages_per_thread = 64;
+  auto *disk_mgr = new DiskManager(db_name);
+  for (int i = 0; i < num_threads * pages_per_thread; i++) {
+    ASSERT_EQ(i, disk_mgr->AllocatePage());
+  }
+  // Scenario: threads write and read back disjoint pages at the same time.
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([disk_mgr, t] {
+      char data[PAGE_SIZE];
+      for (int i = t; i < num_threads * pages_per_thread; i += num_threads) {
+        memset(data, 0, PAGE_SIZE);
+        snprintf(data, PAGE_SIZE, "page-%d", i);
+        disk_mgr->WritePage(i, data);
+      }
+      for (int i = t; i < num_threads * pages_per_thread; i += num_threads) {
+        disk_mgr->ReadPage(i, data);
+        EXPECT_EQ("page-" + std::to_string(i), std::string(data));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  // Scenario: a page never written reads as zeros, everything survives a reopen.
+  char data[PAGE_SIZE];
+  disk_mgr->ReadPage(num_threads * pages_per_thread + 10, data);
+  EXPECT_EQ(0, data[0]);
+  delete disk_mgr;
+  disk_mgr = new DiskManager(db_name);
+  DiskFileMetaPage *meta_page = reinterpret_cast<DiskFileMetaPage *>(disk_mgr->GetMetaData());
+  EXPECT_EQ(num_threads * pages_per_thread, meta_page->GetAllocatedPages());
+  for (int i = 0; i < num_threads * pages_per_thread; i++) {
+    disk_mgr->ReadPage(i, data);
+    EXPECT_EQ("page-" + std::to_string(i), std::string(data));
+  }
+  delete disk_mgr;
+  remove(db_name.c_str());
+}
+
+TEST(DiskManagerTest, BatchIOTest) {
+  std::string db_name = "disk_batch_io_test.db";
+  for (auto backend : {IOBackend::SYNC, IOBackend::IO_URING}) {
+    remove(db_name.c_str());
+    // io_uring may be unavailable, the disk manager then falls back to synchronous I/O with the same results
+    auto *disk_mgr = new DiskManager(db_name, backend);
+    const int num_pages = 200;
+    std::vector<std::vector<char>> buffers(num_pages, std::vector<char>(PAGE_SIZE));
+    std::vector<std::pair<page_id_t, char *>> writes;
+    for (int i = 0; i < num_pages; i++) {
+      ASSERT_EQ(i, disk_mgr->AllocatePage());
+      snprintf(buffers[i].data(), PAGE_SIZE, "page-%d", i);
+      // leave out every seventh page so that the batch has several runs
+      if (i % 7 != 3) writes.emplace_back(num_pages - 1 - i, buffers[num_pages - 1 - i].data());
+    }
+    disk_mgr->WritePages(writes);
+    // Scenario: read everything back with one batch, including pages beyond the end of the file.
+    std::vector<std::vector<char>> read_buffers(num_pages + 5, std::vector<char>(PAGE_SIZE, 'x'));
+    std::vector<std::pair<page_id_t, char *>> reads;
+    for (int i = 0; i < num_pages + 5; i++) {
+      reads.emplace_back(i, read_buffers[i].data());
+    }
+    EXPECT_TRUE(disk_mgr->ReadPages(reads).empty());
+    for (int i = 0; i < num_pages + 5; i++) {
+      int written = num_pages - 1 - i;
+      if (i < num_pages && written % 7 != 3) {
+        EXPECT_EQ("page-" + std::to_string(i), std::string(read_buffers[i].data()));
+      } else {
+        EXPECT_EQ(0, read_buffers[i][0]);
+        EXPECT_EQ(0, read_buffers[i][PAGE_SIZE - 1]);
+      }
+    }
+    delete disk_mgr;
+  }
+  remove(db_name.c_str());
+}
+
+/**
+ * IOUringQueue whose io_uring_enter fails from the fail_from-th call on, after the kernel took the queued entries.
+ * Unless every later call fails too, waiting for completions goes through.
+ */
+class FailingIOUringQueue : public IOUringQueue {
+ public:
+  FailingIOUringQueue(unsigned entries, int fail_from, bool fail_always)
+      : IOUringQueue(entries), fail_from_(fail_from), fail_always_(fail_always) {}
+
+ protected:
+  int Enter(unsigned to_submit, unsigned min_complete) override {
+    int call = calls_++;
+    if (call < fail_from_ || (call > fail_from_ && !fail_always_)) return IOUringQueue::Enter(to_submit, min_complete);
+    if (to_submit > 0) IOUringQueue::Enter(to_submit, 0);
+    errno = EIO;
+    return -1;
+  }
+
+ private:
+  int calls_{0};
+  int fail_from_;
+  bool fail_always_;
+};
+
+TEST(DiskManagerTest, IOUringFailureTest) {
+  if (!IOUringQueue(8).IsValid()) GTEST_SKIP() << "io_uring is not available";
+  std::string file_name = "disk_io_uring_failure_test.db";
+  remove(file_name.c_str());
+  int fd = open(file_name.c_str(), O_RDWR | O_CREAT, 0644);
+  ASSERT_GE(fd, 0);
+  const int num_requests = 20;
+  std::vector<std::vector<char>> buffers(num_requests, std::vector<char>(PAGE_SIZE));
+  std::vector<struct iovec> iov(num_requests);
+  auto make_requests = [&](int count) {
+    std::vector<IORequest> requests;
+    for (int i = 0; i < count; i++) {
+      snprintf(buffers[i].data(), PAGE_SIZE, "request-%d", i);
+      iov[i] = {buffers[i].data(), PAGE_SIZE};
+      requests.push_back({true, fd, &iov[i], 1, static_cast<uint64_t>(i) * PAGE_SIZE});
+    }
+    return requests;
+  };
+  // Scenario: the call fails after the kernel took a ringful of requests, those are waited for and the rest not run.
+  FailingIOUringQueue queue(4, 1, false);
+  auto requests = make_requests(num_requests);
+  EXPECT_FALSE(queue.Run(requests));
+  EXPECT_TRUE(queue.IsValid());
+  int completed = 0;
+  for (auto &request : requests) {
+    ASSERT_TRUE(request.result_ == PAGE_SIZE || request.result_ == -EIO);
+    completed += request.result_ == PAGE_SIZE;
+  }
+  EXPECT_GT(completed, 0);
+  EXPECT_LT(completed, num_requests);
+  // Scenario: no completion of the failed batch is left behind for the next one.
+  requests = make_requests(2);
+  EXPECT_TRUE(queue.Run(requests));
+  EXPECT_EQ(PAGE_SIZE, requests[0].result_);
+  EXPECT_EQ(PAGE_SIZE, requests[1].result_);
+  // Scenario: a read that never completes can not be reaped, the ring is torn down and the read given up.
+  int pipe_fds[2];
+  ASSERT_EQ(0, pipe(pipe_fds));
+  static char pipe_buffer[PAGE_SIZE];  // the kernel may still write it after Run gave the read up
+  struct iovec pipe_iov = {pipe_buffer, PAGE_SIZE};
+  FailingIOUringQueue broken_queue(4, 0, true);
+  std::vector<IORequest> reads{{false, pipe_fds[0], &pipe_iov, 1, 0}};
+  EXPECT_FALSE(broken_queue.Run(reads));
+  EXPECT_EQ(-EINPROGRESS, reads[0].result_);
+  EXPECT_FALSE(broken_queue.IsValid());
+  EXPECT_FALSE(broken_queue.Run(requests));
+  EXPECT_EQ(-EIO, requests[0].result_);
+  close(pipe_fds[0]);
+  close(pipe_fds[1]);
+  close(fd);
+  remove(file_name.c_str());
+}
+
+TEST(DiskManagerTest, BitmapFindFirstFreeTest) {
+  const size_t size = 512;
+  char buf[size];
+  memset(buf, 0, size);
+  auto *bitmap = reinterpret_cast<BitmapPage<size> *>(buf);
+  auto num_pages = bitmap->GetMaxSupportedSize();
+  uint32_t ofs;
+  for (uint32_t i = 0; i < num_pages; i++) {
+    ASSERT_TRUE(bitmap->AllocatePage(ofs));
+    ASSERT_EQ(i, ofs);
+  }
+  // Scenario: holes in different words and bit positions are found lowest first.
+  for (uint32_t hole : {1000u, 63u, 64u, 7u, 3000u}) {
+    ASSERT_TRUE(bitmap->DeAllocatePage(hole));
+  }
+  for (uint32_t hole : {7u, 63u, 64u, 1000u, 3000u}) {
+    ASSERT_TRUE(bitmap->AllocatePage(ofs));
+    EXPECT_EQ(hole, ofs);
+  }
+  ASSERT_FALSE(bitmap->AllocatePage(ofs));
+}
+
+TEST(DiskManagerTest, AllocationPersistenceTest) {
+  std::string db_name = "disk_alloc_test.db";
+  remove(db_name.c_str());
+  auto *disk_mgr = new DiskManager(db_name);
+  for (uint32_t i = 0; i < DiskManager::BITMAP_SIZE + 10; i++) {
+    ASSERT_EQ(i, disk_mgr->AllocatePage());
+  }
+  disk_mgr->DeAllocatePage(5);
+  disk_mgr->DeAllocatePage(DiskManager::BITMAP_SIZE + 2);
+  disk_mgr->DeAllocatePage(5);  // freeing twice changes nothing
+  // Scenario: cached bitmaps are written back on close and the free extents are rebuilt on open.
+  delete disk_mgr;
+  disk_mgr = new DiskManager(db_name);
+  DiskFileMetaPage *meta_page = reinterpret_cast<DiskFileMetaPage *>(disk_mgr->GetMetaData());
+  EXPECT_EQ(DiskManager::BITMAP_SIZE + 8, meta_page->GetAllocatedPages());
+  EXPECT_TRUE(disk_mgr->IsPageFree(5));
+  EXPECT_FALSE(disk_mgr->IsPageFree(6));
+  EXPECT_TRUE(disk_mgr->IsPageFree(DiskManager::BITMAP_SIZE + 2));
+  EXPECT_TRUE(disk_mgr->IsPageFree(10 * DiskManager::BITMAP_SIZE));
+  EXPECT_EQ(5, disk_mgr->AllocatePage());
+  EXPECT_EQ(DiskManager::BITMAP_SIZE + 2, disk_mgr->AllocatePage());
+  EXPECT_EQ(DiskManager::BITMAP_SIZE + 10, disk_mgr->AllocatePage());
+  delete disk_mgr;
+  remove(db_name.c_str());
+}
+
+TEST(DiskManagerTest, ExtentReservationTest) {
+  std::string db_name = "disk_reservation_test.db";
+  remove(db_name.c_str());
+  DiskManager disk_mgr(db_name);
+  const page_id_t run = EXTENT_RESERVATION_SIZE;
+  ASSERT_EQ(0, disk_mgr.AllocatePage());
+  ExtentReservation table, index, heap;
+  for (page_id_t i = 0; i < run; i++) {
+    ASSERT_EQ(run + i, disk_mgr.AllocatePage(&table));
+  }
+  ASSERT_EQ(2 * run, disk_mgr.AllocatePage(&index));
+  // Scenario: the run after a used up one belongs to someone else, take the next free run.
+  ASSERT_EQ(3 * run, disk_mgr.AllocatePage(&table));
+  // Scenario: other allocations stay out of reserved runs.
+  for (page_id_t i = 1; i < run; i++) {
+    ASSERT_EQ(i, disk_mgr.AllocatePage());
+  }
+  ASSERT_EQ(4 * run, disk_mgr.AllocatePage());
+  ASSERT_EQ(3 * run + 1, disk_mgr.AllocatePage(&table));
+  // Scenario: released pages go back to everyone.
+  disk_mgr.ReleaseReservation(&table);
+  ASSERT_EQ(3 * run + 2, disk_mgr.AllocatePage());
+  disk_mgr.ReleaseReservation(&index);
+  ASSERT_EQ(2 * run + 1, disk_mgr.AllocatePage());
+  // Scenario: a growing object continues with the run right after its last one.
+  for (page_id_t i = 0; i <= run; i++) {
+    ASSERT_EQ(5 * run + i, disk_mgr.AllocatePage(&heap));
+  }
+  disk_mgr.ReleaseReservation(&heap);
+  disk_mgr.Close();
+  remove(db_name.c_str());
+}
+
+TEST(DiskManagerTest, LargeFileTest) {
+  std::string db_name = "disk_large_file_test.db";
+  remove(db_name.c_str());
+  // logical ids whose physical pages lie just past 2 GB, past 4 GB and one extent further
+  const page_id_t past_2g = (2ULL << 30) / PAGE_SIZE;
+  const page_id_t past_4g = (4ULL << 30) / PAGE_SIZE;
+  const page_id_t next_extent = past_4g + static_cast<page_id_t>(DiskManager::BITMAP_SIZE);
+  const std::vector<page_id_t> page_ids = {past_2g, past_4g, next_extent};
+  char data[PAGE_SIZE], buf[PAGE_SIZE];
+  // Scenario: pages beyond the 32-bit offset range are written to a sparse file.
+  auto *disk_mgr = new DiskManager(db_name);
+  for (page_id_t page_id : page_ids) {
+    memset(data, 0, PAGE_SIZE);
+    snprintf(data, PAGE_SIZE, "page %d", page_id);
+    data[PAGE_SIZE - PAGE_CHECKSUM_SIZE - 1] = static_cast<char>(page_id);
+    disk_mgr->WritePage(page_id, data);
+  }
+  delete disk_mgr;
+  struct stat stat_buf;
+  ASSERT_EQ(0, stat(db_name.c_str(), &stat_buf));
+  EXPECT_GT(static_cast<uint64_t>(stat_buf.st_size), 4ULL << 30);
+  // Scenario: after reopening, each page reads back from its own offset and the holes read as zeros.
+  disk_mgr = new DiskManager(db_name);
+  for (page_id_t page_id : page_ids) {
+    memset(data, 0, PAGE_SIZE);
+    snprintf(data, PAGE_SIZE, "page %d", page_id);
+    data[PAGE_SIZE - PAGE_CHECKSUM_SIZE - 1] = static_cast<char>(page_id);
+    EXPECT_TRUE(disk_mgr->ReadPage(page_id, buf));
+    EXPECT_EQ(0, memcmp(data, buf, PAGE_SIZE - PAGE_CHECKSUM_SIZE));
+  }
+  memset(data, 0, PAGE_SIZE);
+  disk_mgr->ReadPage(past_4g - 1, buf);
+  EXPECT_EQ(0, memcmp(data, buf, PAGE_SIZE));
+  std::vector<std::pair<page_id_t, char *>> batch = {{past_4g, buf}};
+  disk_mgr->ReadPages(batch);
+  EXPECT_EQ(0, strcmp(buf, ("page " + std::to_string(past_4g)).c_str()));
+  delete disk_mgr;
+  remove(db_name.c_str());
+}
+
+TEST(DiskManagerTest, FileFormatTest) {
+  std::string db_name = "disk_format_test.db";
+  remove(db_name.c_str());
+  FILE *file = fopen(db_name.c_str(), "wb");
+  ASSERT_NE(nullptr, file);
+  char data[PAGE_SIZE];
+  memset(data, 0xff, PAGE_SIZE);
+  fwrite(data, 1, PAGE_SIZE, file);
+  fclose(file);
+  // Scenario: a file without the meta page magic is refused instead of being misread.
+  EXPECT_ANY_THROW(DiskManager disk_mgr(db_name));
+  remove(db_name.c_str());
+}
+
+TEST(DiskManagerTest, PageSizeTest) {
+  EXPECT_TRUE(DiskManager::IsValidPageSize(PAGE_SIZE));
+  EXPECT_TRUE(DiskManager::IsValidPageSize(16384));
+  EXPECT_TRUE(DiskManager::IsValidPageSize(MAX_PAGE_SIZE));
+  EXPECT_FALSE(DiskManager::IsValidPageSize(2048));
+  EXPECT_FALSE(DiskManager::IsValidPageSize(12288));
+  EXPECT_FALSE(DiskManager::IsValidPageSize(2 * MAX_PAGE_SIZE));
+  std::string db_name = "disk_page_size_test.db";
+  remove(db_name.c_str());
+  const uint32_t page_size = 16384;
+  std::vector<char> data(page_size), buf(page_size);
+  // Scenario: pages of a 16 KB database are written whole and at 16 KB offsets.
+  auto *disk_mgr = new DiskManager(db_name, IOBackend::SYNC, page_size);
+  ASSERT_EQ(page_size, disk_mgr->GetPageSize());
+  for (int i = 0; i < 3; i++) {
+    page_id_t page_id = disk_mgr->AllocatePage();
+    ASSERT_EQ(i, page_id);
+    memset(data.data(), 'a' + i, page_size);
+    disk_mgr->WritePage(page_id, data.data());
+  }
+  delete disk_mgr;
+  struct stat stat_buf;
+  ASSERT_EQ(0, stat(db_name.c_str(), &stat_buf));
+  EXPECT_EQ(5 * page_size, static_cast<uint64_t>(stat_buf.st_size));
+  disk_mgr = new DiskManager(db_name);
+  ASSERT_EQ(page_size, disk_mgr->GetPageSize());
+  EXPECT_EQ(3, reinterpret_cast<DiskFileMetaPage *>(disk_mgr->GetMetaData())->GetAllocatedPages());
+  for (int i = 0; i < 3; i++) {
+    memset(data.data(), 'a' + i, page_size);
+    EXPECT_TRUE(disk_mgr->ReadPage(i, buf.data()));
+    EXPECT_EQ(0, memcmp(data.data(), buf.data(), page_size - PAGE_CHECKSUM_SIZE));
+  }
+  delete disk_mgr;
+  remove(db_name.c_str());
+}
+
+TEST(DiskManagerTest, ChecksumTest) {
+  // Scenario: both implementations give the standard CRC32C, for every length.
+  EXPECT_EQ(0xE3069283, Crc32c("123456789", 9));
+  EXPECT_EQ(0xE3069283, Crc32cSoftware("123456789", 9));
+  std::mt19937 rng(42);
+  std::vector<char> random_data(PAGE_SIZE);
+  for (char &c : random_data) {
+    c = static_cast<char>(rng());
+  }
+  for (size_t size : {0, 1, 7, 8, 13, 100, PAGE_SIZE - PAGE_CHECKSUM_SIZE, PAGE_SIZE}) {
+    EXPECT_EQ(Crc32cSoftware(random_data.data(), size), Crc32c(random_data.data(), size));
+  }
+  std::string db_name = "disk_checksum_test.db";
+  remove(db_name.c_str());
+  char data[PAGE_SIZE], buf[PAGE_SIZE];
+  auto *disk_mgr = new DiskManager(db_name);
+  for (int i = 0; i < 3; i++) {
+    ASSERT_EQ(i, disk_mgr->AllocatePage());
+    memcpy(data, random_data.data(), PAGE_SIZE);
+    data[0] = static_cast<char>(i);
+    disk_mgr->WritePage(i, data);
+  }
+  // Scenario: a page allocated but never written reads as zeros and passes verification.
+  ASSERT_EQ(3, disk_mgr->AllocatePage());
+  EXPECT_TRUE(disk_mgr->ReadPage(3, buf));
+  delete disk_mgr;
+  // Scenario: one flipped byte is detected on read, by single and batch reads alike.
+  {
+    std::fstream file(db_name, std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(3 * PAGE_SIZE + 100);  // logical page 1, after the meta page and the bitmap page
+    file.put(static_cast<char>(~random_data[100]));
+  }
+  disk_mgr = new DiskManager(db_name);
+  EXPECT_TRUE(disk_mgr->ReadPage(0, buf));
+  EXPECT_FALSE(disk_mgr->ReadPage(1, buf));
+  EXPECT_TRUE(disk_mgr->ReadPage(2, buf));
+  std::vector<std::pair<page_id_t, char *>> batch = {{2, data}, {1, buf}};
+  EXPECT_EQ(std::vector<page_id_t>{1}, disk_mgr->ReadPages(batch));
+  DiskStats stats = disk_mgr->GetStats();
+  EXPECT_EQ(2, stats.checksum_failures_);
+  EXPECT_GT(stats.checksum_verify_ns_, 0);
+  // Scenario: a page that changes while it is written, as a frame flushed without its latch, still gets a matching
+  // checksum, and the written buffer is left as it was.
+  std::vector<char> frame(random_data);
+  std::atomic<bool> done{false};
+  std::thread changer([&] {
+    for (uint8_t k = 0; !done.load(); k++) {
+      reinterpret_cast<volatile char *>(frame.data())[k % 64] = static_cast<char>(k);
+    }
+  });
+  for (int i = 0; i < 200; i++) {
+    disk_mgr->WritePage(0, frame.data());
+    EXPECT_TRUE(disk_mgr->ReadPage(0, buf));
+  }
+  done = true;
+  changer.join();
+  EXPECT_EQ(0, memcmp(random_data.data() + 64, frame.data() + 64, PAGE_SIZE - 64));
+  delete disk_mgr;
+  remove(db_name.c_str());
+}
@@ -1,6 +1,14 @@
 #include "storage/table_heap.h"
 
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
 #include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "common/instance.h"
@@ -12,6 +20,64 @@
 static string db_file_name = "table_heap_test.db";
 using Fields = std::vector<Field>;
 
+/**
+ * A table heap on a database file of its own with a 64 frame buffer pool. The file is removed again when the
+ * environment is destroyed.
+ */
+class TableHeapTestEnv {
+ public:
+  explicit TableHeapTestEnv(std::string db_name, const std::vector<Column *> &columns = DefaultColumns(),
+                            TableLayout layout = TableLayout::ROW, size_t pool_size = 64)
+      : db_name_(std::move(db_name)) {
+    remove(db_name_.c_str());
+    disk_mgr_ = new DiskManager(db_name_);
+    bpm_ = new BufferPoolManager(pool_size, disk_mgr_);
+    schema_ = std::make_shared<Schema>(columns);
+    table_heap_ = TableHeap::Create(bpm_, schema_.get(), nullptr, nullptr, nullptr, layout);
+  }
+
+  ~TableHeapTestEnv() {
+    delete table_heap_;
+    delete bpm_;
+    delete disk_mgr_;
+    remove(db_name_.c_str());
+  }
+
+  /** @return the columns most tests use, an int id and a char(64) name */
+  static std::vector<Column *> DefaultColumns() {
+    return {new Column("id", TypeId::kTypeInt, 0, false, false),
+            new Column("name", TypeId::kTypeChar, 64, 1, true, false)};
+  }
+
+  /**
+   * @return a second TableHeap on the pages of table_heap_, opened from the ids kept in the table metadata while
+   * table_heap_ is still open, as after a crash
+   */
+  TableHeap *Open() const {
+    return TableHeap::Create(bpm_, table_heap_->GetFirstPageId(), table_heap_->GetFreeSpaceMapPageId(), schema_.get(),
+                             nullptr, nullptr, table_heap_->GetLayout(), table_heap_->GetDictionaryPageId(),
+                             table_heap_->GetZoneMapPageId());
+  }
+
+  /** Close table_heap_ and open it again from the same ids, as after a restart. */
+  void Reopen() {
+    page_id_t first_page_id = table_heap_->GetFirstPageId();
+    page_id_t map_page_id = table_heap_->GetFreeSpaceMapPageId();
+    TableLayout layout = table_heap_->GetLayout();
+    page_id_t dictionary_page_id = table_heap_->GetDictionaryPageId();
+    page_id_t zone_map_page_id = table_heap_->GetZoneMapPageId();
+    delete table_heap_;
+    table_heap_ = TableHeap::Create(bpm_, first_page_id, map_page_id, schema_.get(), nullptr, nullptr, layout,
+                                    dictionary_page_id, zone_map_page_id);
+  }
+
+  std::string db_name_;
+  DiskManager *disk_mgr_;
+  BufferPoolManager *bpm_;
+  std::shared_ptr<Schema> schema_;
+  TableHeap *table_heap_;
+};
+
 TEST(TableHeapTest, TableHeapSampleTest) {
   // init testing instance
   auto disk_mgr_ = new DiskManager(db_file_name);
@@ -60,3 +126,756 @@ TEST(TableHeapTest, TableHeapSampleTest) {
   }
   ASSERT_EQ(size, 0);
 }
+
+TEST(TableHeapTest, LargePageTest) {
+  std::string db_name = "table_heap_large_page_test.db";
+  remove(db_name.c_str());
+  auto disk_mgr = new DiskManager(db_name, IOBackend::SYNC, MAX_PAGE_SIZE);
+  auto bpm = new BufferPoolManager(64, disk_mgr);
+  const int row_nums = 10000;
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  TableHeap *table_heap = TableHeap::Create(bpm, schema.get(), nullptr, nullptr, nullptr);
+  char characters[64];
+  memset(characters, 'x', sizeof(characters));
+  for (int i = 0; i < row_nums; i++) {
+    Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, characters, i % 64, true)};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+  }
+  // Scenario: a 64 KB page holds sixteen times the rows of a 4 KB page and every row is scanned once.
+  std::unordered_set<page_id_t> pages;
+  std::vector<bool> seen(row_nums, false);
+  int count = 0;
+  for (auto it = table_heap->Begin(nullptr); it != table_heap->End(); it++) {
+    int32_t id;
+    it->GetField(0)->SerializeTo(reinterpret_cast<char *>(&id));
+    ASSERT_TRUE(id >= 0 && id < row_nums && !seen[id]);
+    seen[id] = true;
+    pages.insert(it->GetRowId().GetPageId());
+    count++;
+  }
+  ASSERT_EQ(row_nums, count);
+  EXPECT_LE(pages.size(), static_cast<size_t>(row_nums * 120 / MAX_PAGE_SIZE + 1));
+  delete table_heap;
+  delete bpm;
+  delete disk_mgr;
+  // Scenario: the page size is read back from the meta page, whatever the caller asks for.
+  disk_mgr = new DiskManager(db_name);
+  EXPECT_EQ(static_cast<uint32_t>(MAX_PAGE_SIZE), disk_mgr->GetPageSize());
+  delete disk_mgr;
+  remove(db_name.c_str());
+}
+
+TEST(TableHeapTest, FreeSpaceMapTest) {
+  const int row_nums = 20000;
+  TableHeapTestEnv env("table_heap_free_space_map_test.db");
+  TableHeap *&table_heap = env.table_heap_;  // follows the heap across Reopen
+  BufferPoolManager *bpm = env.bpm_;
+  char characters[64];
+  memset(characters, 'x', sizeof(characters));
+  std::vector<RowId> rids;
+  for (int i = 0; i < row_nums; i++) {
+    Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, characters, 64, true)};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+    rids.push_back(row.GetRowId());
+  }
+  size_t pages = table_heap->GetPageCount();
+  ASSERT_GT(pages, 100);
+  // Scenario: an insert into a large table fetches a couple of pages, not the whole page chain.
+  BufferPoolStats before = bpm->GetStats();
+  for (int i = 0; i < 100; i++) {
+    Fields fields{Field(TypeId::kTypeInt, row_nums + i), Field(TypeId::kTypeChar, characters, 64, true)};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+  }
+  BufferPoolStats after = bpm->GetStats();
+  EXPECT_LE(after.hits_ + after.misses_ - before.hits_ - before.misses_, 100 * 3);
+  // Scenario: the space of deleted rows is found again, also after reopening the table.
+  page_id_t freed_page_id = rids[row_nums / 2].GetPageId();
+  for (auto &rid : rids) {
+    if (rid.GetPageId() == freed_page_id) {
+      ASSERT_TRUE(table_heap->MarkDelete(rid, nullptr));
+      table_heap->ApplyDelete(rid, nullptr);
+    }
+  }
+  pages = table_heap->GetPageCount();
+  env.Reopen();
+  EXPECT_EQ(pages, table_heap->GetPageCount());
+  Fields fields{Field(TypeId::kTypeInt, -1), Field(TypeId::kTypeChar, characters, 64, true)};
+  Row row(fields);
+  ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+  EXPECT_EQ(freed_page_id, row.GetRowId().GetPageId());
+  EXPECT_EQ(pages, table_heap->GetPageCount());
+}
+
+TEST(TableHeapTest, BatchInsertTest) {
+  const int row_nums = 5000;
+  TableHeapTestEnv env("table_heap_batch_insert_test.db");
+  TableHeap *table_heap = env.table_heap_;
+  BufferPoolManager *bpm = env.bpm_;
+  char characters[64];
+  memset(characters, 'x', sizeof(characters));
+  std::vector<Row> rows;
+  for (int i = 0; i < row_nums; i++) {
+    Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, characters, 1 + i % 64, true)};
+    rows.emplace_back(fields);
+  }
+  // Scenario: a batch pins every page it fills once instead of once per row.
+  BufferPoolStats before = bpm->GetStats();
+  std::vector<RowId> rids;
+  ASSERT_TRUE(table_heap->InsertTuples(rows, rids, nullptr));
+  BufferPoolStats after = bpm->GetStats();
+  ASSERT_EQ(row_nums, rids.size());
+  size_t pages = table_heap->GetPageCount();
+  EXPECT_LE(after.hits_ + after.misses_ - before.hits_ - before.misses_, pages * 3);
+  std::unordered_set<int64_t> distinct;
+  for (int i = 0; i < row_nums; i++) {
+    ASSERT_EQ(rids[i].Get(), rows[i].GetRowId().Get());
+    ASSERT_TRUE(distinct.insert(rids[i].Get()).second);
+    Row row(rids[i]);
+    ASSERT_TRUE(table_heap->GetTuple(&row, nullptr));
+    ASSERT_EQ(CmpBool::kTrue, row.GetField(0)->CompareEquals(Field(TypeId::kTypeInt, i)));
+  }
+  // Scenario: a batch with an oversized row is rejected before any row is inserted.
+  const uint32_t column_nums = PAGE_SIZE / sizeof(int32_t);  // ints can not be moved out of line
+  std::vector<Column *> large_columns;
+  for (uint32_t i = 0; i < column_nums; i++) {
+    large_columns.push_back(new Column("c" + std::to_string(i), TypeId::kTypeInt, i, false, false));
+  }
+  auto large_schema = std::make_shared<Schema>(large_columns);
+  TableHeap *large_heap = TableHeap::Create(bpm, large_schema.get(), nullptr, nullptr, nullptr);
+  std::vector<Row> large_rows;
+  Fields large_fields(column_nums, Field(TypeId::kTypeInt, 1));
+  large_rows.emplace_back(large_fields);
+  large_rows.emplace_back(large_fields);
+  rids.clear();
+  EXPECT_FALSE(large_heap->InsertTuples(large_rows, rids, nullptr));
+  EXPECT_TRUE(rids.empty());
+  delete large_heap;
+}
+
+TEST(TableHeapTest, IteratorFetchTest) {
+  const int row_nums = 5000;
+  TableHeapTestEnv env("table_heap_iterator_fetch_test.db");
+  TableHeap *table_heap = env.table_heap_;
+  BufferPoolManager *bpm = env.bpm_;
+  char characters[64];
+  memset(characters, 'x', sizeof(characters));
+  std::vector<RowId> rids;
+  for (int i = 0; i < row_nums; i++) {
+    Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, characters, 64, true)};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+    rids.push_back(row.GetRowId());
+  }
+  // Scenario: a page emptied by deletes does not end the scan early.
+  page_id_t emptied_page_id = rids[row_nums / 2].GetPageId();
+  int deleted = 0;
+  for (auto &rid : rids) {
+    if (rid.GetPageId() == emptied_page_id) {
+      ASSERT_TRUE(table_heap->MarkDelete(rid, nullptr));
+      table_heap->ApplyDelete(rid, nullptr);
+      deleted++;
+    }
+  }
+  // Scenario: a full scan fetches every page once instead of twice per tuple.
+  size_t pages = table_heap->GetPageCount();
+  BufferPoolStats before = bpm->GetStats();
+  int count = 0;
+  int32_t last_id = -1;
+  for (auto it = table_heap->Begin(nullptr); it != table_heap->End(); ++it) {
+    int32_t id;
+    it->GetField(0)->SerializeTo(reinterpret_cast<char *>(&id));
+    ASSERT_GT(id, last_id);
+    ASSERT_NE(emptied_page_id, it->GetRowId().GetPageId());
+    last_id = id;
+    count++;
+  }
+  BufferPoolStats after = bpm->GetStats();
+  EXPECT_EQ(row_nums - deleted, count);
+  EXPECT_LE(after.hits_ + after.misses_ - before.hits_ - before.misses_, pages);
+  // Scenario: a copy of an iterator advances on its own and every pin is released.
+  {
+    auto it = table_heap->Begin(nullptr);
+    auto copy = it;
+    ++copy;
+    EXPECT_NE(it->GetRowId().Get(), copy->GetRowId().Get());
+    auto old = copy++;
+    EXPECT_EQ(old->GetRowId().GetSlotNum() + 1, copy->GetRowId().GetSlotNum());
+  }
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+  // Scenario: a page that can not be fetched fails the scan instead of ending it like the last page would.
+  bpm->FlushAllPages();
+  {
+    std::vector<page_id_t> pinned;  // evicts every page of the table
+    page_id_t page_id;
+    while (bpm->NewPage(page_id) != nullptr) {
+      pinned.push_back(page_id);
+    }
+    for (auto id : pinned) {
+      bpm->UnpinPage(id, false);
+      bpm->DeletePage(id);
+    }
+  }
+  page_id_t corrupt_page_id = rids[row_nums * 3 / 4].GetPageId();
+  ASSERT_LT(corrupt_page_id, static_cast<page_id_t>(DiskManager::BITMAP_SIZE));
+  {
+    std::fstream file(env.db_name_, std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp((corrupt_page_id + 2) * PAGE_SIZE + 100);  // after the meta page and the bitmap page
+    file.put('X');
+  }
+  int scanned = 0;
+  EXPECT_THROW(
+      {
+        for (auto it = table_heap->Begin(nullptr); it != table_heap->End(); ++it) {
+          scanned++;
+        }
+      },
+      std::runtime_error);
+  EXPECT_GT(scanned, 0);
+  EXPECT_LT(scanned, row_nums - deleted);
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+}
+
+TEST(TableHeapTest, OverflowPageTest) {
+  const int row_nums = 50;
+  const uint32_t doc_len = 5 * PAGE_SIZE;
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("doc", TypeId::kTypeChar, doc_len, 1, true, false)};
+  TableHeapTestEnv env("table_heap_overflow_page_test.db", columns);
+  TableHeap *table_heap = env.table_heap_;
+  BufferPoolManager *bpm = env.bpm_;
+  std::vector<std::string> docs;
+  for (int i = 0; i < row_nums; i++) {
+    std::string doc(doc_len - i, static_cast<char>('a' + i % 26));
+    doc[i] = '#';
+    docs.push_back(doc);
+    Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, const_cast<char *>(doc.data()), doc.size(), true)};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+    // the caller keeps its inline value
+    ASSERT_FALSE(row.GetField(1)->IsExternal());
+  }
+  // Scenario: documents larger than a page are stored and the tuples stay small enough to share a page.
+  EXPECT_EQ(1, table_heap->GetPageCount());
+  // Scenario: a scan over the small column reads no overflow page.
+  bpm->FlushAllPages();
+  BufferPoolStats before = bpm->GetStats();
+  std::vector<page_id_t> overflow_pages;
+  int count = 0;
+  for (auto it = table_heap->Begin(nullptr); it != table_heap->End(); ++it) {
+    ASSERT_TRUE(it->GetField(1)->IsExternal());
+    ASSERT_EQ(doc_len - count, it->GetField(1)->GetLength());
+    overflow_pages.push_back(it->GetField(1)->GetExternalPageId());
+    count++;
+  }
+  BufferPoolStats after = bpm->GetStats();
+  EXPECT_EQ(row_nums, count);
+  EXPECT_EQ(1, after.hits_ + after.misses_ - before.hits_ - before.misses_);
+  // Scenario: the document is read when the column is needed.
+  for (int i = 0; i < row_nums; i++) {
+    Row row(RowId(table_heap->GetFirstPageId(), i));
+    ASSERT_TRUE(table_heap->GetTuple(&row, nullptr));
+    ASSERT_TRUE(table_heap->LoadExternalFields(row));
+    ASSERT_FALSE(row.GetField(1)->IsExternal());
+    ASSERT_EQ(docs[i], std::string(row.GetField(1)->GetData(), row.GetField(1)->GetLength()));
+  }
+  // Scenario: an update writes the new document and frees the old overflow pages, a delete frees them too.
+  RowId rid(table_heap->GetFirstPageId(), 0);
+  Fields fields{Field(TypeId::kTypeInt, 0), Field(TypeId::kTypeChar, const_cast<char *>(docs[1].data()), doc_len - 1, true)};
+  ASSERT_TRUE(table_heap->UpdateTuple(Row(fields), rid, nullptr));
+  EXPECT_TRUE(bpm->IsPageFree(overflow_pages[0]));
+  Row updated(rid);
+  ASSERT_TRUE(table_heap->GetTuple(&updated, nullptr));
+  ASSERT_TRUE(table_heap->LoadExternalFields(updated));
+  EXPECT_EQ(docs[1], std::string(updated.GetField(1)->GetData(), updated.GetField(1)->GetLength()));
+  rid = RowId(table_heap->GetFirstPageId(), 1);
+  ASSERT_TRUE(table_heap->MarkDelete(rid, nullptr));
+  table_heap->ApplyDelete(rid, nullptr);
+  EXPECT_TRUE(bpm->IsPageFree(overflow_pages[1]));
+  EXPECT_FALSE(bpm->IsPageFree(overflow_pages[2]));
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+}
+
+TEST(TableHeapTest, VacuumTest) {
+  const int row_nums = 5000;
+  TableHeapTestEnv env("table_heap_vacuum_test.db");
+  TableHeap *table_heap = env.table_heap_;
+  BufferPoolManager *bpm = env.bpm_;
+  char characters[64];
+  memset(characters, 'x', sizeof(characters));
+  std::vector<RowId> rids;
+  for (int i = 0; i < row_nums; i++) {
+    Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, characters, 64, true)};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+    rids.push_back(row.GetRowId());
+  }
+  size_t pages = table_heap->GetPageCount();
+  ASSERT_GT(pages, 10);
+  // Scenario: delete the first half of the table and every other row of the second half.
+  uint32_t deleted = 0;
+  for (int i = 0; i < row_nums; i++) {
+    if (i < row_nums / 2 || i % 2 == 0) {
+      ASSERT_TRUE(table_heap->MarkDelete(rids[i], nullptr));
+      deleted++;
+    }
+  }
+  EXPECT_EQ(deleted, table_heap->GetDeadTupleCount());
+  // Scenario: vacuum removes every deleted row and frees the pages left empty, the first page stays.
+  uint32_t freed_pages = 0;
+  EXPECT_EQ(deleted, table_heap->Vacuum(&freed_pages));
+  EXPECT_EQ(0, table_heap->GetDeadTupleCount());
+  EXPECT_GT(freed_pages, 0);
+  EXPECT_EQ(pages - freed_pages, table_heap->GetPageCount());
+  EXPECT_FALSE(bpm->IsPageFree(table_heap->GetFirstPageId()));
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+  // Scenario: the remaining rows keep their rids and a scan sees exactly them.
+  for (int i = row_nums / 2 + 1; i < row_nums; i += 2) {
+    Row row(rids[i]);
+    ASSERT_TRUE(table_heap->GetTuple(&row, nullptr));
+    ASSERT_EQ(CmpBool::kTrue, row.GetField(0)->CompareEquals(Field(TypeId::kTypeInt, i)));
+  }
+  int count = 0;
+  for (auto it = table_heap->Begin(nullptr); it != table_heap->End(); ++it) {
+    count++;
+  }
+  EXPECT_EQ(row_nums - static_cast<int>(deleted), count);
+  // Scenario: nothing is left to remove, and the space vacuum gave back is used by new rows.
+  EXPECT_EQ(0, table_heap->Vacuum());
+  pages = table_heap->GetPageCount();
+  for (int i = 0; i < row_nums / 4; i++) {
+    Fields fields{Field(TypeId::kTypeInt, row_nums + i), Field(TypeId::kTypeChar, characters, 64, true)};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+  }
+  EXPECT_EQ(pages, table_heap->GetPageCount());
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+}
+
+TEST(TableHeapTest, ConcurrentInsertTest) {
+  const int num_threads = 4;
+  const int rows_per_thread = 2000;
+  TableHeapTestEnv env("table_heap_concurrent_insert_test.db");
+  TableHeap *table_heap = env.table_heap_;
+  std::vector<std::vector<RowId>> thread_rids(num_threads);
+  std::vector<std::unordered_set<page_id_t>> thread_pages(num_threads);
+  std::vector<std::thread> threads;
+  std::atomic<int> done{0};
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t]() {
+      char characters[64];
+      memset(characters, 'a' + t, sizeof(characters));
+      for (int i = 0; i < rows_per_thread; i++) {
+        Fields fields{Field(TypeId::kTypeInt, t * rows_per_thread + i), Field(TypeId::kTypeChar, characters, 64, true)};
+        Row row(fields);
+        ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+        thread_rids[t].push_back(row.GetRowId());
+        thread_pages[t].insert(row.GetRowId().GetPageId());
+      }
+      // give the page back only once every thread is done, so no thread takes over the page of another
+      done++;
+      while (done < num_threads) {
+        std::this_thread::yield();
+      }
+      table_heap->ReleaseInsertPage();
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  // Scenario: every thread filled pages of its own.
+  for (int t = 0; t < num_threads; t++) {
+    for (int u = t + 1; u < num_threads; u++) {
+      for (auto page_id : thread_pages[t]) {
+        EXPECT_EQ(0, thread_pages[u].count(page_id));
+      }
+    }
+  }
+  // Scenario: all rows are stored once.
+  for (int t = 0; t < num_threads; t++) {
+    for (int i = 0; i < rows_per_thread; i++) {
+      Row row(thread_rids[t][i]);
+      ASSERT_TRUE(table_heap->GetTuple(&row, nullptr));
+      ASSERT_EQ(CmpBool::kTrue, row.GetField(0)->CompareEquals(Field(TypeId::kTypeInt, t * rows_per_thread + i)));
+    }
+  }
+  int count = 0;
+  for (auto it = table_heap->Begin(nullptr); it != table_heap->End(); ++it) {
+    count++;
+  }
+  EXPECT_EQ(num_threads * rows_per_thread, count);
+  // Scenario: a later thread fills the room left in the last pages of the exited threads instead of appending pages.
+  size_t pages = table_heap->GetPageCount();
+  const int later_rows = 10;
+  std::unordered_set<page_id_t> later_pages;
+  std::thread later([&]() {
+    char characters[64];
+    memset(characters, 'z', sizeof(characters));
+    for (int t = 0; t < num_threads; t++) {
+      for (int i = 0; i < later_rows; i++) {
+        Fields fields{Field(TypeId::kTypeInt, -1), Field(TypeId::kTypeChar, characters, 64, true)};
+        Row row(fields);
+        ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+        later_pages.insert(row.GetRowId().GetPageId());
+      }
+      table_heap->ReleaseInsertPage();
+    }
+  });
+  later.join();
+  EXPECT_EQ(pages, table_heap->GetPageCount());
+  for (auto page_id : later_pages) {
+    bool filled_before = false;
+    for (int t = 0; t < num_threads; t++) {
+      filled_before |= thread_pages[t].count(page_id) > 0;
+    }
+    EXPECT_TRUE(filled_before);
+  }
+  EXPECT_TRUE(env.bpm_->CheckAllUnpinned());
+}
+
+TEST(TableHeapTest, PaxLayoutTest) {
+  const int row_nums = 3000;
+  const int int_columns = 8;
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 32, 1, true, false)};
+  for (int k = 0; k < int_columns; k++) {
+    columns.push_back(new Column("c" + std::to_string(k), TypeId::kTypeInt, 2 + k, true, false));
+  }
+  TableHeapTestEnv env("table_heap_pax_layout_test.db", columns, TableLayout::PAX);
+  TableHeap *&table_heap = env.table_heap_;  // follows the heap across Reopen
+  ASSERT_EQ(TableLayout::PAX, table_heap->GetLayout());
+  auto make_fields = [&](int id, const std::string &name) {
+    Fields fields{Field(TypeId::kTypeInt, id)};
+    if (id % 7 == 0) {
+      fields.emplace_back(TypeId::kTypeChar);
+    } else {
+      fields.emplace_back(TypeId::kTypeChar, const_cast<char *>(name.data()), name.size(), true);
+    }
+    for (int k = 0; k < int_columns; k++) {
+      fields.emplace_back(TypeId::kTypeInt, id * k);
+    }
+    return fields;
+  };
+  auto expect_row = [&](const Row &row, int id, const std::string &name) {
+    ASSERT_EQ(CmpBool::kTrue, row.GetField(0)->CompareEquals(Field(TypeId::kTypeInt, id)));
+    if (id % 7 == 0) {
+      ASSERT_TRUE(row.GetField(1)->IsNull());
+    } else {
+      ASSERT_EQ(name, std::string(row.GetField(1)->GetData(), row.GetField(1)->GetLength()));
+    }
+    for (int k = 0; k < int_columns; k++) {
+      ASSERT_EQ(CmpBool::kTrue, row.GetField(2 + k)->CompareEquals(Field(TypeId::kTypeInt, id * k)));
+    }
+  };
+  std::vector<RowId> rids;
+  std::vector<std::string> names;
+  for (int i = 0; i < row_nums; i++) {
+    names.emplace_back(1 + i % 32, static_cast<char>('a' + i % 26));
+    Fields fields = make_fields(i, names[i]);
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+    rids.push_back(row.GetRowId());
+  }
+  // Scenario: tuples read back whole, nulls included.
+  for (int i = 0; i < row_nums; i++) {
+    Row row(rids[i]);
+    ASSERT_TRUE(table_heap->GetTuple(&row, nullptr));
+    expect_row(row, i, names[i]);
+  }
+  // Scenario: a scan of two columns decodes only those, the other fields are null.
+  std::vector<bool> projected(2 + int_columns, false);
+  projected[0] = projected[5] = true;
+  int count = 0;
+  for (auto it = table_heap->Begin(nullptr, nullptr, &projected); it != table_heap->End(); ++it) {
+    ASSERT_EQ(CmpBool::kTrue, it->GetField(0)->CompareEquals(Field(TypeId::kTypeInt, count)));
+    ASSERT_EQ(CmpBool::kTrue, it->GetField(5)->CompareEquals(Field(TypeId::kTypeInt, count * 3)));
+    ASSERT_TRUE(it->GetField(1)->IsNull());
+    ASSERT_TRUE(it->GetField(2)->IsNull());
+    count++;
+  }
+  EXPECT_EQ(row_nums, count);
+  // Scenario: updates keep the rid, also when the char grows and the page has to reclaim replaced values.
+  for (int i = 1; i < row_nums; i += 3) {
+    names[i] = std::string(32, 'z');
+    Fields fields = make_fields(i, names[i]);
+    ASSERT_TRUE(table_heap->UpdateTuple(Row(fields), rids[i], nullptr));
+  }
+  for (int i = 0; i < row_nums; i++) {
+    Row row(rids[i]);
+    ASSERT_TRUE(table_heap->GetTuple(&row, nullptr));
+    expect_row(row, i, names[i]);
+  }
+  // Scenario: deleted tuples are vacuumed and their slots are used again.
+  size_t pages = table_heap->GetPageCount();
+  for (int i = 0; i < row_nums; i += 2) {
+    ASSERT_TRUE(table_heap->MarkDelete(rids[i], nullptr));
+  }
+  EXPECT_EQ(row_nums / 2, table_heap->Vacuum());
+  for (int i = 0; i < row_nums / 2; i++) {
+    Fields fields = make_fields(row_nums + i, names[i]);
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+  }
+  EXPECT_EQ(pages, table_heap->GetPageCount());
+  // Scenario: the heap opens again with its layout.
+  env.Reopen();
+  ASSERT_EQ(TableLayout::PAX, table_heap->GetLayout());
+  for (int i = 1; i < row_nums; i += 2) {
+    Row row(rids[i]);
+    ASSERT_TRUE(table_heap->GetTuple(&row, nullptr));
+    expect_row(row, i, names[i]);
+  }
+  EXPECT_TRUE(env.bpm_->CheckAllUnpinned());
+}
+
+TEST(TableHeapTest, DictionaryTest) {
+  const int row_nums = 2000;
+  const int distinct = DICTIONARY_MAX_CODES + 50;
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("status", TypeId::kTypeChar, 128, 1, true, false)};
+  columns[1]->SetDictionaryEncoded(true);
+  TableHeapTestEnv env("table_heap_dictionary_test.db", columns);
+  TableHeap *&table_heap = env.table_heap_;  // follows the heap across Reopen
+  ASSERT_NE(INVALID_PAGE_ID, table_heap->GetDictionaryPageId());
+  // the first values get codes, the ones after the dictionary is full and the long ones stay inline
+  auto status_of = [&](int id) {
+    if (id % 11 == 0) {
+      return std::string(DICTIONARY_MAX_VALUE_LEN + 1 + id % 7, 'l');
+    }
+    return "status-" + std::to_string(id % distinct);
+  };
+  std::vector<RowId> rids;
+  for (int i = 0; i < row_nums; i++) {
+    std::string status = status_of(i);
+    Fields fields{Field(TypeId::kTypeInt, i)};
+    if (i % 13 == 0) {
+      fields.emplace_back(TypeId::kTypeChar);
+    } else {
+      fields.emplace_back(TypeId::kTypeChar, const_cast<char *>(status.data()), status.size(), true);
+    }
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+    rids.push_back(row.GetRowId());
+  }
+  auto expect_status = [&](const Row &row, int id) {
+    if (id % 13 == 0) {
+      ASSERT_TRUE(row.GetField(1)->IsNull());
+    } else {
+      ASSERT_EQ(status_of(id), std::string(row.GetField(1)->GetData(), row.GetField(1)->GetLength()));
+    }
+  };
+  // Scenario: tuples hold codes that decode to the inserted values, codes go to values in insertion order.
+  std::unordered_set<std::string> coded_values;
+  for (int i = 0; i < row_nums; i++) {
+    Row row(rids[i]);
+    ASSERT_TRUE(table_heap->GetTuple(&row, nullptr));
+    bool codable = i % 13 != 0 && i % 11 != 0;
+    if (codable && coded_values.size() < DICTIONARY_MAX_CODES) {
+      coded_values.insert(status_of(i));
+    }
+    ASSERT_EQ(codable && coded_values.count(status_of(i)) > 0, row.GetField(1)->IsCoded());
+    ASSERT_TRUE(table_heap->LoadExternalFields(row));
+    expect_status(row, i);
+  }
+  // Scenario: equality is decided on codes, a value without a code only matches the values stored inline.
+  std::string known = "status-1", unknown = "status-" + std::to_string(distinct - 1);
+  uint32_t code;
+  ASSERT_TRUE(table_heap->FindCode(1, Field(TypeId::kTypeChar, const_cast<char *>(known.data()), known.size(), false),
+                                   &code));
+  ASSERT_FALSE(table_heap->FindCode(
+      1, Field(TypeId::kTypeChar, const_cast<char *>(unknown.data()), unknown.size(), false), &code));
+  Field coded_known(TypeId::kTypeChar, DictionaryCode{code});
+  Field inline_unknown(TypeId::kTypeChar, const_cast<char *>(unknown.data()), unknown.size(), false);
+  int known_count = 0, unknown_count = 0;
+  for (auto it = table_heap->Begin(nullptr); it != table_heap->End(); ++it) {
+    Field *status = it->GetField(1);
+    known_count += status->CompareEquals(coded_known) == CmpBool::kTrue;
+    unknown_count += status->CompareEquals(inline_unknown) == CmpBool::kTrue;
+  }
+  int expected_known = 0, expected_unknown = 0;
+  for (int i = 0; i < row_nums; i++) {
+    expected_known += i % 13 != 0 && status_of(i) == known;
+    expected_unknown += i % 13 != 0 && status_of(i) == unknown;
+  }
+  EXPECT_EQ(expected_known, known_count);
+  EXPECT_EQ(expected_unknown, unknown_count);
+  // Scenario: an update that changes the value stores the code of the new one.
+  std::string pending = "status-2";
+  Fields fields{Field(TypeId::kTypeInt, 1),
+                Field(TypeId::kTypeChar, const_cast<char *>(pending.data()), pending.size(), true)};
+  ASSERT_TRUE(table_heap->UpdateTuple(Row(fields), rids[1], nullptr));
+  // Scenario: the dictionary is read back when the heap opens again.
+  env.Reopen();
+  for (int i = 0; i < row_nums; i++) {
+    Row row(rids[i]);
+    ASSERT_TRUE(table_heap->GetTuple(&row, nullptr));
+    ASSERT_TRUE(table_heap->LoadExternalFields(row));
+    if (i == 1) {
+      ASSERT_EQ(pending, std::string(row.GetField(1)->GetData(), row.GetField(1)->GetLength()));
+    } else {
+      expect_status(row, i);
+    }
+  }
+  EXPECT_TRUE(env.bpm_->CheckAllUnpinned());
+}
+
+TEST(TableHeapTest, ZoneMapTest) {
+  const int row_nums = 5000;
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("score", TypeId::kTypeFloat, 1, true, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 2, true, false)};
+  TableHeapTestEnv env("table_heap_zone_map_test.db", columns);
+  TableHeap *&table_heap = env.table_heap_;  // follows the heap across Reopen
+  BufferPoolManager *bpm = env.bpm_;
+  ASSERT_TRUE(table_heap->HasZoneMap());
+  char characters[64];
+  memset(characters, 'x', sizeof(characters));
+  std::vector<RowId> rids;
+  for (int i = 0; i < row_nums; i++) {
+    Fields fields{Field(TypeId::kTypeInt, i),
+                  i % 100 == 0 ? Field(TypeId::kTypeFloat) : Field(TypeId::kTypeFloat, static_cast<float>(i) / 2),
+                  Field(TypeId::kTypeChar, characters, 64, true)};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+    rids.push_back(row.GetRowId());
+  }
+  // Scenario: the summary of a page admits its own values and rules out those of other pages.
+  page_id_t middle_page_id = rids[row_nums / 2].GetPageId();
+  for (int i = 0; i < row_nums; i++) {
+    bool on_page = rids[i].GetPageId() == middle_page_id;
+    EXPECT_EQ(on_page, table_heap->MayMatch(middle_page_id, 0, "=", Field(TypeId::kTypeInt, i)));
+  }
+  EXPECT_FALSE(table_heap->MayMatch(middle_page_id, 1, ">", Field(TypeId::kTypeFloat, static_cast<float>(row_nums))));
+  EXPECT_TRUE(table_heap->MayMatch(middle_page_id, 1, "<", Field(TypeId::kTypeFloat, static_cast<float>(row_nums))));
+  EXPECT_TRUE(table_heap->MayMatch(middle_page_id, 0, "=", Field(TypeId::kTypeChar, characters, 1, true)));
+  // Scenario: a filtered scan reads only the pages that may hold matching tuples.
+  const int from = row_nums - 100;
+  PageFilter filter = [&](page_id_t page_id) {
+    return table_heap->MayMatch(page_id, 0, ">=", Field(TypeId::kTypeInt, from));
+  };
+  size_t pages = table_heap->GetPageCount();
+  BufferPoolStats before = bpm->GetStats();
+  int count = 0;
+  for (auto it = table_heap->Begin(nullptr, nullptr, nullptr, &filter); it != table_heap->End(); ++it) {
+    int32_t id;
+    it->GetField(0)->SerializeTo(reinterpret_cast<char *>(&id));
+    if (id >= from) {
+      count++;
+    }
+  }
+  BufferPoolStats after = bpm->GetStats();
+  EXPECT_EQ(100, count);
+  EXPECT_LE(after.hits_ + after.misses_ - before.hits_ - before.misses_, pages / 10);
+  // Scenario: vacuum narrows the summary of a page to the tuples left in it.
+  int last_on_page = row_nums / 2;
+  while (last_on_page + 1 < row_nums && rids[last_on_page + 1].GetPageId() == middle_page_id) {
+    last_on_page++;
+  }
+  ASSERT_TRUE(table_heap->MarkDelete(rids[last_on_page], nullptr));
+  EXPECT_TRUE(table_heap->MayMatch(middle_page_id, 0, "=", Field(TypeId::kTypeInt, last_on_page)));
+  EXPECT_EQ(1, table_heap->Vacuum());
+  EXPECT_FALSE(table_heap->MayMatch(middle_page_id, 0, "=", Field(TypeId::kTypeInt, last_on_page)));
+  EXPECT_TRUE(table_heap->MayMatch(middle_page_id, 0, "=", Field(TypeId::kTypeInt, last_on_page - 1)));
+  // Scenario: the zone map is found again after reopening the table.
+  ASSERT_NE(INVALID_PAGE_ID, table_heap->GetZoneMapPageId());
+  env.Reopen();
+  EXPECT_FALSE(table_heap->MayMatch(middle_page_id, 0, "=", Field(TypeId::kTypeInt, last_on_page)));
+  EXPECT_TRUE(table_heap->MayMatch(middle_page_id, 0, "=", Field(TypeId::kTypeInt, last_on_page - 1)));
+  EXPECT_FALSE(table_heap->MayMatch(middle_page_id, 0, "<", Field(TypeId::kTypeInt, 0)));
+  count = 0;
+  for (auto it = table_heap->Begin(nullptr, nullptr, nullptr, &filter); it != table_heap->End(); ++it) {
+    count++;
+  }
+  EXPECT_LT(count, 200);
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+}
+
+TEST(TableHeapTest, ZoneMapRecoveryTest) {
+  // so many columns that a map page holds the summaries of a single heap page
+  const int column_nums = 300;
+  std::vector<Column *> columns;
+  for (int c = 0; c < column_nums; c++) {
+    columns.push_back(new Column("c" + std::to_string(c), TypeId::kTypeInt, c, false, false));
+  }
+  TableHeapTestEnv env("table_heap_zone_map_recovery_test.db", columns, TableLayout::ROW, 16);
+  TableHeap *&table_heap = env.table_heap_;  // follows the heap across Reopen
+  BufferPoolManager *bpm = env.bpm_;
+  ASSERT_TRUE(table_heap->HasZoneMap());
+  std::vector<RowId> rids;
+  auto insert = [&](TableHeap *heap, int id) {
+    Fields fields;
+    for (int c = 0; c < column_nums; c++) {
+      fields.emplace_back(TypeId::kTypeInt, id);
+    }
+    Row row(fields);
+    ASSERT_TRUE(heap->InsertTuple(row, nullptr));
+    rids.push_back(row.GetRowId());
+  };
+  auto count_from = [&](TableHeap *heap, int from) {
+    PageFilter filter = [&](page_id_t page_id) {
+      return heap->MayMatch(page_id, 0, ">=", Field(TypeId::kTypeInt, from));
+    };
+    int count = 0;
+    for (auto it = heap->Begin(nullptr, nullptr, nullptr, &filter); it != heap->End(); ++it) {
+      int32_t id;
+      it->GetField(0)->SerializeTo(reinterpret_cast<char *>(&id));
+      count += id >= from ? 1 : 0;
+    }
+    return count;
+  };
+  // Scenario: the summaries of a heap spread over many map pages.
+  for (int i = 0; i < 60; i++) {
+    insert(table_heap, i);
+  }
+  ASSERT_GT(table_heap->GetPageCount(), 10);
+  for (int i = 0; i < 60; i++) {
+    EXPECT_TRUE(table_heap->MayMatch(rids[i].GetPageId(), 0, "=", Field(TypeId::kTypeInt, i)));
+    EXPECT_FALSE(table_heap->MayMatch(rids[i].GetPageId(), 0, "=", Field(TypeId::kTypeInt, (i + 30) % 60)));
+  }
+  EXPECT_EQ(10, count_from(table_heap, 50));
+  // Scenario: a heap page that gets no map page turns the map off instead of being skipped by scans.
+  std::vector<page_id_t> pinned;
+  page_id_t page_id;
+  while (bpm->NewPage(page_id) != nullptr) {
+    pinned.push_back(page_id);
+  }
+  for (int k = 0; k < 2; k++) {
+    bpm->UnpinPage(pinned.back(), false);
+    bpm->DeletePage(pinned.back());
+    pinned.pop_back();
+  }
+  size_t pages = table_heap->GetPageCount();
+  int next_id = 60;
+  while (table_heap->GetPageCount() == pages) {
+    insert(table_heap, next_id++);
+  }
+  for (auto id : pinned) {
+    bpm->UnpinPage(id, false);
+    bpm->DeletePage(id);
+  }
+  page_id_t new_page_id = rids.back().GetPageId();
+  EXPECT_TRUE(table_heap->MayMatch(new_page_id, 0, "=", Field(TypeId::kTypeInt, 0)));
+  EXPECT_TRUE(table_heap->MayMatch(rids[0].GetPageId(), 0, "=", Field(TypeId::kTypeInt, 59)));
+  EXPECT_EQ(next_id - 60, count_from(table_heap, 60));
+  // Scenario: a map that was turned off is rebuilt when the table is opened again.
+  env.Reopen();
+  EXPECT_FALSE(table_heap->MayMatch(new_page_id, 0, "=", Field(TypeId::kTypeInt, 0)));
+  EXPECT_TRUE(table_heap->MayMatch(new_page_id, 0, "=", Field(TypeId::kTypeInt, next_id - 1)));
+  EXPECT_EQ(next_id - 60, count_from(table_heap, 60));
+  // Scenario: rows inserted after a clean open are not hidden by the map on disk if the table is not closed.
+  env.Reopen();
+  for (int i = 0; i < 10; i++) {
+    insert(table_heap, 1000 + i);
+  }
+  bpm->FlushAllPages();
+  TableHeap *reopened = env.Open();
+  EXPECT_TRUE(reopened->MayMatch(rids[rids.size() - 10].GetPageId(), 0, "=", Field(TypeId::kTypeInt, 1000)));
+  EXPECT_TRUE(reopened->MayMatch(rids.back().GetPageId(), 0, "=", Field(TypeId::kTypeInt, 1009)));
+  EXPECT_EQ(10, count_from(reopened, 1000));
+  delete reopened;
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+}